@@ -0,0 +1,126 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with
+* Custom Classes, Mulithreading, & OpenGL
+*
+* Description:
+* Anti-aliasing modes. MSAA multiplies the color and depth storage and
+* the bandwidth of every pixel by the sample count; FXAA instead draws the
+* scene once per pixel and smooths the edges in one post-process pass
+* over the resolved frame (FXAA.fragmentshader).
+*
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// include GLEW
+#include <GL/glew.h>
+
+using namespace std;
+
+#include "antialiasing.hpp"
+#include "shaderpermutations.hpp"
+
+/* AntiAliasingName - command line name of each mode */
+struct AntiAliasingName
+{
+	AntiAliasingMode mode;
+	const char* name;
+	int samples;
+};
+
+const AntiAliasingName antiAliasingNames[] =
+{
+	{ AA_NONE, "none", 1 },
+	{ AA_MSAA2, "msaa2", 2 },
+	{ AA_MSAA4, "msaa4", 4 },
+	{ AA_MSAA8, "msaa8", 8 },
+	{ AA_FXAA, "fxaa", 1 }
+};
+
+bool parseAntiAliasingMode(const char* name, AntiAliasingMode& mode)
+{
+	for (const auto& entry : antiAliasingNames)
+	{
+		if (strcmp(name, entry.name) == 0)
+		{
+			mode = entry.mode;
+			return true;
+		}
+	}
+	return false;
+} // end parseAntiAliasingMode method
+
+const char* antiAliasingModeName(AntiAliasingMode mode)
+{
+	return antiAliasingNames[mode].name;
+} // end antiAliasingModeName method
+
+int antiAliasingSamples(AntiAliasingMode mode)
+{
+	return antiAliasingNames[mode].samples;
+} // end antiAliasingSamples method
+
+/*
+***********************************************
+*		FXAAFilter
+***********************************************
+*/
+bool FXAAFilter::init(const char* vertexPath, const char* fragmentPath)
+{
+	programID = LoadShadersWithDefines(vertexPath, fragmentPath, {});
+	if (programID == 0)
+	{
+		fprintf(stderr, "FXAA: the filter program failed to build\n");
+		return false;
+	}
+	textureID = glGetUniformLocation(programID, "sourceTexture");
+	texelSizeID = glGetUniformLocation(programID, "texelSize");
+	uvScaleID = glGetUniformLocation(programID, "uvScale");
+	glGenVertexArrays(1, &vertexArray);
+	return true;
+} // end init method
+
+void FXAAFilter::apply(GLuint texture, int drawnWidth, int drawnHeight, int textureWidth, int textureHeight) const
+{
+	// every pixel is overwritten, nothing to test against
+	GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+	glDisable(GL_DEPTH_TEST);
+	GLint previousProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+
+	glUseProgram(programID);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glUniform1i(textureID, 0);
+	glUniform2f(texelSizeID, 1.0f / textureWidth, 1.0f / textureHeight);
+	glUniform2f(uvScaleID, (float)drawnWidth / textureWidth, (float)drawnHeight / textureHeight);
+	glBindVertexArray(vertexArray);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glUseProgram(previousProgram);
+
+	if (depthTest)
+	{
+		glEnable(GL_DEPTH_TEST);
+	}
+} // end apply method
+
+void FXAAFilter::cleanup()
+{
+	glDeleteProgram(programID);
+	glDeleteVertexArrays(1, &vertexArray);
+	programID = 0;
+	vertexArray = 0;
+} // end cleanup method
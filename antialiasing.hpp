@@ -0,0 +1,42 @@
+#ifndef ANTIALIASING_HPP
+#define ANTIALIASING_HPP
+
+/* ways the scene can be anti-aliased */
+enum AntiAliasingMode
+{
+	AA_NONE,	// one sample per pixel, no filter
+	AA_MSAA2,	// multisampling with 2, 4 or 8 samples per pixel
+	AA_MSAA4,
+	AA_MSAA8,
+	AA_FXAA		// one sample per pixel, then a single edge-smoothing pass over the resolved frame
+};
+
+// mode for a command line name (none, msaa2, msaa4, msaa8, fxaa); false if the name is unknown
+bool parseAntiAliasingMode(const char* name, AntiAliasingMode& mode);
+const char* antiAliasingModeName(AntiAliasingMode mode);
+// samples per pixel of the scene target (1 unless multisampled)
+int antiAliasingSamples(AntiAliasingMode mode);
+
+/* FXAAFilter - fast approximate anti-aliasing: one full-screen pass that finds edges from the luma of
+   each pixel's neighbours and blends along them, reading a single-sampled color texture */
+class FXAAFilter
+{
+public:
+	// compile the filter program
+	bool init(const char* vertexPath, const char* fragmentPath);
+	// filter the lower-left drawnWidth x drawnHeight corner of a textureWidth x textureHeight texture
+	// over the bound framebuffer's whole viewport (stretching it if the viewport is larger)
+	void apply(GLuint texture, int drawnWidth, int drawnHeight, int textureWidth, int textureHeight) const;
+	// release GL objects
+	void cleanup();
+
+private:
+	GLuint programID = 0;
+	// the full-screen triangle is generated from gl_VertexID, but a core context needs a vertex array bound
+	GLuint vertexArray = 0;
+	GLint textureID = -1;
+	GLint texelSizeID = -1;
+	GLint uvScaleID = -1;
+};
+
+#endif
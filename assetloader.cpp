@@ -0,0 +1,115 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Asynchronous asset loading. Every .obj file is parsed, indexed, has
+* its fixed rotation baked in and is given its collision tree on its own
+* job, and every DDS layer is read on its own job, all at the same time.
+* Nothing here touches OpenGL: the render thread polls for finished
+* assets each frame and uploads them itself, so the first frames show a
+* placeholder scene instead of waiting for the slowest file.
+* 
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <vector>
+#include <deque>
+#include <string>
+
+// include GLEW
+#include <GL/glew.h>
+
+// include GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+
+using namespace glm;
+using namespace std;
+
+#include "assetloader.hpp"
+#include "objparser.hpp"
+#include "vertexindexer.hpp"
+
+/*
+***********************************************
+*		Decoding
+***********************************************
+*/
+size_t AssetLoader::loadMesh(const char* path, bool collisionShape, const quat& bakedRotation)
+{
+	meshes.emplace_back();
+	MeshAsset* mesh = &meshes.back();
+	mesh->path = path;
+	mesh->collisionShape = collisionShape;
+	mesh->bakedRotation = bakedRotation;
+	jobs.run([mesh]
+	{
+		vector<vec3> vertices;
+		vector<vec2> uvs;
+		vector<vec3> normals;
+		mesh->loaded = parseOBJ(mesh->path.c_str(), vertices, uvs, normals);
+		indexVerticesParallel(vertices, uvs, normals, mesh->indices, mesh->vertices, mesh->uvs, mesh->normals);
+		for (size_t i = 0; i < mesh->vertices.size(); i++)
+		{
+			mesh->vertices[i] = mesh->bakedRotation * mesh->vertices[i];
+			mesh->normals[i] = mesh->bakedRotation * mesh->normals[i];
+		}
+		if (mesh->collisionShape && mesh->loaded)
+		{
+			loadOrBuildMeshBVH(mesh->shape, mesh->path.c_str(), mesh->vertices, mesh->indices);
+		}
+	}, mesh->decoded);
+	return meshes.size() - 1;
+} // end loadMesh method
+
+void AssetLoader::loadTextureArray(const vector<string>& paths)
+{
+	texturePaths = paths;
+	textureLayers.resize(paths.size());
+	textureValid.assign(paths.size(), 0);
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		jobs.run([this, i] { textureValid[i] = readDDS(texturePaths[i].c_str(), textureLayers[i]); }, textureReading);
+	}
+} // end loadTextureArray method
+
+void AssetLoader::wait()
+{
+	for (auto& mesh : meshes)
+	{
+		jobs.wait(mesh.decoded);
+	}
+	jobs.wait(textureReading);
+} // end wait method
+
+/*
+***********************************************
+*		Upload
+***********************************************
+*/
+GLuint AssetLoader::uploadTextures()
+{
+	for (size_t i = 0; i < texturePaths.size(); i++)
+	{
+		if (!textureValid[i])
+		{
+			printf("%s is not a valid DDS file.\n", texturePaths[i].c_str());
+			return 0;
+		}
+	}
+	GLuint textureID = uploadDDSArray(textureLayers, texturePaths);
+	// the pixel buffer has its own copy, the decoded layers are no longer needed
+	vector<DDSImage>().swap(textureLayers);
+	return textureID;
+} // end uploadTextures method
@@ -0,0 +1,61 @@
+#ifndef ASSETLOADER_HPP
+#define ASSETLOADER_HPP
+
+#include <vector>
+#include <deque>
+#include <string>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include "jobsystem.hpp"
+#include "meshbvh.hpp"
+#include "texturearray.hpp"
+
+/* MeshAsset - one .obj read and indexed on a worker, ready for IndirectRenderer::addMesh */
+struct MeshAsset
+{
+	std::string path;
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	std::vector<unsigned short> indices;
+	MeshBVH shape;				// collision tree, empty unless requested
+	glm::quat bakedRotation;	// already applied to the vertices and normals (and so to the tree)
+	bool collisionShape = false;
+	bool loaded = false;		// false when the file could not be read
+	JobCounter decoded;
+};
+
+/* AssetLoader - reads meshes and textures on the job system while the render thread keeps drawing;
+   the render thread polls it and does the GL uploads itself */
+class AssetLoader
+{
+public:
+	~AssetLoader() { wait(); }
+
+	// queue an .obj to be read and indexed, plus its collision BVH when collisionShape is set; returns the mesh index.
+	// bakedRotation turns the vertices and normals once, for meshes that are always drawn with a fixed rotation
+	size_t loadMesh(const char* path, bool collisionShape,
+		const glm::quat& bakedRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+	// queue the DDS layers of the scene's texture array, one job per file (one array per loader)
+	void loadTextureArray(const std::vector<std::string>& paths);
+
+	// decoded: safe to read from any thread from now on
+	bool meshReady(size_t i) const { return meshes[i].decoded.done(); }
+	const MeshAsset& mesh(size_t i) const { return meshes[i]; }
+	bool texturesReady() const { return textureReading.done(); }
+	// GL thread, once texturesReady(): upload the layers through a pixel buffer and free them; 0 if a layer failed
+	GLuint uploadTextures();
+
+	// block until everything queued has been decoded, running jobs meanwhile
+	void wait();
+
+private:
+	std::deque<MeshAsset> meshes;		// a deque never moves its elements, the jobs keep pointers into it
+	std::vector<std::string> texturePaths;
+	std::vector<DDSImage> textureLayers;
+	std::vector<unsigned char> textureValid;
+	JobCounter textureReading;
+};
+
+#endif
@@ -0,0 +1,141 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Headless batch runs. K copies of the scene's physics are built from the
+* scene once its meshes have loaded and are stepped tick by tick, every
+* store on its own job, with no window, rendering or frame pacing in the
+* way; the mesh trees are read-only while stepping, so one copy of them
+* serves every world. The run prints the aggregate ticks per second.
+* 
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+// include GLEW
+#include <GL/glew.h>
+
+// include GLM
+#include <glm/glm.hpp>
+
+using namespace glm;
+using namespace std;
+
+// movers a packed store is filled up to: plenty to fill the SIMD lanes, while the impact loop, which walks
+// every pair of the store for each impact it resolves, stays about as short as a single world's
+const size_t packedStoreMovers = 64;
+
+#include "batchrunner.hpp"
+#include "jobsystem.hpp"
+#include "scene.hpp"
+
+/*
+***********************************************
+*		Batch Runner
+***********************************************
+*/
+void BatchRunner::init(const Scene& scene, const vector<const MeshBVH*>& shapes, const WorldBounds& bounds,
+	size_t worlds, bool packed)
+{
+	worldCount = worlds;
+	// packed: as many worlds to a store as fit in packedStoreMovers (at least one), dealt out evenly
+	size_t worldsPerStore = packed ? std::max((size_t)1, packedStoreMovers / std::max(scene.moverCount(), (size_t)1)) : 1;
+	size_t storeTotal = (worldCount + worldsPerStore - 1) / worldsPerStore;
+	stores.clear();
+	stores.resize(storeTotal);
+	for (size_t s = 0; s < storeTotal; s++)
+	{
+		MoverArrays& store = stores[s];
+		store.bounds = bounds;
+		// a different seed per store, so the worlds do not all roll the same motion
+		store.random.seed((unsigned int)s + 1);
+		size_t firstWorld = s * worldCount / storeTotal;
+		size_t lastWorld = (s + 1) * worldCount / storeTotal;
+		for (size_t w = firstWorld; w < lastWorld; w++)
+		{
+			if (packed)
+			{
+				store.beginGroup();
+			}
+			scene.addMovers(store, shapes);
+		}
+	}
+} // end init method
+
+void BatchRunner::step(float time, float tick, bool driven)
+{
+	jobs.parallelFor(stores.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t s = begin; s < end; s++)
+		{
+			stepPhysics(stores[s], time, tick, driven);
+		}
+	});
+} // end step method
+
+size_t BatchRunner::movers() const
+{
+	size_t total = 0;
+	for (const MoverArrays& store : stores)
+	{
+		total += store.size();
+	}
+	return total;
+} // end movers method
+
+size_t BatchRunner::awake() const
+{
+	size_t total = 0;
+	for (const MoverArrays& store : stores)
+	{
+		total += store.awake.size();
+	}
+	return total;
+} // end awake method
+
+/*
+***********************************************
+*		Batch Run
+***********************************************
+*/
+void runBatch(const Scene& scene, const vector<const MeshBVH*>& shapes, const WorldBounds& bounds,
+	size_t worldCount, unsigned long long ticks, float tick, bool packed)
+{
+	BatchRunner batch;
+	batch.init(scene, shapes, bounds, worldCount, packed);
+	printf("Batch: %zu worlds of %zu moving objects, %s into %zu stores, %s kernels\n", batch.worlds(),
+		scene.moverCount(), packed ? "packed" : "one each", batch.storeCount(), physicsKernelName(physicsKernel()));
+
+	// the objects follow their waveforms the whole run, as after 'g'
+	float time = 0.0f;
+	double slowestTick = 0.0;
+	auto start = chrono::steady_clock::now();
+	auto previous = start;
+	for (unsigned long long t = 0; t < ticks; t++)
+	{
+		batch.step(time, tick, true);
+		time += tick;
+		auto now = chrono::steady_clock::now();
+		slowestTick = std::max(slowestTick, chrono::duration<double>(now - previous).count());
+		previous = now;
+	}
+	double seconds = chrono::duration<double>(previous - start).count();
+	double worldTicks = (double)ticks * (double)batch.worlds();
+	printf("Batch: %llu ticks in %.3f s, %.0f ticks/s per world, %.0f world ticks/s, %.3g mover ticks/s\n",
+		ticks, seconds, (double)ticks / seconds, worldTicks / seconds, worldTicks * (double)scene.moverCount() / seconds);
+	printf("Batch: %.3f ms per tick on average, %.3f ms at worst, %zu of %zu movers awake at the end\n",
+		seconds * 1000.0 / (double)std::max(ticks, 1ULL), slowestTick * 1000.0, batch.awake(), batch.movers());
+} // end runBatch method
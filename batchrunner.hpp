@@ -0,0 +1,38 @@
+#ifndef BATCHRUNNER_HPP
+#define BATCHRUNNER_HPP
+
+#include <vector>
+
+#include "physics.hpp"
+
+class Scene;
+
+/* BatchRunner - many independent copies of a scene's physics stepped in lockstep on the job system, with no
+   window; every world starts from the scene's layout with its own random motion, and all of them collide
+   with the same immutable mesh trees. Worlds either get a store each, or several small worlds are packed as
+   groups into one store so the SIMD passes run across worlds instead of only across the few movers of one */
+class BatchRunner
+{
+public:
+	// build worldCount worlds of the scene's movers inside bounds; shapes[mesh] is shared by every world
+	void init(const Scene& scene, const std::vector<const MeshBVH*>& shapes, const WorldBounds& bounds,
+		size_t worldCount, bool packed);
+	// one tick of every world, the stores stepping in parallel; returns once all of them have finished it
+	void step(float time, float tick, bool driven);
+
+	size_t worlds() const { return worldCount; }
+	size_t storeCount() const { return stores.size(); }
+	// movers in every world together, and how many of them are awake after the last step
+	size_t movers() const;
+	size_t awake() const;
+
+private:
+	std::vector<MoverArrays> stores;
+	size_t worldCount = 0;
+};
+
+// step worldCount copies of the scene for ticks ticks of tick seconds and print the aggregate ticks per second
+void runBatch(const Scene& scene, const std::vector<const MeshBVH*>& shapes, const WorldBounds& bounds,
+	size_t worldCount, unsigned long long ticks, float tick, bool packed);
+
+#endif
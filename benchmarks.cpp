@@ -0,0 +1,697 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Offscreen and CPU benchmarks started from the command line (see main.cpp).
+* 
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <math.h>
+
+// include GLEW
+#include <GL/glew.h>
+
+// include GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <common/objloader.hpp>
+#include <common/vboindexer.hpp>
+
+using namespace glm;
+using namespace std;
+
+#include "benchmarks.hpp"
+#include "indirectdraw.hpp"
+#include "shaderpermutations.hpp"
+#include "clusteredlights.hpp"
+#include "physics.hpp"
+#include "jobsystem.hpp"
+#include "objparser.hpp"
+#include "vertexindexer.hpp"
+#include "antialiasing.hpp"
+#include "dynamicresolution.hpp"
+
+/*
+***********************************************
+*		Fill-Rate Benchmark
+***********************************************
+*/
+// 4K target
+const GLsizei fillWidth = 3840, fillHeight = 2160;
+// full-screen layers drawn per frame (overdraw)
+const int fillLayers = 16;
+// frames timed per permutation
+const int fillFrames = 20;
+
+/* FillRateVariant - one permutation measured by the benchmark */
+struct FillRateVariant
+{
+	const char* name;
+	unsigned int features;
+};
+
+/* time full-screen overdraw of every permutation into a 4K offscreen framebuffer */
+void runFillRateBenchmark(ShaderPermutations& shaders, IndirectRenderer& renderer, ClusteredLights& lights,
+	GLuint quadMesh, GLuint sceneTextures)
+{
+	const FillRateVariant variants[] =
+	{
+		{ "reference (per-fragment sin/pow)", SHADER_LIGHTING | SHADER_SPECULAR | SHADER_INTERNAL_LIGHT | SHADER_PER_FRAGMENT_REFERENCE },
+		{ "lighting + specular + internal", SHADER_LIGHTING | SHADER_SPECULAR | SHADER_INTERNAL_LIGHT },
+		{ "lighting + internal", SHADER_LIGHTING | SHADER_INTERNAL_LIGHT },
+		{ "internal light only", SHADER_INTERNAL_LIGHT },
+		{ "unlit", 0 }
+	};
+
+	// offscreen 4K color + depth target
+	GLuint framebuffer, colorBuffer, depthBuffer;
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, fillWidth, fillHeight);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, fillWidth, fillHeight);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		fprintf(stderr, "Fill-rate benchmark: 4K framebuffer is incomplete\n");
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return;
+	}
+	glViewport(0, 0, fillWidth, fillHeight);
+
+	// stretch the quad over the whole of clip space, every layer covers every pixel
+	const MeshRange& quad = renderer.mesh(quadMesh);
+	float quadRadius = quad.boundingSphere.w;
+	EntityInstance layer = {};
+	layer.model = scale(mat4(1.0f), vec3(2.5f / quadRadius, 2.5f / quadRadius, 1.0f));
+	layer.meshID = quadMesh;
+	FrameArena benchArena;
+	benchArena.init(fillLayers * sizeof(EntityInstance));
+	EntityList layers(fillLayers, layer, FrameAllocator<EntityInstance>(benchArena));
+
+	// every fragment is shaded: no depth rejection between the layers
+	glDisable(GL_DEPTH_TEST);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, sceneTextures);
+
+	// one light in front of the quad whose radius covers every cluster, like the original single light
+	vector<PointLight> benchLights = { { vec3(0.0f, 0.0f, 1.0f), 100.0f, vec3(1.0f, 1.0f, 1.0f), 70.0f } };
+	mat4 identity = mat4(1.0f);
+	lights.update(benchLights, identity, identity);
+
+	GLuint timerQuery;
+	glGenQueries(1, &timerQuery);
+	double pixelsPerFrame = double(fillWidth) * double(fillHeight) * fillLayers;
+	printf("Fill-rate benchmark: %dx%d, %d full-screen layers, %d frames per variant\n",
+		fillWidth, fillHeight, fillLayers, fillFrames);
+
+	for (const auto& variant : variants)
+	{
+		// vertex decoding has to match the format the renderer stored the quad in
+		GLuint programID = shaders.get(variant.features | (renderer.compressedVertices() ? SHADER_COMPRESSED_VERTICES : 0));
+		if (programID == 0)
+		{
+			continue;
+		}
+		glUseProgram(programID);
+		glUniformMatrix4fv(glGetUniformLocation(programID, "VP"), 1, GL_FALSE, &identity[0][0]);
+		glUniformMatrix4fv(glGetUniformLocation(programID, "V"), 1, GL_FALSE, &identity[0][0]);
+		glUniform1f(glGetUniformLocation(programID, "diffuseIntensity"), 1.0f);
+		glUniform3f(glGetUniformLocation(programID, "specularMaterialIntensity"), 0.3f, 0.3f, 0.3f);
+		lights.bind(programID, fillWidth, fillHeight);
+		glUniform1f(glGetUniformLocation(programID, "internalLightIntensity"), 0.5f);
+		glUniform1f(glGetUniformLocation(programID, "time"), 0.0f);
+		glUniform1i(glGetUniformLocation(programID, "myTextureSampler"), 0);
+
+		// warm up once so compilation and allocation are not timed
+		renderer.draw(layers, identity);
+		glFinish();
+
+		GLuint64 totalNanoseconds = 0;
+		for (int frame = 0; frame < fillFrames; frame++)
+		{
+			glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			renderer.draw(layers, identity);
+			glEndQuery(GL_TIME_ELAPSED);
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &elapsed);
+			totalNanoseconds += elapsed;
+		}
+		double msPerFrame = double(totalNanoseconds) / fillFrames / 1.0e6;
+		printf("  %-36s %9.3f ms/frame %9.3f Gpixels/s\n", variant.name, msPerFrame,
+			pixelsPerFrame / (msPerFrame * 1.0e6));
+	}
+
+	// restore the state the scene expects
+	glDeleteQueries(1, &timerQuery);
+	glEnable(GL_DEPTH_TEST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteRenderbuffers(1, &colorBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+	glDeleteFramebuffers(1, &framebuffer);
+} // end runFillRateBenchmark method
+
+
+/*
+***********************************************
+*		Anti-Aliasing Benchmark
+***********************************************
+*/
+// 1080p target, the resolution FXAA is usually weighed against MSAA at
+const int aaWidth = 1920, aaHeight = 1080;
+// overlapping tilted quads drawn per frame, plenty of geometric edges
+const int aaQuads = 48;
+// frames timed per mode
+const int aaFrames = 20;
+
+/* time the offscreen path (draw, resolve, final pass into the window) with every anti-aliasing mode */
+void runAntiAliasingBenchmark(ShaderPermutations& shaders, IndirectRenderer& renderer, ClusteredLights& lights,
+	GLuint quadMesh, GLuint sceneTextures)
+{
+	const AntiAliasingMode modes[] = { AA_NONE, AA_MSAA2, AA_MSAA4, AA_MSAA8, AA_FXAA };
+
+	FXAAFilter fxaa;
+	bool fxaaReady = fxaa.init("FXAA.vertexshader", "FXAA.fragmentshader");
+
+	// quads of a third of the screen, turned and spread on a circle, each one nearer than the last
+	const MeshRange& quad = renderer.mesh(quadMesh);
+	float quadRadius = quad.boundingSphere.w;
+	FrameArena benchArena;
+	benchArena.init(aaQuads * sizeof(EntityInstance));
+	EntityList quads(aaQuads, EntityInstance(), FrameAllocator<EntityInstance>(benchArena));
+	for (int i = 0; i < aaQuads; i++)
+	{
+		float angle = 6.2831853f * i / aaQuads;
+		mat4 model = translate(mat4(1.0f), vec3(0.5f * cos(angle * 3.0f), 0.5f * sin(angle * 3.0f), 0.9f - 1.8f * i / aaQuads));
+		model = rotate(model, angle * 7.0f, vec3(0.0f, 0.0f, 1.0f));
+		quads[i] = {};
+		quads[i].model = scale(model, vec3(0.35f / quadRadius, 0.35f / quadRadius, 1.0f));
+		quads[i].meshID = quadMesh;
+	}
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, sceneTextures);
+
+	vector<PointLight> benchLights = { { vec3(0.0f, 0.0f, 1.0f), 100.0f, vec3(1.0f, 1.0f, 1.0f), 70.0f } };
+	mat4 identity = mat4(1.0f);
+	lights.update(benchLights, identity, identity);
+
+	GLuint programID = shaders.get(SHADER_LIGHTING | SHADER_INTERNAL_LIGHT |
+		(renderer.compressedVertices() ? SHADER_COMPRESSED_VERTICES : 0));
+	if (programID == 0)
+	{
+		fxaa.cleanup();
+		return;
+	}
+	glUseProgram(programID);
+	glUniformMatrix4fv(glGetUniformLocation(programID, "VP"), 1, GL_FALSE, &identity[0][0]);
+	glUniformMatrix4fv(glGetUniformLocation(programID, "V"), 1, GL_FALSE, &identity[0][0]);
+	glUniform1f(glGetUniformLocation(programID, "diffuseIntensity"), 1.0f);
+	glUniform3f(glGetUniformLocation(programID, "specularMaterialIntensity"), 0.3f, 0.3f, 0.3f);
+	lights.bind(programID, aaWidth, aaHeight);
+	glUniform1f(glGetUniformLocation(programID, "internalLightIntensity"), 0.5f);
+	glUniform1f(glGetUniformLocation(programID, "time"), 0.0f);
+	glUniform1i(glGetUniformLocation(programID, "myTextureSampler"), 0);
+
+	GLuint timerQuery;
+	glGenQueries(1, &timerQuery);
+	printf("Anti-aliasing benchmark: %dx%d, %d overlapping quads, %d frames per mode\n", aaWidth, aaHeight, aaQuads, aaFrames);
+	printf("  (traffic is estimated: clear + one write of every color/depth sample, the resolve, and the final pass)\n");
+
+	for (AntiAliasingMode mode : modes)
+	{
+		if (mode == AA_FXAA && !fxaaReady)
+		{
+			continue;
+		}
+		// the same offscreen path the scene takes, held at full size
+		int samples = antiAliasingSamples(mode);
+		DynamicResolution target;
+		target.init(0.0f, samples);
+		const FXAAFilter* filter = mode == AA_FXAA ? &fxaa : nullptr;
+
+		// warm up once so allocation is not timed
+		target.beginFrame(aaWidth, aaHeight);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		renderer.draw(quads, identity);
+		target.endFrame(filter);
+		glFinish();
+
+		GLuint64 totalNanoseconds = 0;
+		for (int frame = 0; frame < aaFrames; frame++)
+		{
+			glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+			target.beginFrame(aaWidth, aaHeight);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			renderer.draw(quads, identity);
+			target.endFrame(filter);
+			glEndQuery(GL_TIME_ELAPSED);
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &elapsed);
+			totalNanoseconds += elapsed;
+		}
+		target.cleanup();
+
+		// RGBA8 color and 24-bit depth (stored in 4 bytes) per sample
+		double pixels = double(aaWidth) * double(aaHeight);
+		double sampleBytes = pixels * samples * (4.0 + 4.0);
+		double resolveBytes = samples > 1 ? pixels * (samples * 4.0 + 4.0) : 0.0;
+		// blit: one read and one write per pixel; FXAA: 9 taps, mostly cache hits, and one write
+		double finalBytes = pixels * (4.0 + 4.0);
+		double bytesPerFrame = 2.0 * sampleBytes + resolveBytes + finalBytes;
+		double msPerFrame = double(totalNanoseconds) / aaFrames / 1.0e6;
+		printf("  %-6s %9.3f ms/frame %8.1f MB target %8.1f MB/frame %8.2f GB/s\n", antiAliasingModeName(mode),
+			msPerFrame, (sampleBytes + (samples > 1 ? pixels * 4.0 : 0.0)) / 1.0e6, bytesPerFrame / 1.0e6,
+			bytesPerFrame / (msPerFrame * 1.0e6));
+	}
+
+	// restore the state the scene expects
+	glDeleteQueries(1, &timerQuery);
+	fxaa.cleanup();
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+} // end runAntiAliasingBenchmark method
+
+
+/*
+***********************************************
+*		Physics Benchmark
+***********************************************
+*/
+// movers driven per tick
+const size_t driveCount = 100000;
+// ticks timed per kernel
+const int driveTicks = 100;
+// movers swept against each other in one tick (n^2 / 2 broadphase pairs)
+const size_t stepCount = 4096;
+// rows of the tunnelling check, each a heavy mover driving a light one into a heavier one
+const int tunnelRows = 16;
+// ticks stepped per tick length of the tunnelling check
+const int tunnelSteps = 30;
+
+/* fill a mover set with the pumpkin motion ranges at random positions */
+static void fillMovers(MoverArrays& movers, size_t count, bool spreadOut)
+{
+	const MotionParams motion = { 25.0f, 50, 2.5f, vec3(50.0f, 75.0f, 100.0f), vec3(0.0f, 1.57079633f, 0.0f) };
+	srand(1);
+	for (size_t i = 0; i < count; i++)
+	{
+		// spread out movers never touch, so only the distance test is timed
+		vec3 position = spreadOut ? vec3(static_cast<float>(i) * 10.0f, 0.0f, 0.0f)
+			: vec3(rand() % 33 - 12.0f, rand() % 71 - 35.5f, rand() % 17 + 3.0f);
+		movers.add(position, vec3(0.1f, 0.0f, 0.0f), vec3(0.0f), 1.0f, 1.0f, motion);
+	}
+	randomizeMotion(movers);
+} // end fillMovers method
+
+/* rows along x of a fast 2 kg mover, a resting 0.5 kg one that it knocks faster than itself, and a 10 kg one beyond;
+   every row starts in order and must stay in order, or a mover went through another; the resting movers may sleep */
+static int countTunnelling(float tick, bool sleeping)
+{
+	const MotionParams motion = { 25.0f, 50, 2.5f, vec3(50.0f, 75.0f, 100.0f), vec3(0.0f) };
+	MoverArrays movers;
+	for (int row = 0; row < tunnelRows; row++)
+	{
+		vec3 start(-2.0f, 0.0f, static_cast<float>(row) * 4.0f);
+		float speed = 10.0f + static_cast<float>(row) * 5.0f;
+		movers.add(start, vec3(speed, 0.0f, 0.0f), vec3(0.0f), 0.5f, 2.0f, motion);
+		size_t light = movers.add(start + vec3(2.0f, 0.0f, 0.0f), vec3(0.0f), vec3(0.0f), 0.5f, 0.5f, motion);
+		size_t heavy = movers.add(start + vec3(5.0f, 0.0f, 0.0f), vec3(0.0f), vec3(0.0f), 0.5f, 10.0f, motion);
+		movers.asleep[light] = movers.asleep[heavy] = sleeping ? 1 : 0;
+	}
+	int outOfOrder = 0;
+	for (int step = 0; step < tunnelSteps; step++)
+	{
+		stepPhysics(movers, static_cast<float>(step) * tick, tick, false);
+		for (int row = 0; row < tunnelRows; row++)
+		{
+			size_t first = static_cast<size_t>(row) * 3;
+			if (!(movers.posX[first] < movers.posX[first + 1] && movers.posX[first + 1] < movers.posX[first + 2]))
+			{
+				outOfOrder++;
+			}
+		}
+	}
+	return outOfOrder;
+} // end countTunnelling method
+
+/* time the waveform drive and one physics step of each supported kernel against the scalar version */
+void runPhysicsBenchmark()
+{
+	PhysicsKernel best = detectPhysicsKernel();
+	PhysicsKernel previous = physicsKernel();
+	double scalarDrive = 0.0, scalarStep = 0.0;
+	printf("Physics benchmark: %zu movers driven, %zu movers stepped\n", driveCount, stepCount);
+	for (int kernel = PHYSICS_SCALAR; kernel <= best; kernel++)
+	{
+		setPhysicsKernel(static_cast<PhysicsKernel>(kernel));
+
+		MoverArrays movers;
+		fillMovers(movers, driveCount, false);
+		auto start = chrono::steady_clock::now();
+		for (int tick = 0; tick < driveTicks; tick++)
+		{
+			driveMovers(movers, 1.0f + tick * 0.016f, 0.016f);
+		}
+		double driveMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / driveTicks;
+
+		MoverArrays sparse;
+		fillMovers(sparse, stepCount, true);
+		start = chrono::steady_clock::now();
+		stepPhysics(sparse, 1.0f, 0.016f, false);
+		double stepMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+		if (kernel == PHYSICS_SCALAR)
+		{
+			scalarDrive = driveMs;
+			scalarStep = stepMs;
+		}
+		printf("  %-8s drive %8.3f ms/tick (%5.2fx)  step %8.3f ms (%5.2fx)\n",
+			physicsKernelName(static_cast<PhysicsKernel>(kernel)), driveMs, scalarDrive / driveMs,
+			stepMs, scalarStep / stepMs);
+	}
+	setPhysicsKernel(previous);
+
+	// large ticks are where a knocked mover outruns the sweep it was paired with
+	printf("Tunnelling check: %d rows, %d ticks each, rows found out of order\n", tunnelRows, tunnelSteps);
+	for (float tick : { 1.0f / 60.0f, 0.05f, 0.1f, 0.25f })
+	{
+		printf("  tick %5.3f s  awake %3d  asleep %3d\n", tick, countTunnelling(tick, false), countTunnelling(tick, true));
+	}
+} // end runPhysicsBenchmark method
+
+
+/*
+***********************************************
+*		Job System Benchmark
+***********************************************
+*/
+// empty jobs queued to time the cost of one dispatch
+const size_t dispatchJobs = 100000;
+// items of the parallel_for workload
+const size_t scalingItems = 1 << 22;
+// grain of the parallel_for workload
+const size_t scalingGrain = 16384;
+// repetitions of each measurement, the fastest one is printed
+const int jobRepeats = 5;
+
+static void emptyJob(void*, size_t, size_t)
+{
+} // end emptyJob method
+
+/* dispatch overhead of single jobs and the speedup of parallel_for with 0, 1, 2, 4 ... workers */
+void runJobBenchmark()
+{
+	unsigned int previous = jobs.workerCount();
+	unsigned int hardwareThreads = std::max(thread::hardware_concurrency(), 1u);
+	vector<float> values(scalingItems);
+	double inlineMs = 0.0;
+	printf("Job system benchmark: %zu empty jobs, parallel_for over %zu items (grain %zu), %u hardware threads\n",
+		dispatchJobs, scalingItems, scalingGrain, hardwareThreads);
+
+	for (unsigned int workerCount = 0; workerCount <= hardwareThreads; workerCount = workerCount ? workerCount * 2 : 1)
+	{
+		jobs.start(workerCount);
+
+		// queue and drain empty jobs: everything measured is scheduler overhead
+		double dispatchNs = 1.0e30;
+		for (int repeat = 0; repeat < jobRepeats; repeat++)
+		{
+			JobCounter counter;
+			auto start = chrono::steady_clock::now();
+			for (size_t i = 0; i < dispatchJobs; i++)
+			{
+				jobs.run(&emptyJob, nullptr, 0, 0, counter);
+			}
+			jobs.wait(counter);
+			double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / dispatchJobs;
+			dispatchNs = std::min(dispatchNs, ns);
+		}
+
+		// compute-bound loop split by parallel_for
+		double forMs = 1.0e30;
+		for (int repeat = 0; repeat < jobRepeats; repeat++)
+		{
+			auto start = chrono::steady_clock::now();
+			jobs.parallelFor(values.size(), scalingGrain, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					float x = static_cast<float>(i) * 0.001f;
+					values[i] = sqrt(x) * sin(x) + cos(x * 0.5f);
+				}
+			});
+			double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+			forMs = std::min(forMs, ms);
+		}
+		if (workerCount == 0)
+		{
+			inlineMs = forMs;
+		}
+		printf("  %2u workers  dispatch %8.1f ns/job  parallel_for %8.3f ms (%5.2fx)\n",
+			workerCount, dispatchNs, forMs, inlineMs / forMs);
+	}
+	jobs.start(previous);
+} // end runJobBenchmark method
+
+
+/*
+***********************************************
+*		OBJ Parser Benchmark
+***********************************************
+*/
+// vertices per side of the generated grid mesh
+const int syntheticGrid = 400;
+// file the generated mesh is written to, removed afterwards
+const char* syntheticOBJ = "obj_benchmark.obj";
+// repetitions of each load, the fastest one is printed
+const int objRepeats = 3;
+
+/* grid with a normal and uv per vertex and two triangles per cell, written like an exporter would */
+static bool writeSyntheticOBJ(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if (file == nullptr)
+	{
+		printf("Could not write %s\n", path);
+		return false;
+	}
+	fprintf(file, "# synthetic benchmark mesh\n");
+	for (int z = 0; z < syntheticGrid; z++)
+	{
+		for (int x = 0; x < syntheticGrid; x++)
+		{
+			float fx = (float)x / syntheticGrid, fz = (float)z / syntheticGrid;
+			fprintf(file, "v %f %f %f\n", fx * 10.0f - 5.0f, sin(fx * 12.0f) * cos(fz * 9.0f), fz * 10.0f - 5.0f);
+		}
+	}
+	for (int z = 0; z < syntheticGrid; z++)
+	{
+		for (int x = 0; x < syntheticGrid; x++)
+		{
+			fprintf(file, "vt %f %f\n", (float)x / (syntheticGrid - 1), (float)z / (syntheticGrid - 1));
+		}
+	}
+	for (int z = 0; z < syntheticGrid; z++)
+	{
+		for (int x = 0; x < syntheticGrid; x++)
+		{
+			vec3 normal = normalize(vec3(-cos((float)x / syntheticGrid * 12.0f), 1.0f, sin((float)z / syntheticGrid * 9.0f)));
+			fprintf(file, "vn %.4f %.4f %.4f\n", normal.x, normal.y, normal.z);
+		}
+	}
+	fprintf(file, "usemtl grid\ns off\n");
+	for (int z = 0; z + 1 < syntheticGrid; z++)
+	{
+		for (int x = 0; x + 1 < syntheticGrid; x++)
+		{
+			int a = z * syntheticGrid + x + 1, b = a + 1, c = a + syntheticGrid, d = c + 1;
+			fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, c, c, c, b, b, b);
+			fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", b, b, b, c, c, c, d, d, d);
+		}
+	}
+	fclose(file);
+	return true;
+} // end writeSyntheticOBJ method
+
+template <class T>
+static bool sameContents(const vector<T>& a, const vector<T>& b)
+{
+	return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+} // end sameContents method
+
+/* load each file with loadOBJ and parseOBJ, check both give the same triangles and print the speedup */
+void runOBJBenchmark(const vector<const char*>& paths)
+{
+	vector<const char*> files = paths;
+	bool synthetic = files.empty() && writeSyntheticOBJ(syntheticOBJ);
+	if (files.empty())
+	{
+		files = { "pumpkin.obj", "Halloween_Ghost.obj", "tree.obj" };
+		if (synthetic)
+		{
+			files.push_back(syntheticOBJ);
+		}
+	}
+	printf("OBJ parser benchmark: loadOBJ vs parseOBJ with %u workers\n", jobs.workerCount());
+
+	vector<double> loadMs(files.size(), 1.0e30), parseMs(files.size(), 1.0e30);
+	vector<bool> identical(files.size(), true), readable(files.size(), true);
+	for (size_t f = 0; f < files.size(); f++)
+	{
+		for (int repeat = 0; repeat < objRepeats && readable[f]; repeat++)
+		{
+			vector<vec3> vertices, normals, parsedVertices, parsedNormals;
+			vector<vec2> uvs, parsedUvs;
+
+			auto start = chrono::steady_clock::now();
+			readable[f] = loadOBJ(files[f], vertices, uvs, normals);
+			loadMs[f] = std::min(loadMs[f], chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+
+			start = chrono::steady_clock::now();
+			bool parsed = parseOBJ(files[f], parsedVertices, parsedUvs, parsedNormals);
+			parseMs[f] = std::min(parseMs[f], chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+
+			identical[f] = identical[f] && parsed == readable[f] && sameContents(vertices, parsedVertices) &&
+				sameContents(uvs, parsedUvs) && sameContents(normals, parsedNormals);
+		}
+	}
+
+	// loadOBJ prints as it goes, so the table comes last
+	for (size_t f = 0; f < files.size(); f++)
+	{
+		if (!readable[f])
+		{
+			printf("  %-24s could not be read by loadOBJ\n", files[f]);
+			continue;
+		}
+		printf("  %-24s loadOBJ %9.2f ms  parseOBJ %9.2f ms (%5.2fx)  %s\n", files[f], loadMs[f], parseMs[f],
+			loadMs[f] / parseMs[f], identical[f] ? "identical" : "MISMATCH");
+	}
+	if (synthetic)
+	{
+		remove(syntheticOBJ);
+	}
+} // end runOBJBenchmark method
+
+
+/*
+***********************************************
+*		Vertex Indexing Benchmark
+***********************************************
+*/
+// vertices per side of the generated grid, kept under the 65536 vertices a 16-bit index can reach
+const int indexGrid = 250;
+// repetitions of each indexer, the fastest one is printed
+const int indexRepeats = 5;
+
+/* the triangle soup an .obj grid parses to: every shared vertex repeated in each triangle that uses it */
+static void gridSoup(vector<vec3>& vertices, vector<vec2>& uvs, vector<vec3>& normals)
+{
+	for (int z = 0; z + 1 < indexGrid; z++)
+	{
+		for (int x = 0; x + 1 < indexGrid; x++)
+		{
+			const int corners[6][2] = { { x, z }, { x, z + 1 }, { x + 1, z }, { x + 1, z }, { x, z + 1 }, { x + 1, z + 1 } };
+			for (const auto& corner : corners)
+			{
+				float fx = (float)corner[0] / indexGrid, fz = (float)corner[1] / indexGrid;
+				vertices.push_back(vec3(fx * 10.0f - 5.0f, sin(fx * 12.0f) * cos(fz * 9.0f), fz * 10.0f - 5.0f));
+				uvs.push_back(vec2(fx, -fz));
+				normals.push_back(normalize(vec3(-cos(fx * 12.0f), 1.0f, sin(fz * 9.0f))));
+			}
+		}
+	}
+} // end gridSoup method
+
+/* time indexVBO, indexVertices and indexVerticesParallel on one soup and check all three agree */
+static void timeIndexers(const char* name, const vector<vec3>& vertices, const vector<vec2>& uvs, const vector<vec3>& normals)
+{
+	double times[3] = { 1.0e30, 1.0e30, 1.0e30 };
+	vector<unsigned short> indices[3];
+	vector<vec3> indexedVertices[3], indexedNormals[3];
+	vector<vec2> indexedUvs[3];
+	for (int repeat = 0; repeat < indexRepeats; repeat++)
+	{
+		for (int method = 0; method < 3; method++)
+		{
+			indices[method].clear();
+			indexedVertices[method].clear();
+			indexedUvs[method].clear();
+			indexedNormals[method].clear();
+			auto start = chrono::steady_clock::now();
+			if (method == 0)
+			{
+				// indexVBO takes non-const references
+				vector<vec3> v = vertices, n = normals;
+				vector<vec2> t = uvs;
+				start = chrono::steady_clock::now();
+				indexVBO(v, t, n, indices[0], indexedVertices[0], indexedUvs[0], indexedNormals[0]);
+			}
+			else if (method == 1)
+			{
+				indexVertices(vertices, uvs, normals, indices[1], indexedVertices[1], indexedUvs[1], indexedNormals[1]);
+			}
+			else
+			{
+				indexVerticesParallel(vertices, uvs, normals, indices[2], indexedVertices[2], indexedUvs[2], indexedNormals[2]);
+			}
+			double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+			times[method] = std::min(times[method], ms);
+		}
+	}
+	bool identical = true;
+	for (int method = 1; method < 3; method++)
+	{
+		identical = identical && sameContents(indices[0], indices[method]) && sameContents(indexedVertices[0], indexedVertices[method]) &&
+			sameContents(indexedUvs[0], indexedUvs[method]) && sameContents(indexedNormals[0], indexedNormals[method]);
+	}
+	printf("  %-20s %8zu corners %6zu vertices  indexVBO %8.2f ms  hash %7.2f ms (%5.2fx)  parallel %7.2f ms (%5.2fx)  %s\n",
+		name, vertices.size(), indexedVertices[0].size(), times[0], times[1], times[0] / times[1], times[2], times[0] / times[2],
+		identical ? "identical" : "MISMATCH");
+} // end timeIndexers method
+
+/* index the generated grid and every readable scene mesh with each indexer */
+void runIndexBenchmark()
+{
+	printf("Vertex indexing benchmark: indexVBO (std::map) vs hash table, parallel version with %u workers\n", jobs.workerCount());
+	vector<vec3> vertices, normals;
+	vector<vec2> uvs;
+	gridSoup(vertices, uvs, normals);
+	timeIndexers("generated grid", vertices, uvs, normals);
+
+	const char* meshes[] = { "pumpkin.obj", "Halloween_Ghost.obj", "tree.obj" };
+	for (const char* mesh : meshes)
+	{
+		vertices.clear();
+		uvs.clear();
+		normals.clear();
+		if (parseOBJ(mesh, vertices, uvs, normals))
+		{
+			timeIndexers(mesh, vertices, uvs, normals);
+		}
+	}
+} // end runIndexBenchmark method
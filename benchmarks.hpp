@@ -0,0 +1,36 @@
+#ifndef BENCHMARKS_HPP
+#define BENCHMARKS_HPP
+
+#include <vector>
+
+class ShaderPermutations;
+class IndirectRenderer;
+class ClusteredLights;
+
+// render full-screen layers of quadMesh at 3840x2160 with every StandardShading permutation
+// and print the GPU time per frame and fill rate of each
+void runFillRateBenchmark(ShaderPermutations& shaders, IndirectRenderer& renderer, ClusteredLights& lights,
+	GLuint quadMesh, GLuint sceneTextures);
+
+// render overlapping tilted copies of quadMesh at 1920x1080 through the offscreen path with every
+// anti-aliasing mode and print the GPU time and estimated framebuffer traffic of each
+void runAntiAliasingBenchmark(ShaderPermutations& shaders, IndirectRenderer& renderer, ClusteredLights& lights,
+	GLuint quadMesh, GLuint sceneTextures);
+
+// time the waveform and physics-step kernels of every supported instruction set
+// and print the speedup over the scalar version, then step rows of colliding movers with large ticks
+// and print how many ever end up out of order (went through each other)
+void runPhysicsBenchmark();
+
+// time the dispatch of empty jobs and the scaling of parallel_for with a growing number of workers
+void runJobBenchmark();
+
+// load each .obj with loadOBJ and the parallel parseOBJ, check they match and print both times;
+// with no paths the scene meshes and a large generated mesh are used
+void runOBJBenchmark(const std::vector<const char*>& paths);
+
+// index a generated grid and the scene meshes with indexVBO and both hash-table indexers,
+// check they match and print the time of each
+void runIndexBenchmark();
+
+#endif
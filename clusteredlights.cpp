@@ -0,0 +1,232 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Clustered forward lighting. The view frustum is split into a grid of
+* screen tiles and exponential depth slices, every point light is binned
+* into the clusters its sphere overlaps, and the fragment shader only
+* loops over the lights of its own cluster.
+* 
+*/
+
+// include standard headers
+#include <vector>
+#include <math.h>
+#include <float.h>
+
+// include GLEW
+#include <GL/glew.h>
+
+// include GLM
+#include <glm/glm.hpp>
+
+using namespace glm;
+using namespace std;
+
+#include "clusteredlights.hpp"
+#include "jobsystem.hpp"
+
+// lights per binning job, only large light counts are split
+const size_t lightGrain = 256;
+
+/* create the three shader storage buffers */
+void ClusteredLights::init(float nearPlane, float farPlane)
+{
+	this->nearPlane = nearPlane;
+	this->farPlane = farPlane;
+	clusterRanges.resize(clustersX * clustersY * clustersZ);
+	glGenBuffers(1, &lightBuffer);
+	glGenBuffers(1, &clusterBuffer);
+	glGenBuffers(1, &lightIndexBuffer);
+} // end init method
+
+/* exponential depth slice holding the given view depth */
+GLuint ClusteredLights::depthSlice(float viewDepth) const
+{
+	if (viewDepth <= nearPlane)
+	{
+		return 0;
+	}
+	float slice = log(viewDepth / nearPlane) / log(farPlane / nearPlane) * clustersZ;
+	return (GLuint)clamp((int)slice, 0, (int)clustersZ - 1);
+} // end depthSlice method
+
+/* cameraspace light and the range of clusters it touches (lightVisible stays 0 when it is off screen) */
+void ClusteredLights::clusterBounds(const PointLight& light, GLuint i, const mat4& view, const mat4& projection)
+{
+	vec4 center = view * vec4(light.position, 1.0f);
+	float radius = light.radius;
+	clusterLights[i].positionRadius = vec4(center.x, center.y, center.z, radius);
+	clusterLights[i].colorPower = vec4(light.color * light.power, 0.0f);
+
+	// depth range, cameraspace looks down -Z
+	float nearDepth = -center.z - radius;
+	float farDepth = -center.z + radius;
+	if (farDepth < nearPlane || nearDepth > farPlane)
+	{
+		return;
+	}
+
+	// screen range : project the corners of the light's box unless it reaches the near plane
+	vec2 ndcMin = vec2(-1.0f), ndcMax = vec2(1.0f);
+	if (nearDepth > nearPlane)
+	{
+		ndcMin = vec2(FLT_MAX);
+		ndcMax = vec2(-FLT_MAX);
+		for (int corner = 0; corner < 8; corner++)
+		{
+			vec4 point = vec4
+			(
+				center.x + ((corner & 1) ? radius : -radius),
+				center.y + ((corner & 2) ? radius : -radius),
+				center.z + ((corner & 4) ? radius : -radius),
+				1.0f
+			);
+			vec4 clip = projection * point;
+			vec2 ndc = vec2(clip.x, clip.y) / clip.w;
+			ndcMin = min(ndcMin, ndc);
+			ndcMax = max(ndcMax, ndc);
+		}
+		if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f)
+		{
+			return;
+		}
+	}
+	ndcMin = max(ndcMin, vec2(-1.0f));
+	ndcMax = min(ndcMax, vec2(1.0f));
+
+	lightMin[i] = uvec3
+	(
+		(GLuint)min((int)((ndcMin.x * 0.5f + 0.5f) * clustersX), (int)clustersX - 1),
+		(GLuint)min((int)((ndcMin.y * 0.5f + 0.5f) * clustersY), (int)clustersY - 1),
+		depthSlice(nearDepth)
+	);
+	lightMax[i] = uvec3
+	(
+		(GLuint)min((int)((ndcMax.x * 0.5f + 0.5f) * clustersX), (int)clustersX - 1),
+		(GLuint)min((int)((ndcMax.y * 0.5f + 0.5f) * clustersY), (int)clustersY - 1),
+		depthSlice(farDepth)
+	);
+	lightVisible[i] = 1;
+} // end clusterBounds method
+
+/* bin every light into the clusters its bounding sphere overlaps */
+void ClusteredLights::update(const vector<PointLight>& lights, const mat4& view, const mat4& projection)
+{
+	bin(lights, view, projection);
+	upload();
+} // end update method
+
+/* cluster lists of every light, on the CPU only (safe to run on a job) */
+void ClusteredLights::bin(const vector<PointLight>& lights, const mat4& view, const mat4& projection)
+{
+	GLuint lightCount = (GLuint)lights.size();
+	clusterLights.resize(lightCount);
+	lightMin.resize(lightCount);
+	lightMax.resize(lightCount);
+	lightVisible.assign(lightCount, 0);
+	for (auto& range : clusterRanges)
+	{
+		range = uvec2(0, 0);
+	}
+
+	// 1st pass : cluster range of each light, every light on its own so they can be split into jobs
+	jobs.parallelFor(lightCount, lightGrain, [&](size_t begin, size_t end)
+	{
+		for (GLuint i = (GLuint)begin; i < (GLuint)end; i++)
+		{
+			clusterBounds(lights[i], i, view, projection);
+		}
+	});
+
+	// how many lights land in each cluster
+	for (GLuint i = 0; i < lightCount; i++)
+	{
+		if (!lightVisible[i])
+		{
+			continue;
+		}
+		for (GLuint z = lightMin[i].z; z <= lightMax[i].z; z++)
+			for (GLuint y = lightMin[i].y; y <= lightMax[i].y; y++)
+				for (GLuint x = lightMin[i].x; x <= lightMax[i].x; x++)
+				{
+					clusterRanges[x + clustersX * (y + clustersY * z)].y++;
+				}
+	}
+
+	// offsets of each cluster's list inside the shared index list
+	GLuint offset = 0;
+	for (auto& range : clusterRanges)
+	{
+		range.x = offset;
+		offset += range.y;
+		range.y = 0;
+	}
+	lightIndices.resize(offset);
+
+	// 2nd pass : write each light's index into every cluster it touches
+	for (GLuint i = 0; i < lightCount; i++)
+	{
+		if (!lightVisible[i])
+		{
+			continue;
+		}
+		for (GLuint z = lightMin[i].z; z <= lightMax[i].z; z++)
+			for (GLuint y = lightMin[i].y; y <= lightMax[i].y; y++)
+				for (GLuint x = lightMin[i].x; x <= lightMax[i].x; x++)
+				{
+					uvec2& range = clusterRanges[x + clustersX * (y + clustersY * z)];
+					lightIndices[range.x + range.y] = i;
+					range.y++;
+				}
+	}
+} // end bin method
+
+/* upload the result of the last bin() (empty buffers still get one element so they can be bound) */
+void ClusteredLights::upload()
+{
+	GLuint lightCount = (GLuint)clusterLights.size();
+	GLuint offset = (GLuint)lightIndices.size();
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, max(lightCount, 1u) * sizeof(ClusterLight),
+		lightCount ? clusterLights.data() : NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusterBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, clusterRanges.size() * sizeof(uvec2), clusterRanges.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightIndexBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, max(offset, 1u) * sizeof(GLuint),
+		offset ? lightIndices.data() : NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+} // end upload method
+
+/* bind the light buffers and hand the cluster layout to the program */
+void ClusteredLights::bind(GLuint programID, int screenWidth, int screenHeight) const
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, lightBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, clusterBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, lightIndexBuffer);
+
+	// slice = log(depth) * scale - bias, folded here instead of per fragment
+	float depthScale = clustersZ / log(farPlane / nearPlane);
+	float depthBias = depthScale * log(nearPlane);
+	glUniform3ui(glGetUniformLocation(programID, "clusterCounts"), clustersX, clustersY, clustersZ);
+	glUniform2f(glGetUniformLocation(programID, "clusterTileScale"),
+		float(clustersX) / float(screenWidth), float(clustersY) / float(screenHeight));
+	glUniform2f(glGetUniformLocation(programID, "clusterDepthScaleBias"), depthScale, depthBias);
+} // end bind method
+
+/* delete the light buffers */
+void ClusteredLights::cleanup()
+{
+	glDeleteBuffers(1, &lightBuffer);
+	glDeleteBuffers(1, &clusterBuffer);
+	glDeleteBuffers(1, &lightIndexBuffer);
+} // end cleanup method
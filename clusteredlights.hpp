@@ -0,0 +1,61 @@
+#ifndef CLUSTEREDLIGHTS_HPP
+#define CLUSTEREDLIGHTS_HPP
+
+#include <vector>
+
+/* PointLight - one light in the scene, in worldspace */
+struct PointLight
+{
+	glm::vec3 position;
+	float radius;	// distance where the light's contribution reaches zero
+	glm::vec3 color;
+	float power;
+};
+
+/* ClusterLight - light as read by the fragment shader, matches the std430 "ClusterLight" struct */
+struct ClusterLight
+{
+	glm::vec4 positionRadius;	// cameraspace position (xyz) and radius (w)
+	glm::vec4 colorPower;		// color * power (rgb)
+};
+
+/* ClusteredLights - bins point lights into view frustum clusters so each fragment only loops over nearby lights */
+class ClusteredLights
+{
+public:
+	// cluster grid resolution (screen tiles x, y and depth slices)
+	static const GLuint clustersX = 16, clustersY = 9, clustersZ = 24;
+
+	// create the light buffers, depth slices span nearPlane..farPlane
+	void init(float nearPlane, float farPlane);
+	// transform the lights to cameraspace, bin them into clusters and upload the result
+	void update(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection);
+	// the two halves of update(): bin() makes no GL calls and may run on any thread, upload() needs the context
+	void bin(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection);
+	void upload();
+	// bind the light buffers and set the cluster uniforms of the given program
+	void bind(GLuint programID, int screenWidth, int screenHeight) const;
+	// release GL objects
+	void cleanup();
+
+	GLuint lightIndexCount() const { return (GLuint)lightIndices.size(); }
+
+private:
+	GLuint depthSlice(float viewDepth) const;
+	void clusterBounds(const PointLight& light, GLuint i, const glm::mat4& view, const glm::mat4& projection);
+
+	float nearPlane = 0.1f;
+	float farPlane = 100.0f;
+	std::vector<ClusterLight> clusterLights;
+	std::vector<glm::uvec2> clusterRanges;	// offset into lightIndices and light count, per cluster
+	std::vector<GLuint> lightIndices;
+	std::vector<glm::uvec3> lightMin;		// first cluster each light touches
+	std::vector<glm::uvec3> lightMax;		// last cluster each light touches
+	std::vector<unsigned char> lightVisible;	// bytes, not vector<bool>, so jobs can write neighbours
+
+	GLuint lightBuffer = 0;
+	GLuint clusterBuffer = 0;
+	GLuint lightIndexBuffer = 0;
+};
+
+#endif
@@ -64,8 +64,13 @@ float speed = 3.0f; // 3 units / second
 vec3 front = vec3(-0.5f, -0.5f, -1.0f);
 vec3 up = vec3(0.0f, 1.0f, 0.0f);
 
-// variable to begin 3D object movement
-bool moving = false;
+// variable to begin 3D object movement, read by the physics thread
+atomic<bool> moving(false);
+// spawn/despawn requests and whether their keys were already down last frame
+int spawnBurstRequests = 0;
+int despawnBurstRequests = 0;
+bool spawnKeyHeld = false;
+bool despawnKeyHeld = false;
 
 void computeMatricesFromInputs() 
 {
@@ -138,6 +143,20 @@ void computeMatricesFromInputs()
 		moving = true;
 	}
 
+	// spawn or despawn a burst of objects, once per press
+	bool spawnDown = glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS;
+	bool despawnDown = glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS;
+	if (spawnDown && !spawnKeyHeld)
+	{
+		spawnBurstRequests++;
+	}
+	if (despawnDown && !despawnKeyHeld)
+	{
+		despawnBurstRequests++;
+	}
+	spawnKeyHeld = spawnDown;
+	despawnKeyHeld = despawnDown;
+
 	// recalculate position
 	position.x = radius * sin(theta) * cos(phi);
 	position.y = radius * sin(theta) * sin(phi);
@@ -1,11 +1,16 @@
 #ifndef CONTROLS_HPP
 #define CONTROLS_HPP
 
+#include <atomic>
+
 void computeMatricesFromInputs();
 glm::mat4 getViewMatrix();
 glm::mat4 getProjectionMatrix();
 
-// variable to begin 3D object movement
-extern bool moving;
+// variable to begin 3D object movement, read by the physics thread
+extern std::atomic<bool> moving;
+// bursts requested with 'b' (spawn) and 'n' (despawn), counted per key press until the render loop takes them
+extern int spawnBurstRequests;
+extern int despawnBurstRequests;
 
 #endif
\ No newline at end of file
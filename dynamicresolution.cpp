@@ -0,0 +1,201 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Dynamic resolution. The scene is drawn into the lower-left corner of a
+* window-sized offscreen framebuffer, scaled by a factor that follows a
+* GPU time budget: GL_TIME_ELAPSED queries, read a few frames late so the
+* CPU never waits on them, feed a damped controller that assumes GPU time
+* grows with the pixel count. The corner is resolved (when multisampled)
+* and stretched over the window with a bilinear blit, or by the FXAA pass.
+* Without a budget the target stays at window size, which is how the FXAA
+* mode gets a resolved frame to filter.
+* 
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+// include GLEW
+#include <GL/glew.h>
+
+using namespace std;
+
+#include "dynamicresolution.hpp"
+#include "antialiasing.hpp"
+
+// fraction of the way to the ideal scale moved per measurement, damps oscillation
+const float scaleGain = 0.3f;
+// relative error of the GPU time that is left alone
+const float timeDeadband = 0.05f;
+// render sizes are kept to multiples of this many pixels
+const int sizeAlignment = 8;
+
+bool DynamicResolution::init(float target, int sampleCount, float smallestScale)
+{
+	targetMilliseconds = target;
+	samples = sampleCount;
+	minScale = smallestScale;
+	currentScale = 1.0f;
+	if (targetMilliseconds > 0.0f)
+	{
+		glGenQueries(queryLatency, queries);
+	}
+	glGenFramebuffers(1, &framebuffer);
+	glGenFramebuffers(1, &resolveFramebuffer);
+	return true;
+} // end init method
+
+/* window-sized color and depth targets and the single-sampled color texture */
+void DynamicResolution::allocate(int width, int height)
+{
+	glDeleteRenderbuffers(1, &colorBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+	glDeleteTextures(1, &colorTexture);
+	colorBuffer = 0;
+
+	// bilinear so the blit or the filter can stretch it
+	glGenTextures(1, &colorTexture);
+	glBindTexture(GL_TEXTURE_2D, colorTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	if (samples > 1)
+	{
+		glGenRenderbuffers(1, &colorBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	}
+	else
+	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+	}
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples > 1 ? samples : 0, GL_DEPTH_COMPONENT24, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		fprintf(stderr, "Dynamic resolution: offscreen framebuffer is incomplete\n");
+	}
+
+	if (samples > 1)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, resolveFramebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+	}
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	windowWidth = width;
+	windowHeight = height;
+} // end allocate method
+
+void DynamicResolution::beginFrame(int width, int height)
+{
+	if (width != windowWidth || height != windowHeight)
+	{
+		allocate(width, height);
+	}
+	renderWidth = std::max(sizeAlignment, (int)(width * currentScale) / sizeAlignment * sizeAlignment);
+	renderHeight = std::max(sizeAlignment, (int)(height * currentScale) / sizeAlignment * sizeAlignment);
+	renderWidth = std::min(renderWidth, width);
+	renderHeight = std::min(renderHeight, height);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, renderWidth, renderHeight);
+	// glClear ignores the viewport, keep it to the drawn corner
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(0, 0, renderWidth, renderHeight);
+	if (targetMilliseconds > 0.0f)
+	{
+		glBeginQuery(GL_TIME_ELAPSED, queries[frame % queryLatency]);
+	}
+} // end beginFrame method
+
+void DynamicResolution::endFrame(const FXAAFilter* filter)
+{
+	glDisable(GL_SCISSOR_TEST);
+	if (targetMilliseconds > 0.0f)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		frame++;
+	}
+
+	/* the query issued queryLatency - 1 frames ago is normally finished by now; if it is not, skip this
+	   measurement rather than wait */
+	if (targetMilliseconds > 0.0f && frame >= queryLatency)
+	{
+		GLuint oldest = queries[frame % queryLatency];
+		GLint available = 0;
+		glGetQueryObjectiv(oldest, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available)
+		{
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(oldest, GL_QUERY_RESULT, &elapsed);
+			measuredMilliseconds = (float)(elapsed / 1.0e6);
+			float error = measuredMilliseconds / targetMilliseconds - 1.0f;
+			if (measuredMilliseconds > 0.0f && fabs(error) > timeDeadband)
+			{
+				// GPU time goes with the pixel count, the square of the scale
+				float ideal = currentScale * sqrt(targetMilliseconds / measuredMilliseconds);
+				currentScale += (ideal - currentScale) * scaleGain;
+				currentScale = std::min(1.0f, std::max(minScale, currentScale));
+			}
+		}
+	}
+
+	// resolve the drawn corner, then stretch it over the window
+	GLuint source = framebuffer;
+	if (samples > 1)
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFramebuffer);
+		glBlitFramebuffer(0, 0, renderWidth, renderHeight, 0, 0, renderWidth, renderHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		source = resolveFramebuffer;
+	}
+	glViewport(0, 0, windowWidth, windowHeight);
+	if (filter)
+	{
+		// the filter samples the resolved texture bilinearly, so it upscales as it smooths
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		filter->apply(colorTexture, renderWidth, renderHeight, windowWidth, windowHeight);
+	}
+	else
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glBlitFramebuffer(0, 0, renderWidth, renderHeight, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT,
+			renderWidth == windowWidth && renderHeight == windowHeight ? GL_NEAREST : GL_LINEAR);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+} // end endFrame method
+
+void DynamicResolution::cleanup()
+{
+	if (targetMilliseconds > 0.0f)
+	{
+		glDeleteQueries(queryLatency, queries);
+	}
+	glDeleteRenderbuffers(1, &colorBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+	glDeleteTextures(1, &colorTexture);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteFramebuffers(1, &resolveFramebuffer);
+} // end cleanup method
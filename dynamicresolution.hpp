@@ -0,0 +1,53 @@
+#ifndef DYNAMICRESOLUTION_HPP
+#define DYNAMICRESOLUTION_HPP
+
+class FXAAFilter;
+
+/* DynamicResolution - renders the scene into an offscreen framebuffer at a scale of the window size that a
+   controller adjusts every frame to hold a GPU frame-time budget, then stretches the result over the window */
+class DynamicResolution
+{
+public:
+	// frames of GPU timer queries in flight, results are read this many frames late so nothing stalls
+	static const int queryLatency = 4;
+
+	// create the timer queries; samples > 1 renders with MSAA (the window itself must then be single-sampled);
+	// a target of 0 keeps the full window size, a plain offscreen target for the FXAA pass
+	bool init(float targetMilliseconds, int samples, float minScale = 0.5f);
+	// bind the offscreen framebuffer with a viewport of scale() x the window and start timing the frame
+	void beginFrame(int windowWidth, int windowHeight);
+	// stop timing, update the scale from the oldest finished query, resolve and upscale into the window,
+	// through the filter when one is given
+	void endFrame(const FXAAFilter* filter = nullptr);
+	// release GL objects
+	void cleanup();
+
+	int width() const { return renderWidth; }
+	int height() const { return renderHeight; }
+	float scale() const { return currentScale; }
+	// GPU time of the newest measured frame, in milliseconds
+	float gpuMilliseconds() const { return measuredMilliseconds; }
+
+private:
+	void allocate(int width, int height);
+
+	float targetMilliseconds = 16.6f;
+	float minScale = 0.5f;
+	float currentScale = 1.0f;
+	float measuredMilliseconds = 0.0f;
+	int samples = 1;
+	int windowWidth = 0, windowHeight = 0;
+	int renderWidth = 0, renderHeight = 0;
+	// window-sized targets, only the scaled corner is drawn so a new scale never reallocates
+	GLuint framebuffer = 0;
+	GLuint colorBuffer = 0;		// MSAA color, unused when single-sampled
+	GLuint depthBuffer = 0;
+	// single-sampled color: the color attachment itself, or the resolved copy of the MSAA target
+	// (a multisampled source can neither be stretched nor sampled by the filter)
+	GLuint colorTexture = 0;
+	GLuint resolveFramebuffer = 0;
+	GLuint queries[queryLatency] = {};
+	unsigned int frame = 0;
+};
+
+#endif
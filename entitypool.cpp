@@ -0,0 +1,72 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with
+* Custom Classes, Mulithreading, & OpenGL
+*
+* Description:
+* Entity pool. Slots are allocated once; spawning pops the free list,
+* despawning pushes the slot back and swaps the last live slot into its
+* place in the dense live list, so both are O(1) and the arrays indexed
+* by slot (physics, transforms) never move.
+*
+*/
+
+// include standard headers
+#include <vector>
+
+using namespace std;
+
+#include "entitypool.hpp"
+
+const uint32_t EntityPool::noIndex;
+
+void EntityPool::reserve(size_t capacity)
+{
+	generations.assign(capacity, 0);
+	liveIndex.assign(capacity, noIndex);
+	liveSlots.clear();
+	liveSlots.reserve(capacity);
+	freeSlots.resize(capacity);
+	for (size_t i = 0; i < capacity; i++)
+	{
+		freeSlots[i] = (uint32_t)(capacity - 1 - i);
+	}
+} // end reserve method
+
+EntityHandle EntityPool::spawn()
+{
+	if (freeSlots.empty())
+	{
+		return { noIndex, 0 };
+	}
+	uint32_t index = freeSlots.back();
+	freeSlots.pop_back();
+	liveIndex[index] = (uint32_t)liveSlots.size();
+	liveSlots.push_back(index);
+	return { index, generations[index] };
+} // end spawn method
+
+bool EntityPool::despawn(EntityHandle handle)
+{
+	if (!valid(handle))
+	{
+		return false;
+	}
+	// the last live slot fills the gap
+	uint32_t gap = liveIndex[handle.index];
+	uint32_t last = liveSlots.back();
+	liveSlots[gap] = last;
+	liveIndex[last] = gap;
+	liveSlots.pop_back();
+	liveIndex[handle.index] = noIndex;
+	generations[handle.index]++;
+	freeSlots.push_back(handle.index);
+	return true;
+} // end despawn method
@@ -0,0 +1,49 @@
+#ifndef ENTITYPOOL_HPP
+#define ENTITYPOOL_HPP
+
+#include <vector>
+#include <stdint.h>
+
+/* EntityHandle - names one pooled entity; it goes stale when the entity is despawned, even once the slot is reused */
+struct EntityHandle
+{
+	uint32_t index;
+	uint32_t generation;
+};
+
+/* EntityPool - fixed set of slots handed out and taken back in O(1) through a free list; each slot's
+   generation counts its despawns, so a handle is only valid while its generation matches */
+class EntityPool
+{
+public:
+	static const uint32_t noIndex = 0xFFFFFFFFu;
+
+	// allocate every slot up front, spawn and despawn never allocate afterwards
+	void reserve(size_t capacity);
+	// take a free slot, a handle with index noIndex when the pool is full; a fresh pool hands out the
+	// lowest slots in order, after that the most recently freed slot is reused first (LIFO)
+	EntityHandle spawn();
+	// free the handle's slot and advance its generation, false if the handle is stale
+	bool despawn(EntityHandle handle);
+
+	bool valid(EntityHandle handle) const
+	{
+		return handle.index < generations.size() && liveIndex[handle.index] != noIndex &&
+			generations[handle.index] == handle.generation;
+	}
+	bool alive(uint32_t index) const { return liveIndex[index] != noIndex; }
+	uint32_t generation(uint32_t index) const { return generations[index]; }
+	EntityHandle handle(uint32_t index) const { return { index, generations[index] }; }
+	// slots in use, in no particular order (despawn moves the last one into the gap)
+	const std::vector<uint32_t>& live() const { return liveSlots; }
+	size_t size() const { return liveSlots.size(); }
+	size_t capacity() const { return generations.size(); }
+
+private:
+	std::vector<uint32_t> generations;
+	std::vector<uint32_t> freeSlots;	// stack, the last slot freed on top (the lowest on top after reserve)
+	std::vector<uint32_t> liveSlots;	// dense list of the slots in use
+	std::vector<uint32_t> liveIndex;	// position of each slot in liveSlots, noIndex while it is free
+};
+
+#endif
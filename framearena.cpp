@@ -0,0 +1,216 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with
+* Custom Classes, Mulithreading, & OpenGL
+*
+* Description:
+* Frame arena. Transient per-frame containers (the render queue, sort
+* scratch, job data) bump-allocate from one of two blocks that alternate
+* every frame, instead of going through the heap. Every form of the global
+* operator new, aligned ones included, is replaced here with a counting
+* version, so the frame loop can check that a settled frame makes no heap
+* allocation at all; the arena takes its own blocks through the same
+* operator new, so its growth is counted.
+*
+*/
+
+// include standard headers
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+#include <atomic>
+#include <new>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+#include "framearena.hpp"
+
+/*
+***********************************************
+*		Allocation Counting
+***********************************************
+*/
+static atomic<unsigned long long> heapAllocations(0);
+
+unsigned long long heapAllocationCount()
+{
+	return heapAllocations.load(memory_order_relaxed);
+} // end heapAllocationCount method
+
+/* operator new and delete over malloc, counting every allocation */
+void* operator new(size_t bytes)
+{
+	heapAllocations.fetch_add(1, memory_order_relaxed);
+	void* memory = malloc(bytes > 0 ? bytes : 1);
+	if (memory == nullptr)
+	{
+		throw bad_alloc();
+	}
+	return memory;
+} // end operator new
+
+void* operator new[](size_t bytes)
+{
+	return operator new(bytes);
+} // end operator new[]
+
+void* operator new(size_t bytes, const nothrow_t&) noexcept
+{
+	heapAllocations.fetch_add(1, memory_order_relaxed);
+	return malloc(bytes > 0 ? bytes : 1);
+} // end nothrow operator new
+
+void* operator new[](size_t bytes, const nothrow_t& tag) noexcept
+{
+	return operator new(bytes, tag);
+} // end nothrow operator new[]
+
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete[](void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+void operator delete(void* memory, const nothrow_t&) noexcept { free(memory); }
+void operator delete[](void* memory, const nothrow_t&) noexcept { free(memory); }
+
+/* the over-aligned forms (alignas types such as the job queues) count through the same atomic */
+static void* alignedMalloc(size_t bytes, size_t alignment)
+{
+	bytes = bytes > 0 ? bytes : 1;
+#ifdef _WIN32
+	return _aligned_malloc(bytes, alignment);
+#else
+	void* memory = nullptr;
+	return posix_memalign(&memory, std::max(alignment, sizeof(void*)), bytes) == 0 ? memory : nullptr;
+#endif
+} // end alignedMalloc method
+
+static void alignedFree(void* memory)
+{
+#ifdef _WIN32
+	_aligned_free(memory);
+#else
+	free(memory);
+#endif
+} // end alignedFree method
+
+void* operator new(size_t bytes, align_val_t alignment)
+{
+	heapAllocations.fetch_add(1, memory_order_relaxed);
+	void* memory = alignedMalloc(bytes, (size_t)alignment);
+	if (memory == nullptr)
+	{
+		throw bad_alloc();
+	}
+	return memory;
+} // end aligned operator new
+
+void* operator new[](size_t bytes, align_val_t alignment)
+{
+	return operator new(bytes, alignment);
+} // end aligned operator new[]
+
+void* operator new(size_t bytes, align_val_t alignment, const nothrow_t&) noexcept
+{
+	heapAllocations.fetch_add(1, memory_order_relaxed);
+	return alignedMalloc(bytes, (size_t)alignment);
+} // end aligned nothrow operator new
+
+void* operator new[](size_t bytes, align_val_t alignment, const nothrow_t& tag) noexcept
+{
+	return operator new(bytes, alignment, tag);
+} // end aligned nothrow operator new[]
+
+void operator delete(void* memory, align_val_t) noexcept { alignedFree(memory); }
+void operator delete[](void* memory, align_val_t) noexcept { alignedFree(memory); }
+void operator delete(void* memory, size_t, align_val_t) noexcept { alignedFree(memory); }
+void operator delete[](void* memory, size_t, align_val_t) noexcept { alignedFree(memory); }
+void operator delete(void* memory, align_val_t, const nothrow_t&) noexcept { alignedFree(memory); }
+void operator delete[](void* memory, align_val_t, const nothrow_t&) noexcept { alignedFree(memory); }
+
+/*
+***********************************************
+*		Frame Arena
+***********************************************
+*/
+FrameArena::~FrameArena()
+{
+	for (Block& block : blocks)
+	{
+		reset(block);
+		operator delete(block.memory);
+	}
+} // end FrameArena destructor
+
+void FrameArena::init(size_t bytesPerFrame)
+{
+	for (Block& block : blocks)
+	{
+		reset(block);
+		operator delete(block.memory);
+		block.memory = static_cast<char*>(operator new(bytesPerFrame, nothrow));
+		block.size = block.memory != nullptr ? bytesPerFrame : 0;
+		block.requested = 0;
+		// room to record overflow without allocating while it happens
+		block.overflow.reserve(64);
+	}
+	current = 0;
+} // end init method
+
+void FrameArena::reset(Block& block)
+{
+	for (void* memory : block.overflow)
+	{
+		operator delete(memory);
+	}
+	block.overflow.clear();
+	block.used = 0;
+} // end reset method
+
+void FrameArena::beginFrame()
+{
+	current ^= 1;
+	Block& block = blocks[current];
+	reset(block);
+	// grow to what the block's last frame needed, with headroom, once instead of overflowing every frame
+	if (block.requested > block.size)
+	{
+		size_t size = block.requested + block.requested / 4;
+		char* memory = static_cast<char*>(operator new(size, nothrow));
+		if (memory != nullptr)
+		{
+			operator delete(block.memory);
+			block.memory = memory;
+			block.size = size;
+		}
+	}
+	block.requested = 0;
+} // end beginFrame method
+
+void* FrameArena::allocate(size_t bytes, size_t alignment)
+{
+	Block& block = blocks[current];
+	uintptr_t base = reinterpret_cast<uintptr_t>(block.memory);
+	size_t start = (size_t)(((base + block.used + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+	block.requested += bytes + alignment - 1;
+	if (block.memory != nullptr && start + bytes <= block.size)
+	{
+		block.used = start + bytes;
+		return block.memory + start;
+	}
+	// full: a heap piece freed with the frame (new's alignment covers every type the arena holds)
+	void* memory = operator new(bytes);
+	block.overflow.push_back(memory);
+	return memory;
+} // end allocate method
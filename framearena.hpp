@@ -0,0 +1,82 @@
+#ifndef FRAMEARENA_HPP
+#define FRAMEARENA_HPP
+
+#include <vector>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <stddef.h>
+
+/* FrameArena - bump allocator for data that only lives for a frame; two blocks take turns, so whatever a
+   frame allocates stays valid through the next one (for jobs still reading it) and is released all at once
+   when its block comes round again. Containers should reserve up front: growing abandons the old storage */
+class FrameArena
+{
+public:
+	~FrameArena();
+	// allocate both blocks
+	void init(size_t bytesPerFrame);
+	// start a frame: switch blocks and empty the one now in use; a block that overflowed when it was last
+	// used is regrown to fit first, so once frames stop growing they allocate nothing from the heap
+	void beginFrame();
+	// bytes at the given alignment, freed with the frame; falls back to the heap when the block is full
+	void* allocate(size_t bytes, size_t alignment);
+	template <typename T>
+	T* allocate(size_t count) { return static_cast<T*>(allocate(count * sizeof(T), alignof(T))); }
+	// construct a T for this frame; its destructor never runs, so T has to be trivially destructible
+	template <typename T, typename... Args>
+	T* create(Args&&... args)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "frame arena objects are never destroyed");
+		return new (allocate<T>(1)) T(std::forward<Args>(args)...);
+	}
+
+	// bytes handed out this frame and the size of its block
+	size_t used() const { return blocks[current].used; }
+	size_t capacity() const { return blocks[current].size; }
+
+private:
+	struct Block
+	{
+		char* memory = nullptr;
+		size_t size = 0;
+		size_t used = 0;
+		size_t requested = 0;			// bytes asked for while it was in use, overflow included
+		std::vector<void*> overflow;	// heap fallbacks, freed when the block is reset
+	};
+	void reset(Block& block);
+
+	Block blocks[2];
+	int current = 0;
+};
+
+/* FrameAllocator - standard allocator over a FrameArena; deallocate does nothing, the frame frees it all */
+template <typename T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+
+	FrameAllocator(FrameArena& frameArena) : arena(&frameArena) {}
+	template <typename U>
+	FrameAllocator(const FrameAllocator<U>& other) : arena(other.arena) {}
+
+	T* allocate(size_t count) { return arena->allocate<T>(count); }
+	void deallocate(T*, size_t) {}
+
+	template <typename U>
+	bool operator==(const FrameAllocator<U>& other) const { return arena == other.arena; }
+	template <typename U>
+	bool operator!=(const FrameAllocator<U>& other) const { return arena != other.arena; }
+
+	FrameArena* arena;
+};
+
+// vector whose storage comes from a frame arena
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+// heap allocations made through any form of operator new by every thread so far (framearena.cpp replaces them to count them)
+unsigned long long heapAllocationCount();
+
+#endif
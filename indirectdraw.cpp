@@ -0,0 +1,367 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* GPU driven scene submission. Every mesh shares one set of vertex/index
+* buffers, a compute shader frustum culls each entity and writes its
+* indirect draw command, and the frame is drawn with a single
+* glMultiDrawElementsIndirect call. Vertices are stored either as plain
+* floats or, optionally, compressed: positions quantized to 16 bits in
+* the mesh's bounding box, normals octahedral encoded in two 16-bit
+* values and uvs as half floats, all decoded in the vertex shader.
+* 
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// include GLEW
+#include <GL/glew.h>
+
+// include GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+using namespace glm;
+using namespace std;
+
+#include "indirectdraw.hpp"
+#include "shaderpermutations.hpp"
+#include "jobsystem.hpp"
+
+// work group size declared in CullEntities.computeshader
+const GLuint cullGroupSize = 64;
+// entities per sort-key job, only large scenes are split
+const size_t sortKeyGrain = 1024;
+
+/* compile the culling shader and create every buffer the renderer owns */
+bool IndirectRenderer::init(const char* cullShaderPath, bool compressedVertices)
+{
+	compressed = compressedVertices;
+	cullProgramID = LoadComputeShader(cullShaderPath);
+	if (cullProgramID == 0)
+	{
+		return false;
+	}
+	frustumPlanesID = glGetUniformLocation(cullProgramID, "frustumPlanes");
+	entityCountID = glGetUniformLocation(cullProgramID, "entityCount");
+
+	glGenVertexArrays(1, &vertexArrayID);
+	glGenBuffers(1, &vertexBuffer);
+	glGenBuffers(1, &uvBuffer);
+	glGenBuffers(1, &normalBuffer);
+	glGenBuffers(1, &elementBuffer);
+	glGenBuffers(1, &entityIndexBuffer);
+	glGenBuffers(1, &entityBuffer);
+	glGenBuffers(1, &meshBuffer);
+	glGenBuffers(1, &commandBuffer);
+	return true;
+} // end init method
+
+/* map a unit normal onto the octahedron |x|+|y|+|z| = 1 and unfold the lower half over the upper one,
+   the inverse is octahedralDecode in StandardShading.vertexshader */
+static vec2 octahedralEncode(vec3 normal)
+{
+	float sum = fabs(normal.x) + fabs(normal.y) + fabs(normal.z);
+	if (sum == 0.0f)
+	{
+		return vec2(0.0f);
+	}
+	normal /= sum;
+	vec2 encoded = vec2(normal.x, normal.y);
+	if (normal.z < 0.0f)
+	{
+		encoded = vec2((1.0f - fabs(normal.y)) * (normal.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - fabs(normal.x)) * (normal.y >= 0.0f ? 1.0f : -1.0f));
+	}
+	return encoded;
+} // end octahedralEncode method
+
+static inline GLshort snorm16(float value)
+{
+	return (GLshort)roundf(clamp(value, -1.0f, 1.0f) * 32767.0f);
+} // end snorm16 method
+
+/* append a mesh to the shared buffers and remember where it lives */
+GLuint IndirectRenderer::addMesh(const vector<vec3>& meshVertices, const vector<vec2>& meshUVs,
+	const vector<vec3>& meshNormals, const vector<unsigned short>& meshIndices)
+{
+	MeshRange range;
+	range.firstIndex = (GLuint)indices.size();
+	range.indexCount = (GLuint)meshIndices.size();
+	range.baseVertex = vertexCount;
+	range.padding = 0;
+
+	// bounding sphere around the center of the mesh's bounding box
+	vec3 minCorner = meshVertices.empty() ? vec3(0.0f) : meshVertices[0];
+	vec3 maxCorner = minCorner;
+	for (const auto& vertex : meshVertices)
+	{
+		minCorner = min(minCorner, vertex);
+		maxCorner = max(maxCorner, vertex);
+	}
+	vec3 center = (minCorner + maxCorner) * 0.5f;
+	float radius = 0.0f;
+	for (const auto& vertex : meshVertices)
+	{
+		radius = max(radius, length(vertex - center));
+	}
+	range.boundingSphere = vec4(center, radius);
+	vec3 extent = maxCorner - minCorner;
+	range.positionOffset = vec4(minCorner, 0.0f);
+	range.positionScale = vec4(extent, 0.0f);
+
+	if (compressed)
+	{
+		// quantized corners may move half a step, keep them inside the culling sphere
+		range.boundingSphere.w += length(extent) / 65535.0f;
+		for (size_t i = 0; i < meshVertices.size(); i++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float unit = extent[axis] > 0.0f ? (meshVertices[i][axis] - minCorner[axis]) / extent[axis] : 0.0f;
+				packedPositions.push_back((GLushort)roundf(clamp(unit, 0.0f, 1.0f) * 65535.0f));
+			}
+			packedUVs.push_back(packHalf2x16(meshUVs[i]));
+			vec2 normal = octahedralEncode(meshNormals[i]);
+			packedNormals.push_back(snorm16(normal.x));
+			packedNormals.push_back(snorm16(normal.y));
+		}
+	}
+	else
+	{
+		vertices.insert(vertices.end(), meshVertices.begin(), meshVertices.end());
+		uvs.insert(uvs.end(), meshUVs.begin(), meshUVs.end());
+		normals.insert(normals.end(), meshNormals.begin(), meshNormals.end());
+	}
+	vertexCount += (GLint)meshVertices.size();
+	indices.insert(indices.end(), meshIndices.begin(), meshIndices.end());
+	meshes.push_back(range);
+	return (GLuint)(meshes.size() - 1);
+} // end addMesh method
+
+/* upload the shared geometry and the mesh table, then describe the vertex layout */
+void IndirectRenderer::uploadMeshes()
+{
+	glBindVertexArray(vertexArrayID);
+
+	if (compressed)
+	{
+		// 1st attribute buffer : positions as unorm16, 0..1 across the mesh's bounding box
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, packedPositions.size() * sizeof(GLushort), packedPositions.data(), GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, 3 * sizeof(GLushort), (void*)0);
+		// 2nd attribute buffer : UVs as half floats
+		glBindBuffer(GL_ARRAY_BUFFER, uvBuffer);
+		glBufferData(GL_ARRAY_BUFFER, packedUVs.size() * sizeof(GLuint), packedUVs.data(), GL_STATIC_DRAW);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, 0, (void*)0);
+		// 3rd attribute buffer : octahedral normals as snorm16
+		glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
+		glBufferData(GL_ARRAY_BUFFER, packedNormals.size() * sizeof(GLshort), packedNormals.data(), GL_STATIC_DRAW);
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_SHORT, GL_TRUE, 0, (void*)0);
+	}
+	else
+	{
+		// 1st attribute buffer : vertices
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vec3), vertices.data(), GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+		// 2nd attribute buffer : UVs
+		glBindBuffer(GL_ARRAY_BUFFER, uvBuffer);
+		glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(vec2), uvs.data(), GL_STATIC_DRAW);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+		// 3rd attribute buffer : normals
+		glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
+		glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(vec3), normals.data(), GL_STATIC_DRAW);
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+	}
+	// 4th attribute buffer : entity index, advanced once per instance so baseInstance selects the entity
+	glBindBuffer(GL_ARRAY_BUFFER, entityIndexBuffer);
+	glEnableVertexAttribArray(3);
+	glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, 0, (void*)0);
+	glVertexAttribDivisor(3, 1);
+	// index buffer
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+
+	// mesh table read by the culling shader
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, meshBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, meshes.size() * sizeof(MeshRange), meshes.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+} // end uploadMeshes method
+
+/* grow the per-entity buffers so they can hold count entities */
+void IndirectRenderer::reserveEntities(GLuint count)
+{
+	if (count <= entityCapacity)
+	{
+		return;
+	}
+	entityCapacity = max(count, entityCapacity * 2);
+
+	// instance attribute holding 0, 1, 2, ... so each command can address its entity
+	vector<GLuint> entityIndices(entityCapacity);
+	for (GLuint i = 0; i < entityCapacity; i++)
+	{
+		entityIndices[i] = i;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, entityIndexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, entityCapacity * sizeof(GLuint), entityIndices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, entityBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, entityCapacity * sizeof(EntityInstance), NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, entityCapacity * sizeof(DrawElementsIndirectCommand), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+} // end reserveEntities method
+
+/* reorder the entities nearest first so early depth testing rejects hidden fragments */
+void IndirectRenderer::sortFrontToBack(EntityList& entities, const mat4& view)
+{
+	// view-space distance of each bounding sphere center in front of the camera
+	FrameVector<pair<float, GLuint>> sortKeys(entities.get_allocator());
+	sortKeys.resize(entities.size());
+	jobs.parallelFor(entities.size(), sortKeyGrain, [&](size_t begin, size_t end)
+	{
+		for (GLuint i = (GLuint)begin; i < (GLuint)end; i++)
+		{
+			const vec4& sphere = meshes[entities[i].meshID].boundingSphere;
+			vec4 center = view * (entities[i].model * vec4(sphere.x, sphere.y, sphere.z, 1.0f));
+			sortKeys[i] = make_pair(-center.z, i);
+		}
+	});
+	sort(sortKeys.begin(), sortKeys.end());
+
+	// gather in sorted order, then hand the storage back to the caller
+	EntityList sortedEntities(entities.get_allocator());
+	sortedEntities.reserve(entities.size());
+	for (const auto& key : sortKeys)
+	{
+		sortedEntities.push_back(entities[key.second]);
+	}
+	entities.swap(sortedEntities);
+} // end sortFrontToBack method
+
+/* upload this frame's entities and let the culling shader write their draw commands */
+void IndirectRenderer::cull(const EntityList& entities, const mat4& viewProjection)
+{
+	GLuint entityCount = (GLuint)entities.size();
+	culledEntityCount = entityCount;
+	culledTriangleCount = 0;
+	if (entityCount == 0)
+	{
+		return;
+	}
+	for (const EntityInstance& entity : entities)
+	{
+		culledTriangleCount += meshes[entity.meshID].indexCount / 3;
+	}
+	reserveEntities(entityCount);
+
+	// upload this frame's entities
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, entityBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, entityCount * sizeof(EntityInstance), entities.data());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// extract the six frustum planes (Gribb/Hartmann) from the view-projection rows
+	vec4 planes[6];
+	for (int i = 0; i < 3; i++)
+	{
+		vec4 row = vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+		vec4 row3 = vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+		planes[i * 2] = row3 + row;
+		planes[i * 2 + 1] = row3 - row;
+	}
+	for (auto& plane : planes)
+	{
+		plane /= length(vec3(plane.x, plane.y, plane.z));
+	}
+
+	// frustum test every entity and write its draw command
+	GLint previousProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+	glUseProgram(cullProgramID);
+	glUniform4fv(frustumPlanesID, 6, &planes[0][0]);
+	glUniform1ui(entityCountID, entityCount);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, entityBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, meshBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+	glDispatchCompute((entityCount + cullGroupSize - 1) / cullGroupSize, 1, 1);
+	// commands must be visible to the indirect draw below
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+	glUseProgram(previousProgram);
+} // end cull method
+
+/* draw every command written by the last cull() with a single call */
+void IndirectRenderer::submit()
+{
+	if (culledEntityCount == 0)
+	{
+		return;
+	}
+
+	// the vertex shader reads the model matrices from the entity buffer and the decode ranges from the mesh table
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, entityBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, meshBuffer);
+
+	// draw the triangles !
+	glBindVertexArray(vertexArrayID);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glMultiDrawElementsIndirect
+	(
+		GL_TRIANGLES,		// mode
+		GL_UNSIGNED_SHORT,	// type
+		(void*)0,			// indirect buffer offset
+		culledEntityCount,	// draw count
+		0					// tightly packed commands
+	);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+	renderStats.drawCalls++;
+	renderStats.triangles += culledTriangleCount;
+} // end submit method
+
+/* cull on the GPU and draw every visible entity with one call */
+void IndirectRenderer::draw(const EntityList& entities, const mat4& viewProjection)
+{
+	cull(entities, viewProjection);
+	submit();
+} // end draw method
+
+/* delete every buffer and program owned by the renderer */
+void IndirectRenderer::cleanup()
+{
+	glDeleteBuffers(1, &vertexBuffer);
+	glDeleteBuffers(1, &uvBuffer);
+	glDeleteBuffers(1, &normalBuffer);
+	glDeleteBuffers(1, &elementBuffer);
+	glDeleteBuffers(1, &entityIndexBuffer);
+	glDeleteBuffers(1, &entityBuffer);
+	glDeleteBuffers(1, &meshBuffer);
+	glDeleteBuffers(1, &commandBuffer);
+	glDeleteVertexArrays(1, &vertexArrayID);
+	glDeleteProgram(cullProgramID);
+} // end cleanup method
@@ -0,0 +1,112 @@
+#ifndef INDIRECTDRAW_HPP
+#define INDIRECTDRAW_HPP
+
+#include <vector>
+#include <utility>
+
+#include "framearena.hpp"
+
+/* MeshRange - where one mesh lives inside the shared scene buffers, matches the std430 "Mesh" struct */
+struct MeshRange
+{
+	GLuint firstIndex;
+	GLuint indexCount;
+	GLint baseVertex;
+	GLuint padding;
+	glm::vec4 boundingSphere; // model space center (xyz) and radius (w)
+	glm::vec4 positionOffset; // compressed positions decode to offset + unorm16 * scale (xyz)
+	glm::vec4 positionScale;
+};
+
+/* EntityInstance - one drawable object, laid out to match the std430 "Entity" struct in the shaders */
+struct EntityInstance
+{
+	glm::mat4 model;
+	GLuint meshID;
+	GLint textureLayer;
+	GLuint padding[2];
+};
+
+// the entities of one frame, kept in that frame's arena
+typedef FrameVector<EntityInstance> EntityList;
+
+/* DrawElementsIndirectCommand - layout consumed by glMultiDrawElementsIndirect */
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+/* RenderStats - what the renderer has submitted since it started; triangles are counted before the GPU
+   culls them, so they are an upper bound on what was drawn */
+struct RenderStats
+{
+	unsigned long long drawCalls = 0;
+	unsigned long long triangles = 0;
+};
+
+/* IndirectRenderer - draws the whole scene with one multi-draw-indirect call built by a culling compute shader */
+class IndirectRenderer
+{
+public:
+	// compile the culling compute shader and create the GL buffers; with compressedVertices every mesh is
+	// stored as 16-bit positions in its bounding box, octahedral normals and half-float uvs (14 bytes instead
+	// of 32), which the shaders must decode (SHADER_COMPRESSED_VERTICES)
+	bool init(const char* cullShaderPath, bool compressedVertices = false);
+	// append a mesh to the shared scene buffers, returns its mesh ID
+	GLuint addMesh(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec2>& uvs,
+		const std::vector<glm::vec3>& normals, const std::vector<unsigned short>& indices);
+	// upload every mesh added so far to the GPU
+	void uploadMeshes();
+	// reorder entities nearest first by the view-space depth of their bounding spheres (scratch comes from their arena)
+	void sortFrontToBack(EntityList& entities, const glm::mat4& view);
+	// upload the entities and build their draw commands with the culling shader
+	void cull(const EntityList& entities, const glm::mat4& viewProjection);
+	// draw the entities of the last cull() with one call, using the current program (may be repeated per pass)
+	void submit();
+	// cull and submit in one step
+	void draw(const EntityList& entities, const glm::mat4& viewProjection);
+	// release GL objects
+	void cleanup();
+
+	const MeshRange& mesh(GLuint meshID) const { return meshes[meshID]; }
+	bool compressedVertices() const { return compressed; }
+	const RenderStats& stats() const { return renderStats; }
+
+private:
+	void reserveEntities(GLuint count);
+
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	// compressed format: 3 x unorm16 position, 2 x half uv, 2 x snorm16 octahedral normal per vertex
+	std::vector<GLushort> packedPositions;
+	std::vector<GLuint> packedUVs;
+	std::vector<GLshort> packedNormals;
+	GLint vertexCount = 0;
+	std::vector<unsigned short> indices;
+	std::vector<MeshRange> meshes;
+
+	GLuint cullProgramID = 0;
+	GLuint frustumPlanesID = 0;
+	GLuint entityCountID = 0;
+	GLuint vertexArrayID = 0;
+	GLuint vertexBuffer = 0;
+	GLuint uvBuffer = 0;
+	GLuint normalBuffer = 0;
+	GLuint elementBuffer = 0;
+	GLuint entityIndexBuffer = 0;
+	GLuint entityBuffer = 0;
+	GLuint meshBuffer = 0;
+	GLuint commandBuffer = 0;
+	GLuint entityCapacity = 0;
+	GLuint culledEntityCount = 0;
+	unsigned long long culledTriangleCount = 0;
+	RenderStats renderStats;
+	bool compressed = false;
+};
+
+#endif
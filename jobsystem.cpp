@@ -0,0 +1,243 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Work-stealing job scheduler. Each worker owns a deque: it pushes and
+* pops its own jobs at the back (newest first, still warm in cache) and,
+* when it runs dry, steals from the front of another worker's deque.
+* Threads that are not workers (the render and physics threads) spread
+* their jobs round robin and run jobs themselves while they wait, so a
+* wait never leaves a core idle and nested waits cannot deadlock.
+* 
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+#include "jobsystem.hpp"
+
+JobSystem jobs;
+
+// deque owned by the current thread, -1 on threads that are not workers
+static thread_local int currentWorker = -1;
+// rounds of stealing an idle worker tries before it goes to sleep
+const int idleSpins = 64;
+// starting size of each worker's ring of jobs
+const size_t initialQueueJobs = 256;
+
+/*
+***********************************************
+*		Workers
+***********************************************
+*/
+void JobSystem::start(unsigned int workerCount)
+{
+	stop();
+	stopping = false;
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		queues.push_back(unique_ptr<WorkerQueue>(new WorkerQueue()));
+		queues.back()->ring.resize(initialQueueJobs);
+	}
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		workers.emplace_back(&JobSystem::workerLoop, this, i);
+	}
+} // end start method
+
+void JobSystem::stop()
+{
+	if (workers.empty())
+	{
+		return;
+	}
+	stopping = true;
+	{
+		lock_guard<mutex> lock(sleepLock);
+	}
+	wakeUp.notify_all();
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+	workers.clear();
+	queues.clear();
+} // end stop method
+
+void JobSystem::workerLoop(unsigned int index)
+{
+	currentWorker = (int)index;
+	int idle = 0;
+	while (true)
+	{
+		Job job;
+		if (findJob(job))
+		{
+			execute(job);
+			idle = 0;
+			continue;
+		}
+		// leave only once every queued job has run
+		if (stopping.load())
+		{
+			break;
+		}
+		if (++idle < idleSpins)
+		{
+			this_thread::yield();
+			continue;
+		}
+		// sleep until something is queued; sleepingWorkers is raised before queuedJobs is checked,
+		// so a push either sees the sleeper or the sleeper sees the push
+		unique_lock<mutex> lock(sleepLock);
+		sleepingWorkers++;
+		wakeUp.wait(lock, [this] { return queuedJobs.load() > 0 || stopping.load(); });
+		sleepingWorkers--;
+		idle = 0;
+	}
+	currentWorker = -1;
+} // end workerLoop method
+
+/*
+***********************************************
+*		Queues
+***********************************************
+*/
+void JobSystem::push(const Job& job)
+{
+	unsigned int queue = currentWorker >= 0 ? (unsigned int)currentWorker
+		: nextQueue.fetch_add(1, memory_order_relaxed) % (unsigned int)queues.size();
+	{
+		WorkerQueue& target = *queues[queue];
+		lock_guard<mutex> lock(target.lock);
+		// full: unroll into a ring twice the size
+		if (target.count == target.ring.size())
+		{
+			vector<Job> grown(target.ring.size() * 2);
+			for (size_t i = 0; i < target.count; i++)
+			{
+				grown[i] = target.ring[(target.first + i) & (target.ring.size() - 1)];
+			}
+			target.ring.swap(grown);
+			target.first = 0;
+		}
+		target.ring[(target.first + target.count) & (target.ring.size() - 1)] = job;
+		target.count++;
+	}
+	queuedJobs++;
+	if (sleepingWorkers.load() > 0)
+	{
+		{
+			lock_guard<mutex> lock(sleepLock);
+		}
+		wakeUp.notify_one();
+	}
+} // end push method
+
+/* own deque from the back, then every other deque from the front */
+bool JobSystem::findJob(Job& job)
+{
+	if (queuedJobs.load(memory_order_relaxed) <= 0)
+	{
+		return false;
+	}
+	unsigned int queueCount = (unsigned int)queues.size();
+	unsigned int first = currentWorker >= 0 ? (unsigned int)currentWorker : 0;
+	for (unsigned int n = 0; n < queueCount; n++)
+	{
+		WorkerQueue& queue = *queues[(first + n) % queueCount];
+		lock_guard<mutex> lock(queue.lock);
+		if (queue.count == 0)
+		{
+			continue;
+		}
+		size_t mask = queue.ring.size() - 1;
+		if (n == 0 && currentWorker >= 0)
+		{
+			job = queue.ring[(queue.first + queue.count - 1) & mask];
+		}
+		else
+		{
+			job = queue.ring[queue.first];
+			queue.first = (queue.first + 1) & mask;
+		}
+		queue.count--;
+		queuedJobs--;
+		return true;
+	}
+	return false;
+} // end findJob method
+
+void JobSystem::execute(Job& job)
+{
+	if (job.dependency != nullptr)
+	{
+		wait(*job.dependency);
+	}
+	job.function(job.data, job.begin, job.end);
+	job.counter->pending.fetch_sub(1, memory_order_acq_rel);
+} // end execute method
+
+/*
+***********************************************
+*		Submission
+***********************************************
+*/
+void JobSystem::run(JobFunction function, void* data, size_t begin, size_t end, JobCounter& counter, JobCounter* dependency)
+{
+	Job job = { function, data, begin, end, &counter, dependency };
+	counter.pending.fetch_add(1, memory_order_relaxed);
+	if (workers.empty())
+	{
+		execute(job);
+		return;
+	}
+	push(job);
+} // end run method
+
+/* heap copy of a callable, deleted by the job that runs it */
+static void runTask(void* data, size_t, size_t)
+{
+	function<void()>* task = static_cast<function<void()>*>(data);
+	(*task)();
+	delete task;
+} // end runTask method
+
+void JobSystem::run(function<void()> task, JobCounter& counter, JobCounter* dependency)
+{
+	run(&runTask, new function<void()>(move(task)), 0, 0, counter, dependency);
+} // end run method
+
+void JobSystem::wait(JobCounter& counter)
+{
+	while (!counter.done())
+	{
+		Job job;
+		if (findJob(job))
+		{
+			execute(job);
+		}
+		else
+		{
+			this_thread::yield();
+		}
+	}
+} // end wait method
@@ -0,0 +1,123 @@
+#ifndef JOBSYSTEM_HPP
+#define JOBSYSTEM_HPP
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+// work on items [begin, end) with data
+typedef void (*JobFunction)(void* data, size_t begin, size_t end);
+
+/* JobCounter - jobs still running in a group; wait() on it to join them */
+struct JobCounter
+{
+	std::atomic<int> pending{0};
+	bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+/* Job - one unit of work queued on a worker */
+struct Job
+{
+	JobFunction function;
+	void* data;
+	size_t begin, end;
+	JobCounter* counter;		// decremented once the job has run
+	JobCounter* dependency;		// must drain before the job starts (may be null)
+};
+
+/* JobSystem - worker threads with one deque each; owners take their newest job, idle workers steal the oldest of another */
+class JobSystem
+{
+public:
+	~JobSystem() { stop(); }
+
+	// spawn workerCount workers (0 runs every job inline on the submitting thread)
+	void start(unsigned int workerCount);
+	// finish the queued jobs and join the workers
+	void stop();
+	unsigned int workerCount() const { return (unsigned int)workers.size(); }
+
+	// queue function(data, begin, end); counter is incremented now and decremented when it has run,
+	// and the job does not start before dependency (if any) has drained
+	void run(JobFunction function, void* data, size_t begin, size_t end, JobCounter& counter, JobCounter* dependency = nullptr);
+	// queue any callable, copied to the heap
+	void run(std::function<void()> task, JobCounter& counter, JobCounter* dependency = nullptr);
+	// run queued jobs on this thread until counter drains
+	void wait(JobCounter& counter);
+
+	// body(begin, end) over [0, count) split into chunks of at least grain items, spread over the workers;
+	// returns once every chunk has run, runs inline when there are no workers or too few items
+	template <typename Body>
+	void parallelFor(size_t count, size_t grain, const Body& body);
+
+private:
+	/* WorkerQueue - one worker's deque as a ring buffer that only grows when full, so queuing a job never
+	   touches the heap once it has reached its working size; padded so neighbouring locks do not share a cache line */
+	struct alignas(64) WorkerQueue
+	{
+		std::mutex lock;
+		std::vector<Job> ring;	// power-of-two size
+		size_t first = 0;		// oldest job
+		size_t count = 0;
+	};
+
+	template <typename Body>
+	static void invokeRange(void* data, size_t begin, size_t end) { (*static_cast<const Body*>(data))(begin, end); }
+
+	void push(const Job& job);
+	bool findJob(Job& job);
+	void execute(Job& job);
+	void workerLoop(unsigned int index);
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+	std::vector<std::thread> workers;
+	std::atomic<unsigned int> nextQueue{0};		// round robin for jobs queued by non-worker threads
+	std::atomic<int> queuedJobs{0};
+	std::atomic<int> sleepingWorkers{0};
+	std::atomic<bool> stopping{false};
+	std::mutex sleepLock;
+	std::condition_variable wakeUp;
+};
+
+// the job system shared by physics, rendering and asset loading
+extern JobSystem jobs;
+
+// chunks larger than this are kept a multiple of it, so SIMD loops and cache lines do not straddle two jobs
+const size_t jobChunkAlignment = 16;
+
+template <typename Body>
+void JobSystem::parallelFor(size_t count, size_t grain, const Body& body)
+{
+	grain = std::max(grain, (size_t)1);
+	if (workers.empty() || count <= grain)
+	{
+		if (count > 0)
+		{
+			body((size_t)0, count);
+		}
+		return;
+	}
+	// a few chunks per thread so stealing can even out uneven work
+	size_t chunkCount = std::min((count + grain - 1) / grain, (workers.size() + 1) * 4);
+	size_t chunk = (count + chunkCount - 1) / chunkCount;
+	if (chunk > jobChunkAlignment)
+	{
+		chunk = (chunk + jobChunkAlignment - 1) / jobChunkAlignment * jobChunkAlignment;
+	}
+
+	JobCounter counter;
+	for (size_t begin = chunk; begin < count; begin += chunk)
+	{
+		run(&invokeRange<Body>, (void*)&body, begin, std::min(begin + chunk, count), counter);
+	}
+	// the calling thread takes the first chunk, then helps with the rest
+	body((size_t)0, std::min(chunk, count));
+	wait(counter);
+} // end parallelFor method
+
+#endif
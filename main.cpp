@@ -23,10 +23,81 @@
 *	- 'up' and 'down' arrow keys zoom in and out (controls.cpp)
 *	- 'left' and 'right' arrow keys rotate camera view left and right (controls.cpp)
 *	- 'u' and 'd' keys rotate camera up and down (controls.cpp)
+*	- 'b' spawns a burst of copies of the scene's moving objects, 'n' despawns a burst (controls.cpp)
 *	- 'esc' key ends application
+*	- command line options:
+*		--no-lighting, --specular, --no-internal-light  pick the shader permutation
+*		--scene file                                  text .scene or compiled scene to show (default halloween.scene)
+*		--compile-scene out                           write the --scene in compiled form to out and exit
+*		--generate-scene N out                        copy the --scene's entities up to N entities, compile to out and exit
+*		--record file                                 stream every physics tick (transforms and contacts) to a trace file
+*		--replay file                                 draw a recorded trace instead of running physics (scene from the trace)
+*		--trace-info file                             print the length, size and contact counts of a trace and exit
+*		--batch K [ticks]                             step K copies of the scene's physics headless and print ticks/s (default 600 ticks)
+*		--batch-packed                                pack small --batch worlds together so SIMD runs across worlds
+*		--lights N                                    add N random point lights (clustered lighting stress)
+*		--spawn-capacity N                            slots for objects spawned at runtime (default 256)
+*		--spawn-burst N                               objects per spawn or despawn burst (default 16)
+*		--churn N                                     spawn and despawn N bursts a second (pool stress)
+*		--front-to-back                               draw opaque objects nearest first
+*		--depth-prepass                               lay down depth first, shade each pixel once
+*		--dynamic-resolution [ms]                     scale the render resolution to hold a GPU frame time (default 16.6)
+*		--aa none|msaa2|msaa4|msaa8|fxaa              anti-aliasing mode (default msaa4)
+*		--idle-fps N                                  redraws per second while only the flicker changes (default 10)
+*		--no-idle                                     redraw every iteration, as before
+*		--metrics [port]                              serve Prometheus metrics on 127.0.0.1:port/metrics (default 9464)
+*		--metrics-csv file [seconds]                  append a CSV row of every metric to file each interval (default 1)
+*		--check-allocations [N]                       fail unless N settled frames in a row make no heap allocation (default 300)
+*		--compressed-vertices                         16-bit positions, octahedral normals, half-float uvs (14 bytes per vertex)
+*		--bench-fillrate                              4K fill-rate benchmark of every permutation
+*		--bench-aa                                    1080p frame time and framebuffer traffic of every anti-aliasing mode
+*		--physics-kernel scalar|sse2|avx2             force the physics instruction set (default: best supported)
+*		--physics-hz N                                physics tick rate (default 60, lower saves CPU)
+*		--bench-physics                               time every physics kernel on a large mover set, then check large ticks for tunnelling
+*		--jobs N                                      worker threads of the job system (0 runs every job inline)
+*		--bench-jobs                                  job dispatch overhead and parallel_for scaling per worker count
+*		--bench-obj [file.obj ...]                    loadOBJ vs the parallel parser (default: scene meshes + a large generated one)
+*		--bench-index                                 indexVBO vs the hash-table vertex indexers
+*	- the meshes, textures, moving and static objects, lights and bounds come from a scene file (scene.cpp);
+*	  its compiled form is memory mapped and copied column by column into the physics arrays
 *	- objects do not move until 'g' key is pressed (controls.cpp)
+*	- entity pool: objects spawn and despawn mid-simulation in O(1) by recycling preallocated slots,
+*	  handed out through a free list with generation-checked handles (entitypool.cpp), so the arrays
+*	  the physics and render threads walk are never reallocated
+*	- idle mode: while the camera and objects are still, the loop sleeps in glfwWaitEventsTimeout and
+*	  redraws only for the light flicker, a few times a second, instead of every iteration
 *	- objects move and rotate randomly about the area
-*	- objects collide and bounce off each other and the floor
+*	- objects collide and bounce off each other, the floor, the background and the window boundaries
+*	- fixed-tick physics: swept-sphere collision, mass-based impulses, resting objects sleep
+*	- physics runs on its own thread, concurrently with rendering, and hands each tick's
+*	  transforms to the render thread through a lock-free triple buffer
+*	- work-stealing job system: meshes and textures decode in parallel, light binning overlaps
+*	  render-queue building, and large physics and sort passes are split over the workers
+*	- .obj files are memory mapped and parsed in parallel chunks (objparser.cpp), repeated
+*	  vertices are merged through a hash table sharded over the workers (vertexindexer.cpp)
+*	- assets load in the background while a placeholder scene is drawn; each one appears as soon
+*	  as it has been decoded, textures are streamed to the GPU through a pixel buffer object
+*	- mesh-accurate collisions from a per-mesh BVH (cached as <mesh>.obj.bvh)
+*	- quaternion transforms with cached world matrices, rebuilt in parallel only for entities that moved;
+*	  the meshes' constant stand-up rotation is baked into their vertices at load
+*	- every texture packed into one texture array, sampled by layer per object
+*	- objects frustum culled on the GPU and drawn with a single multi-draw-indirect call
+*	- optional compressed vertex format decoded in the vertex shader, less than half the vertex bandwidth
+*	- optional dynamic resolution: GPU timer queries steer the size of an offscreen MSAA target, which is
+*	  stretched over the window, so frame time holds when entity or light counts spike
+*	- selectable anti-aliasing: none, 2/4/8x MSAA, or an FXAA post-process pass over a single-sampled
+*	  offscreen frame, a fraction of the memory and bandwidth of MSAA
+*	- simulation traces: every tick recorded losslessly by a background writer thread, replayed into the
+*	  renderer without physics, so a run can be profiled or reproduced exactly (simulationtrace.cpp)
+*	- headless batch mode: K independent copies of the scene's physics over one shared set of mesh trees,
+*	  stepped in lockstep on the job system, one store per world or packed side by side (batchrunner.cpp)
+*	- metrics: frame and physics tick time histograms, draw call, triangle, collision pair and entity counts,
+*	  recorded per thread without locks and served as Prometheus text on localhost or dumped to CSV (metrics.cpp)
+*	- per-frame arena: the render queue, sort scratch and job data of a frame come from one of two
+*	  alternating blocks (framearena.cpp), so a settled frame makes no heap allocation
+*	- optional front-to-back ordering and depth pre-pass to limit overdraw
+*	- clustered forward lighting with a flickering candle inside each pumpkin
+*	- SSE2/AVX2 movement and collision kernels picked at runtime, scalar fallback
 * 
 * References:
 * Tutorial 9 Base Code from https://www.opengl-tutorial.org/
@@ -36,11 +107,14 @@
 // include standard headers
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <vector>
 #include <thread>
-#include <mutex>
+#include <atomic>
+#include <chrono>
 #include <ctime>
 #include <cstdlib>
+#include <random>
 
 // include GLEW
 #include <GL/glew.h>
@@ -52,6 +126,7 @@ GLFWwindow* window;
 // include GLM
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include <common/shader.hpp>
 #include <common/texture.hpp>
@@ -60,6 +135,26 @@ GLFWwindow* window;
 #include <common/vboindexer.hpp>
 #include <iostream>
 
+#include "texturearray.hpp"
+#include "indirectdraw.hpp"
+#include "shaderpermutations.hpp"
+#include "benchmarks.hpp"
+#include "clusteredlights.hpp"
+#include "physics.hpp"
+#include "meshbvh.hpp"
+#include "transformsnapshots.hpp"
+#include "jobsystem.hpp"
+#include "assetloader.hpp"
+#include "transformtable.hpp"
+#include "dynamicresolution.hpp"
+#include "antialiasing.hpp"
+#include "scene.hpp"
+#include "entitypool.hpp"
+#include "framearena.hpp"
+#include "simulationtrace.hpp"
+#include "batchrunner.hpp"
+#include "metrics.hpp"
+
 using namespace std;
 using namespace glm;
 
@@ -68,43 +163,6 @@ using namespace glm;
 *		Custom Class Declarations 
 ***********************************************
 */
-/* Object Class - for objects that move and collide with each other*/
-class Object
-{
-public:
-	vector<vec3> vertices;
-	vector<vec2> uvs;
-	vector<vec3> normals;
-	vector<unsigned short> indices;
-	bool moving;
-	vec3 position;
-	vec3 velocity;
-	vec3 rotation;
-	vec3 rotationSpeed;
-	float radius;
-
-	// constructor for Object class
-	Object(const vector<vec3>& vertices, const vector<vec2>& uvs, const vector<vec3>& normals, 
-		const vector<unsigned short>& indices, vec3 position, vec3 velocity, vec3 rotation, vec3 rotationSpeed, float radius) :
-		vertices(vertices), uvs(uvs), normals(normals), indices(indices), moving(false), position(position),
-		velocity(velocity), rotation(rotation), rotationSpeed(rotationSpeed), radius(radius) {}
-
-}; // end class definition for 3D Object
-/* StaticObject Class - for static objects that add to the scene */
-class StaticObject
-{
-public:
-	vector<vec3> vertices;
-	vector<vec2> uvs;
-	vector<vec3> normals;
-	vector<unsigned short> indices;
-	
-	// constructor for Static_Object class
-	StaticObject(const vector<vec3>& vertices, const vector<vec2>& uvs, const vector<vec3>& normals, 
-		const vector<unsigned short>& indices) :
-		vertices(vertices), uvs(uvs), normals(normals), indices(indices) {}
-
-}; // end class definition for 3D Static Object
 /* Floor Class */
 class Floor
 {
@@ -184,19 +242,33 @@ public:
 
 }; // end class definition for the background
 
+/* world bounds - the floor and background are solid, the window boundaries close off the rest */
+void addSceneBounds(WorldBounds& worldBounds, const SceneBounds& bounds, const Floor& floor, const Background& background)
+{
+	const vec3 sceneCentre(0.0f, 0.0f, bounds.maxY / 2.0f);
+	worldBounds.addSurface(floor.floorVertices, sceneCentre);
+	worldBounds.addSurface(background.backgroundVertices, sceneCentre);
+	worldBounds.addPlane(vec3(-1.0f, 0.0f, 0.0f), -bounds.maxZ);			// towards the camera
+	worldBounds.addPlane(vec3(0.0f, 1.0f, 0.0f), bounds.minX);				// left
+	worldBounds.addPlane(vec3(0.0f, -1.0f, 0.0f), -bounds.maxX);			// right
+	worldBounds.addPlane(vec3(0.0f, 0.0f, -1.0f), -(bounds.maxY + 15.0f));	// ceiling, high enough for the ghost
+} // end addSceneBounds method
+
 /*
 ***********************************************
 *			Global Variables
 ***********************************************
 */
-// list of moving objects in the scene
-vector<Object> objects;
+// position, rotation and motion of the moving objects, structure-of-arrays for the physics kernels
+MoverArrays movers;
+// spawns and despawns from the render thread, applied by the physics thread between ticks
+MoverCommands moverCommands;
 // randon internal light implementation (in fragment shader)
 float currentTimePassShader = 0.0f;
-// window boundaries
-const float minX = -35.5f, maxX = 35.5f;
-const float minY = 3.0f, maxY = 20.0f;
-const float minZ = -12.0f, maxZ = 20.5f;
+// redraws per second while nothing but the flicker changes (0 redraws every iteration)
+float idleFrameRate = 10.0f;
+// the window system lost the window's contents, the next iteration has to redraw
+bool windowDamaged = true;
 
 
 
@@ -205,185 +277,477 @@ const float minZ = -12.0f, maxZ = 20.5f;
 *		Multithreading
 ***********************************************
 */
-// mutex used for locking critical sections
-mutex objectsMutex;
-/* thread method - one thread to calculate movement for all object */
-void calculateMovements(float deltaTime, vector<Object>& objects)
+// physics runs in fixed ticks on its own thread, decoupled from the frame rate
+float physicsTick = 1.0f / 60.0f;
+// ticks caught up at once at most, the rest is dropped so a stall cannot snowball
+const int maxPhysicsSteps = 8;
+// 'b' and 'n' bursts of each kind queued in one frame, later presses wait for the next
+const int maxKeyBursts = 4;
+// cleared by the render thread to stop the physics thread
+atomic<bool> physicsRunning(true);
+// transforms handed from the physics thread to the render thread without locks
+TransformTripleBuffer transformSnapshots;
+// every tick of the physics thread, when --record is given
+TraceRecorder traceRecorder;
+// the physics thread's metrics, registered in main before it starts
+MetricHistogram physicsTickSeconds;
+MetricCounter physicsTicksTotal;
+MetricGauge collisionPairs;
+MetricGauge awakeMovers;
+/* thread method - one thread steps every object for as long as the scene runs */
+void runPhysics(MoverArrays& movers)
 {
-	// adjust position - use sine function for smooth motion
-	float speed = 2.0f + static_cast<float>(rand() % 100) / 5.0f;		// random speed of oscillation
-	float amplitude = 1.0f + static_cast<float>(rand() % 50) / 2.5f;	// random amplitude of motion
-	float offset = static_cast<float>(rand() % 5);						// random offset for initial position
-	for (auto& object : objects)
+	// the movers roll their motion from their own generator
+	movers.random.seed((unsigned int)time(0));
+	float physicsTime = 0.0f;		// simulated time, drives the waveforms
+	float physicsAccumulator = 0.0f;	// real time not yet simulated
+	unsigned long long physicsTicks = 0;
+	auto previousTime = chrono::steady_clock::now();
+	while (physicsRunning.load(memory_order_relaxed))
 	{
-		if (object.moving)
+		// slots spawned or despawned since the last tick
+		bool spawned = moverCommands.apply(movers);
+		auto currentTime = chrono::steady_clock::now();
+		physicsAccumulator += chrono::duration<float>(currentTime - previousTime).count();
+		previousTime = currentTime;
+		int steps = 0;
+		while (physicsAccumulator >= physicsTick && steps < maxPhysicsSteps)
 		{
-			/* pumpkin 1 - moves and rotates randomly */
-			if (&object == &objects[0])
+			// objects follow their waveforms once 'g' is pressed, until then they settle and sleep
+			auto stepStart = chrono::steady_clock::now();
+			stepPhysics(movers, physicsTime, physicsTick, moving);
+			physicsTickSeconds.observe(chrono::duration<double>(chrono::steady_clock::now() - stepStart).count());
+			physicsTicksTotal.add();
+			collisionPairs.set((double)movers.pairs.size());
+			awakeMovers.set((double)movers.awake.size());
+			physicsTime += physicsTick;
+			physicsAccumulator -= physicsTick;
+			physicsTicks++;
+			steps++;
+			if (traceRecorder.isOpen())
 			{
-				// adjust position - use sine function for smooth motion
-				speed = 1.0f + static_cast<float>(rand() % 100) / 25.0f;		// random speed of oscillation
-				amplitude = 1.0f + static_cast<float>(rand() % 50) / 2.5f;	// random amplitude of motion
-				offset = static_cast<float>(rand() % 5);					// random offset for initial position
-				lock_guard<mutex> lock(objectsMutex);  // lock the mutex to protect the critical section
-				{
-					// update "Y" position
-					objects[0].position.z = offset + sin(glfwGetTime() * speed) * amplitude;
-					// clamp the position within boundaries
-					objects[0].position.z = clamp(objects[0].position.z, minY, maxY);
-					// update "X" position
-					objects[0].position.y = offset + sin(glfwGetTime() * speed) * amplitude;
-					// clamp the position within boundaries
-					objects[0].position.y = clamp(objects[0].position.y, minX, maxX);
-					// update "Z" position
-					objects[0].position.x = offset + sin(glfwGetTime() * speed) * amplitude;
-					// clamp the position within boundaries
-					objects[0].position.x = clamp(objects[0].position.x, minZ, maxZ);
-					// generate random rotation speed 
-					objects[0].rotationSpeed = vec3
-					(
-						static_cast<float>(rand() % 360) / 50.0f,
-						static_cast<float>(rand() % 360) / 75.0f,
-						static_cast<float>(rand() % 360) / 100.0f
-					);
-					// perform rotation
-					objects[0].rotation += objects[0].rotationSpeed * static_cast<float>(deltaTime);
-					objects[0].rotation = mod(objects[0].rotation, 360.0f); // keep rotation within 0-360 degrees
-				} // end critical section
+				traceRecorder.record(movers, physicsTime, physicsTicks);
 			}
-			/* pumpkin 2 - objects[1] */
-			if (&object == &objects[1])
-			{
-				// adjust position - use sine function for smooth motion
-				speed = 1.0f + static_cast<float>(rand() % 100) / 25.0f;		// random speed of oscillation
-				amplitude = 1.0f + static_cast<float>(rand() % 50) / 2.5f;	// random amplitude of motion
-				offset = static_cast<float>(rand() % 5);					// random offset for initial position
-				lock_guard<mutex> lock(objectsMutex);  // lock the mutex to protect the critical section
-				{
-					// update "Y" position
-					objects[1].position.z = offset + sin(glfwGetTime() * speed) * amplitude;
-					// clamp the position within boundaries
-					objects[1].position.z = clamp(objects[1].position.z, minY, maxY);
-					// update "X" position
-					objects[1].position.y = offset + cos(glfwGetTime() * speed) * amplitude;
-					// clamp the position within boundaries
-					objects[1].position.y = clamp(objects[1].position.y, minX, maxX);
-					// update "Z" position
-					objects[1].position.x = offset + sin(glfwGetTime() * speed) * amplitude;
-					// clamp the position within boundaries
-					objects[1].position.x = clamp(objects[1].position.x, minZ, maxZ);
-					// generate random rotation speed 
-					objects[1].rotationSpeed = vec3
-					(
-						static_cast<float>(rand() % 360) / 75.0f,
-						static_cast<float>(rand() % 360) / 100.0f,
-						static_cast<float>(rand() % 360) / 125.0f
-					);
-					// perform rotation
-					objects[1].rotation += objects[1].rotationSpeed * static_cast<float>(deltaTime);
-					objects[1].rotation = mod(objects[1].rotation, 360.0f); // keep rotation within 0-360 degrees
-				} // end critical section
-			} // end if
-			/* pumpkin 3 - objects[2] */
-			if (&object == &objects[2])
-			{
-				// adjust position - use sine function for smooth motion
-				speed = 1.0f + static_cast<float>(rand() % 100) / 25.0f;	// random speed of oscillation
-				amplitude = 1.0f + static_cast<float>(rand() % 50) / 2.5f;	// random amplitude of motion
-				offset = static_cast<float>(rand() % 5);					// random offset for initial position
-				lock_guard<mutex> lock(objectsMutex);  // lock the mutex to protect the critical section
-				{
-					// update "Y" position
-					objects[2].position.z = offset + cos(glfwGetTime() * speed) * amplitude;
-					// clamp the position within boundaries
-					objects[2].position.z = clamp(objects[2].position.z, minY, maxY);
-					// update "X" position
-					objects[2].position.y = offset + sin(glfwGetTime() * speed) * amplitude;
-					// clamp the position within boundaries
-					objects[2].position.y = clamp(objects[2].position.y, minX, maxX);
-					// update "Z" position
-					objects[2].position.x = offset + cos(glfwGetTime() * speed) * amplitude;
-					// clamp the position within boundaries
-					objects[2].position.x = clamp(objects[2].position.x, minZ, maxZ);
-					// generate random rotation speed 
-					objects[2].rotationSpeed = vec3
-					(
-						static_cast<float>(rand() % 360) / 50.0f,
-						static_cast<float>(rand() % 360) / 75.0f,
-						static_cast<float>(rand() % 360) / 100.0f
-					);
-					// perform rotation
-					objects[2].rotation += objects[2].rotationSpeed * static_cast<float>(deltaTime);
-					objects[2].rotation = mod(objects[2].rotation, 360.0f); // keep rotation within 0-360 degrees
-				} // end critical section
-			} // end if
-			/* ghost - objects[3] */
-			if (&object == &objects[3])
-			{
-				// adjust position - use sine function for smooth motion
-				speed = 1.0f + static_cast<float>(rand() % 100) / 50.0f;	// random speed of oscillation
-				amplitude = 1.0f + static_cast<float>(rand() % 75) / 10.f;	// random amplitude of motion
-				offset = static_cast<float>(rand() % 5);					// random offset for initial position
-				lock_guard<mutex> lock(objectsMutex);  // lock the mutex to protect the critical section
-				{
-					// update "Y" position
-					objects[3].position.z = offset + cos(glfwGetTime() * speed) * amplitude;
-					// clamp the position within boundaries
-					objects[3].position.z = clamp(objects[3].position.z, minY, maxY + 15.0f);
-					// update "X" position
-					objects[3].position.y = offset + cos(glfwGetTime() * speed) * amplitude;
-					// clamp the position within boundaries
-					objects[3].position.y = clamp(objects[3].position.y, minX - 5.0f, maxX + 5.0f);
-					// update "Z" position
-					objects[3].position.x = offset + cos(glfwGetTime() * speed) * amplitude;
-					// clamp the position within boundaries
-					objects[3].position.x = clamp(objects[3].position.x, minZ - 5.0f, maxZ + 5.0f);
-					// generate random rotation speed 
-					objects[3].rotationSpeed = vec3
-					(
-						static_cast<float>(rand() % 360) / 15.0f,
-						static_cast<float>(rand() % 360) / 30.0f,
-						static_cast<float>(rand() % 360) / 45.0f
-					);
-					// perform rotation
-					objects[3].rotation += objects[3].rotationSpeed * static_cast<float>(deltaTime);
-					objects[3].rotation = mod(objects[3].rotation, 360.0f); // keep rotation within 0-360 degrees
-				} // end critical section
-			} // end if
-		} // end if
-		// handle collisions
-		for (auto& other : objects)
-		{
-			if (&object != &other)
+		}
+		if (steps == maxPhysicsSteps)
+		{
+			physicsAccumulator = 0.0f;
+		}
+		// only the newest state is ever drawn, publish once per catch-up
+		if (steps > 0 || spawned)
+		{
+			captureSnapshot(movers, physicsTime, physicsTicks, transformSnapshots.back());
+			transformSnapshots.publish();
+		}
+		// sleep until the next tick is due
+		this_thread::sleep_for(chrono::duration<float>(physicsTick - physicsAccumulator));
+	}
+} // end runPhysics method
+
+/* thread method - plays a recorded trace into the triple buffer at the rate it was recorded, in place of physics */
+void runReplay(TraceReader& trace)
+{
+	unsigned long long playedTicks = 0;
+	auto startTime = chrono::steady_clock::now();
+	while (physicsRunning.load(memory_order_relaxed))
+	{
+		// every tick due by now is decoded (each one builds on the last), only the newest is published
+		float elapsed = chrono::duration<float>(chrono::steady_clock::now() - startTime).count();
+		unsigned long long dueTicks = (unsigned long long)(elapsed / trace.tick());
+		bool advanced = false;
+		while (playedTicks < dueTicks)
+		{
+			if (!trace.next(transformSnapshots.back()))
 			{
-				lock_guard<mutex> lock(objectsMutex);  // lock the mutex to protect the critical section
+				printf("Replay finished after %llu ticks\n", playedTicks);
+				if (advanced)
 				{
-					vec3 diff = other.position - object.position;
-					float distance = length(diff);
-					if (distance < object.radius + other.radius + 0.2f)
-					{
-						vec3 normal = normalize(diff);
-						// reflect velocities based on collision normal
-						object.velocity = reflect(object.velocity, normal);
-						other.velocity = reflect(other.velocity, -normal);
-						// move objects slightly apart to avoid sticking
-						float pushApart = (object.radius + other.radius + 5.0f - distance) / 2.0f;
-						object.position -= normal * pushApart;
-						other.position += normal * pushApart;
-					} // end if
-				} // end critical section
-			} // end if
-		} // end inner for loop
-	} // end outer for loop
-} // end calculateMovements method
+					transformSnapshots.publish();
+				}
+				return;
+			}
+			playedTicks++;
+			advanced = true;
+		}
+		if (advanced)
+		{
+			transformSnapshots.publish();
+		}
+		this_thread::sleep_for(chrono::duration<float>(trace.tick()));
+	}
+} // end runReplay method
+
+/* LightBinningJob - what the light binning job reads, placed in the frame arena so queuing it allocates nothing */
+struct LightBinningJob
+{
+	ClusteredLights* lights;
+	const vector<PointLight>* sceneLights;
+	mat4 view;
+	mat4 projection;
+};
+/* job method - bin the frame's lights into clusters */
+void binLights(void* data, size_t, size_t)
+{
+	const LightBinningJob* job = static_cast<const LightBinningJob*>(data);
+	job->lights->bin(*job->sceneLights, job->view, job->projection);
+} // end binLights method
+
+/*
+***********************************************
+*		Window Events
+***********************************************
+*/
+/* GLFW refresh callback: the window was exposed or resized */
+void windowRefresh(GLFWwindow*)
+{
+	windowDamaged = true;
+} // end windowRefresh method
 
 /*
 *************************************************
 *				Main Method
 *************************************************
 */
-int main(void)
+int main(int argc, char* argv[])
 {
+	// parse command line options
+	unsigned int shaderFeatures = SHADER_LIGHTING | SHADER_INTERNAL_LIGHT;
+	int extraLights = 0;
+	bool benchFillRate = false;
+	bool benchAntiAliasing = false;
+	bool benchPhysics = false;
+	bool benchJobs = false;
+	bool benchOBJ = false;
+	bool benchIndex = false;
+	vector<const char*> benchOBJPaths;
+	// workers besides the render and physics threads
+	unsigned int hardwareThreads = thread::hardware_concurrency();
+	int workerCount = hardwareThreads > 3 ? (int)hardwareThreads - 2 : 1;
+	bool frontToBack = false;
+	// GPU milliseconds per frame held by dynamic resolution, 0 renders straight to the window
+	float resolutionBudget = 0.0f;
+	AntiAliasingMode antiAliasing = AA_MSAA4;
+	bool depthPrepass = false;
+	const char* scenePath = "halloween.scene";
+	const char* compiledScenePath = nullptr;
+	size_t generatedEntities = 0;
+	size_t spawnCapacity = 256;
+	size_t spawnBurst = 16;
+	float churnRate = 0.0f;
+	int allocationCheckFrames = 0;
+	bool sceneGiven = false;
+	const char* recordPath = nullptr;
+	const char* replayPath = nullptr;
+	const char* traceInfoPath = nullptr;
+	int metricsPort = 0;
+	const char* metricsCSVPath = nullptr;
+	float metricsCSVInterval = 1.0f;
+	size_t batchWorlds = 0;
+	unsigned long long batchTicks = 600;
+	bool batchPacked = false;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc)
+		{
+			scenePath = argv[++i];
+			sceneGiven = true;
+		}
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+		{
+			recordPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+		{
+			replayPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--trace-info") == 0 && i + 1 < argc)
+		{
+			traceInfoPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+		{
+			batchWorlds = (size_t)std::max(1LL, atoll(argv[++i]));
+			// optional tick count
+			if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0 && atoll(argv[i + 1]) > 0)
+			{
+				batchTicks = (unsigned long long)atoll(argv[++i]);
+			}
+		}
+		else if (strcmp(argv[i], "--batch-packed") == 0)
+		{
+			batchPacked = true;
+		}
+		else if (strcmp(argv[i], "--compile-scene") == 0 && i + 1 < argc)
+		{
+			compiledScenePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--generate-scene") == 0 && i + 2 < argc)
+		{
+			generatedEntities = (size_t)atoll(argv[++i]);
+			compiledScenePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--no-lighting") == 0)
+		{
+			shaderFeatures &= ~(SHADER_LIGHTING | SHADER_SPECULAR);
+		}
+		else if (strcmp(argv[i], "--lights") == 0 && i + 1 < argc)
+		{
+			extraLights = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--spawn-capacity") == 0 && i + 1 < argc)
+		{
+			spawnCapacity = (size_t)atoll(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--spawn-burst") == 0 && i + 1 < argc)
+		{
+			spawnBurst = (size_t)atoll(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--churn") == 0 && i + 1 < argc)
+		{
+			churnRate = std::max(0.0f, static_cast<float>(atof(argv[++i])));
+		}
+		else if (strcmp(argv[i], "--specular") == 0)
+		{
+			shaderFeatures |= SHADER_LIGHTING | SHADER_SPECULAR;
+		}
+		else if (strcmp(argv[i], "--no-internal-light") == 0)
+		{
+			shaderFeatures &= ~SHADER_INTERNAL_LIGHT;
+		}
+		else if (strcmp(argv[i], "--front-to-back") == 0)
+		{
+			frontToBack = true;
+		}
+		else if (strcmp(argv[i], "--depth-prepass") == 0)
+		{
+			depthPrepass = true;
+		}
+		else if (strcmp(argv[i], "--dynamic-resolution") == 0)
+		{
+			resolutionBudget = 16.6f;
+			if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0 && atof(argv[i + 1]) > 0.0)
+			{
+				resolutionBudget = static_cast<float>(atof(argv[++i]));
+			}
+		}
+		else if (strcmp(argv[i], "--aa") == 0 && i + 1 < argc)
+		{
+			if (!parseAntiAliasingMode(argv[++i], antiAliasing))
+			{
+				fprintf(stderr, "Unknown anti-aliasing mode %s, keeping %s\n", argv[i], antiAliasingModeName(antiAliasing));
+			}
+		}
+		else if (strcmp(argv[i], "--idle-fps") == 0 && i + 1 < argc)
+		{
+			idleFrameRate = std::max(0.0f, static_cast<float>(atof(argv[++i])));
+		}
+		else if (strcmp(argv[i], "--no-idle") == 0)
+		{
+			idleFrameRate = 0.0f;
+		}
+		else if (strcmp(argv[i], "--metrics") == 0)
+		{
+			metricsPort = 9464;
+			if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0 && atoi(argv[i + 1]) > 0)
+			{
+				metricsPort = atoi(argv[++i]);
+			}
+		}
+		else if (strcmp(argv[i], "--metrics-csv") == 0 && i + 1 < argc)
+		{
+			metricsCSVPath = argv[++i];
+			if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0 && atof(argv[i + 1]) > 0.0)
+			{
+				metricsCSVInterval = static_cast<float>(atof(argv[++i]));
+			}
+		}
+		else if (strcmp(argv[i], "--check-allocations") == 0)
+		{
+			allocationCheckFrames = 300;
+			if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0 && atoi(argv[i + 1]) > 0)
+			{
+				allocationCheckFrames = atoi(argv[++i]);
+			}
+		}
+		else if (strcmp(argv[i], "--compressed-vertices") == 0)
+		{
+			shaderFeatures |= SHADER_COMPRESSED_VERTICES;
+		}
+		else if (strcmp(argv[i], "--bench-fillrate") == 0)
+		{
+			benchFillRate = true;
+		}
+		else if (strcmp(argv[i], "--bench-aa") == 0)
+		{
+			benchAntiAliasing = true;
+		}
+		else if (strcmp(argv[i], "--bench-physics") == 0)
+		{
+			benchPhysics = true;
+		}
+		else if (strcmp(argv[i], "--bench-jobs") == 0)
+		{
+			benchJobs = true;
+		}
+		else if (strcmp(argv[i], "--bench-obj") == 0)
+		{
+			benchOBJ = true;
+			while (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+			{
+				benchOBJPaths.push_back(argv[++i]);
+			}
+		}
+		else if (strcmp(argv[i], "--bench-index") == 0)
+		{
+			benchIndex = true;
+		}
+		else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+		{
+			workerCount = atoi(argv[++i]);
+			if (workerCount < 0)
+			{
+				workerCount = 0;
+			}
+		}
+		else if (strcmp(argv[i], "--physics-hz") == 0 && i + 1 < argc)
+		{
+			float rate = static_cast<float>(atof(argv[++i]));
+			if (rate > 0.0f)
+			{
+				physicsTick = 1.0f / rate;
+			}
+		}
+		else if (strcmp(argv[i], "--physics-kernel") == 0 && i + 1 < argc)
+		{
+			i++;
+			if (strcmp(argv[i], "scalar") == 0)
+			{
+				setPhysicsKernel(PHYSICS_SCALAR);
+			}
+			else if (strcmp(argv[i], "sse2") == 0)
+			{
+				setPhysicsKernel(PHYSICS_SSE2);
+			}
+			else if (strcmp(argv[i], "avx2") == 0)
+			{
+				setPhysicsKernel(PHYSICS_AVX2);
+			}
+			else
+			{
+				fprintf(stderr, "Unknown physics kernel %s\n", argv[i]);
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+		}
+	}
+
+	// worker threads shared by physics, rendering and asset loading
+	jobs.start(workerCount);
+	printf("Job system: %d workers\n", workerCount);
+
+	// CPU-only benchmarks, no window needed
+	if (benchJobs)
+	{
+		runJobBenchmark();
+		return 0;
+	}
+	if (benchPhysics)
+	{
+		runPhysicsBenchmark();
+		return 0;
+	}
+	if (benchOBJ)
+	{
+		runOBJBenchmark(benchOBJPaths);
+		return 0;
+	}
+	if (benchIndex)
+	{
+		runIndexBenchmark();
+		return 0;
+	}
+	if (traceInfoPath != nullptr)
+	{
+		return printTraceSummary(traceInfoPath) ? 0 : -1;
+	}
+
+	/* a replay shows the scene it was recorded with, unless told otherwise */
+	TraceReader replayTrace;
+	const bool replaying = replayPath != nullptr;
+	if (replaying)
+	{
+		if (!replayTrace.open(replayPath))
+		{
+			return -1;
+		}
+		if (!sceneGiven)
+		{
+			scenePath = replayTrace.scene().c_str();
+		}
+		if (recordPath != nullptr)
+		{
+			fprintf(stderr, "Not recording a replay\n");
+			recordPath = nullptr;
+		}
+	}
+
+	/* the scene: what to load, where everything stands and how it moves */
+	Scene scene;
+	if (!scene.load(scenePath))
+	{
+		return -1;
+	}
+	if (compiledScenePath != nullptr)
+	{
+		if (generatedEntities > 0)
+		{
+			scene.scatter(generatedEntities, 1);
+		}
+		bool saved = scene.save(compiledScenePath);
+		printf("Scene %s: %zu moving and %zu static objects%s %s\n", scenePath, scene.moverCount(), scene.staticCount(),
+			saved ? " compiled to" : ", failed to write", compiledScenePath);
+		return saved ? 0 : -1;
+	}
+	printf("Scene %s: %zu moving and %zu static objects\n", scenePath, scene.moverCount(), scene.staticCount());
+	// the trace's slots are the scene's movers followed by the spawn slots it was recorded with
+	if (replaying)
+	{
+		if (replayTrace.slots() < scene.moverCount())
+		{
+			fprintf(stderr, "Trace %s has %zu slots, fewer than the %zu moving objects of %s\n", replayPath,
+				replayTrace.slots(), scene.moverCount(), scenePath);
+			return -1;
+		}
+		spawnCapacity = replayTrace.slots() - scene.moverCount();
+	}
+
+	/* start reading every asset on the job system, it overlaps window creation, shader compilation
+	   and the first frames (which show a placeholder scene until the assets arrive) */
+	AssetLoader loader;
+	vector<size_t> meshAssets;
+	for (const auto& mesh : scene.meshes)
+	{
+		meshAssets.push_back(loader.loadMesh(mesh.path.c_str(), mesh.collisionShape, mesh.bakedRotation));
+	}
+	// a batch run only needs the collision trees, every world shares them
+	if (batchWorlds > 0)
+	{
+		loader.wait();
+		vector<const MeshBVH*> shapes;
+		for (size_t m = 0; m < scene.meshes.size(); m++)
+		{
+			shapes.push_back(&loader.mesh(meshAssets[m]).shape);
+		}
+		WorldBounds batchBounds;
+		addSceneBounds(batchBounds, scene.bounds, Floor(scene.floor.width, scene.floor.height),
+			Background(scene.background.width, scene.background.height));
+		runBatch(scene, shapes, batchBounds, batchWorlds, batchTicks, physicsTick, batchPacked);
+		return 0;
+	}
+	loader.loadTextureArray(scene.textures);
+
 	// initialize GLFW
 	if (!glfwInit())
 	{
@@ -392,9 +756,16 @@ int main(void)
 		return -1;
 	}
 
-	glfwWindowHint(GLFW_SAMPLES, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+	/* dynamic resolution and FXAA draw into an offscreen target, which then carries the MSAA: a multisampled
+	   window could not be blitted to; otherwise the window itself is multisampled */
+	const bool offscreen = resolutionBudget > 0.0f || antiAliasing == AA_FXAA || benchAntiAliasing;
+	const int antiAliasingSampleCount = antiAliasingSamples(antiAliasing);
+	glfwWindowHint(GLFW_SAMPLES, offscreen || antiAliasingSampleCount == 1 ? 0 : antiAliasingSampleCount);
+	// compute shaders and multi-draw-indirect need a 4.3 core context (Mesa llvmpipe provides one)
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 	// open a window and create its OpenGL context
 	window = glfwCreateWindow(1640, 1240, "Final Project - 3D Animation, Multithreading, & OpenGL", NULL, NULL);
@@ -408,6 +779,7 @@ int main(void)
 	glfwMakeContextCurrent(window);
 
 	// initialize GLEW
+	glewExperimental = true; // needed for core profile
 	if (glewInit() != GLEW_OK)
 	{
 		fprintf(stderr, "Failed to initialize GLEW\n");
@@ -418,6 +790,8 @@ int main(void)
 
 	// ensure we can capture the escape key being pressed below
 	glfwSetInputMode(window, GLFW_STICKY_KEYS, GL_TRUE);
+	// an exposed or resized window must be redrawn even when the scene is idle
+	glfwSetWindowRefreshCallback(window, windowRefresh);
 
 	// set the mouse at the center of the screen
 	glfwPollEvents();
@@ -431,46 +805,43 @@ int main(void)
 	// accept fragment if it closer to the camera than the former one
 	glDepthFunc(GL_LESS);
 
-	// create and compile our GLSL program from the shaders
-	GLuint programID = LoadShaders("StandardShading.vertexshader", "StandardShading.fragmentshader");
+	// create and compile our GLSL program from the shaders, only with the selected features
+	ShaderPermutations standardShading("StandardShading.vertexshader", "StandardShading.fragmentshader");
+	GLuint programID = standardShading.get(shaderFeatures);
+	// depth-only permutation for the optional depth pre-pass
+	GLuint depthProgramID = depthPrepass ? standardShading.get(SHADER_DEPTH_ONLY | (shaderFeatures & SHADER_COMPRESSED_VERTICES)) : 0;
+	GLuint DepthViewProjectionMatrixID = depthPrepass ? glGetUniformLocation(depthProgramID, "VP") : 0;
 
-	// get a handle for our "MVP" uniform
-	GLuint MatrixID = glGetUniformLocation(programID, "MVP");
+	// get a handle for our "VP" uniform (model matrices come from the entity buffer)
+	GLuint ViewProjectionMatrixID = glGetUniformLocation(programID, "VP");
 	GLuint ViewMatrixID = glGetUniformLocation(programID, "V");
-	GLuint ModelMatrixID = glGetUniformLocation(programID, "M");
 
-	// get a handle for our buffers
-	GLuint vertexPosition_modelspaceID = glGetAttribLocation(programID, "vertexPosition_modelspace");
-	GLuint vertexUVID = glGetAttribLocation(programID, "vertexUV");
-	GLuint vertexNormal_modelspaceID = glGetAttribLocation(programID, "vertexNormal_modelspace");
+	// GPU driven renderer: shared mesh buffers, compute culling and multi-draw-indirect
+	IndirectRenderer renderer;
+	if (!renderer.init("CullEntities.computeshader", (shaderFeatures & SHADER_COMPRESSED_VERTICES) != 0))
+	{
+		fprintf(stderr, "Failed to create the culling compute shader\n");
+		getchar();
+		glfwTerminate();
+		return -1;
+	}
 
 	// get a handle for our "myTextureSampler" uniform
 	GLuint TextureID = glGetUniformLocation(programID, "myTextureSampler");
 
-	// get a handle for our "LightPosition" uniform
+	// get a handle for our "internalLightIntensity" uniform
 	glUseProgram(programID);
-	GLuint LightID = glGetUniformLocation(programID, "LightPosition_worldspace");
-
-	// load the texture for the pumpking objects
-	GLuint Texture = loadDDS("uvmap.DDS");
-
-	// load the texture for the ghost object
-	GLuint GhostTexture = loadDDS("specular.DDS");
-
-	// load texture for tree objects
-	GLuint TreeTexture = loadDDS("diffuse.DDS");
+	GLuint InternalLightID = glGetUniformLocation(programID, "internalLightIntensity");
 
-	// load floor texture
-	GLuint FloorTexture = loadDDS("diffuse.DDS");
-
-	// load background texture
-	GLuint BackgroundTexture = loadDDS("uvmap.DDS");
+	// every texture in the scene shares one texture array (one layer per DDS file), flat grey until it has loaded
+	GLuint SceneTextures = createPlaceholderArray((int)scene.textures.size());
+	bool texturesLoaded = false;
 
 	// create instance of Floor object
-	Floor floor(45.0f, 60.0f);
+	Floor floor(scene.floor.width, scene.floor.height);
 
 	// create instance of Background object
-	Background background(60.0f, 20.0f);
+	Background background(scene.background.width, scene.background.height);
 
 	// defining the translation distance
 	float translateDist = 1.95f;
@@ -478,935 +849,642 @@ int main(void)
 	// speed calculations
 	double previousTime = glfwGetTime();
 	int numFrames = 0;
-	float deltaTime = 0.1f;
 
 	// specular & diffuse values
 	float diffuseDefault = 1.0f;
 	float specularDefault = 1.0f;
 
-	// create pumpkin object and index the VBO
-	vector<vec3> vertices;
-	vector<vec2> uvs;
-	vector<vec3> normals;
-	bool res = loadOBJ("pumpkin.obj", vertices, uvs, normals);
-	vector<unsigned short> indices;
-	vector<vec3> indexed_vertices;
-	vector<vec2> indexed_uvs;
-	vector<vec3> indexed_normals;
-	indexVBO(vertices, uvs, normals, indices, indexed_vertices, indexed_uvs, indexed_normals);
-	Object pumpkin(indexed_vertices, indexed_uvs, indexed_normals, indices,
-		vec3(15.0f, 0.0f, 0.0f), vec3(0.1f, 0.0f, 0.0f), vec3(0.0f), vec3(0.1f, 0.1f, 0.1f), 1.0f);
-	// add 3 pumpkins to list of moving objects
-	objects.emplace_back(pumpkin); // middle pumpkin
-	pumpkin.position = vec3(15.0f, 8.0f, 4.0f);
-	objects.emplace_back(pumpkin); // right pumpkin
-	pumpkin.position = vec3(15.0f, -8.0f, 4.0f);
-	objects.emplace_back(pumpkin); // left pumpkin
-	// create and bind buffers for pumpkin object
-	GLuint vertexbuffer;
-	glGenBuffers(1, &vertexbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-	glBufferData(GL_ARRAY_BUFFER, pumpkin.vertices.size() * sizeof(vec3), &pumpkin.vertices[0], GL_STATIC_DRAW);
-	GLuint uvbuffer;
-	glGenBuffers(1, &uvbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-	glBufferData(GL_ARRAY_BUFFER, pumpkin.uvs.size() * sizeof(vec2), &pumpkin.uvs[0], GL_STATIC_DRAW);
-	GLuint normalbuffer;
-	glGenBuffers(1, &normalbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, normalbuffer);
-	glBufferData(GL_ARRAY_BUFFER, pumpkin.normals.size() * sizeof(vec3), &pumpkin.normals[0], GL_STATIC_DRAW);
-	GLuint elementbuffer;
-	glGenBuffers(1, &elementbuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, pumpkin.indices.size() * sizeof(unsigned short), &pumpkin.indices[0], GL_STATIC_DRAW);
-
-	// create ghost object and index the VBO
-	vector<vec3> ghostVertices;
-	vector<vec2> ghostUVs;
-	vector<vec3> ghostNormals;
-	res = loadOBJ("Halloween_Ghost.obj", ghostVertices, ghostUVs, ghostNormals);
-	vector<unsigned short> ghostIndices;
-	vector<vec3> indexed_ghost_vertices;
-	vector<vec2> indexed_ghost_uvs;
-	vector<vec3> indexed_ghost_normals;
-	indexVBO(ghostVertices, ghostUVs, ghostNormals, ghostIndices, indexed_ghost_vertices, indexed_ghost_uvs, indexed_ghost_normals);
-	Object ghost(indexed_ghost_vertices, indexed_ghost_uvs, indexed_ghost_normals, ghostIndices, 
-		vec3(0.0f, 0.0f, 2.0f), vec3(0.1f, 0.0f, 0.0f), vec3(0.0f), vec3(0.1f, 0.1f, 0.1f), 1.0f);
-	// add ghost to list of moving objects
-	objects.emplace_back(ghost);
-	// create and bind buffers for ghost object
-	GLuint ghostVertexBuffer;
-	glGenBuffers(1, &ghostVertexBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, ghostVertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, ghost.vertices.size() * sizeof(vec3), &ghost.vertices[0], GL_STATIC_DRAW);
-	GLuint ghostUVBuffer;
-	glGenBuffers(1, &ghostUVBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, ghostUVBuffer);
-	glBufferData(GL_ARRAY_BUFFER, ghost.uvs.size() * sizeof(vec2), &ghost.uvs[0], GL_STATIC_DRAW);
-	GLuint ghostNormalBuffer;
-	glGenBuffers(1, &ghostNormalBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, ghostNormalBuffer);
-	glBufferData(GL_ARRAY_BUFFER, ghost.normals.size() * sizeof(vec3), &ghost.normals[0], GL_STATIC_DRAW);
-	GLuint ghostElementBuffer;
-	glGenBuffers(1, &ghostElementBuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ghostElementBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, ghost.indices.size() * sizeof(unsigned short), &ghost.indices[0], GL_STATIC_DRAW);
-
-	// create and bind buffers for the floor
-	GLuint floorVertexBuffer;
-	glGenBuffers(1, &floorVertexBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, floorVertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, floor.floorVertices.size() * sizeof(vec3), &floor.floorVertices[0], GL_STATIC_DRAW);
-	GLuint floorUVBuffer;
-	glGenBuffers(1, &floorUVBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, floorUVBuffer);
-	glBufferData(GL_ARRAY_BUFFER, floor.floorUVs.size() * sizeof(vec2), &floor.floorUVs[0], GL_STATIC_DRAW);
-	GLuint floorNormalBuffer;
-	glGenBuffers(1, &floorNormalBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, floorNormalBuffer);
-	glBufferData(GL_ARRAY_BUFFER, floor.floorNormals.size() * sizeof(vec3), &floor.floorNormals[0], GL_STATIC_DRAW);
-	GLuint floorElementBuffer;
-	glGenBuffers(1, &floorElementBuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, floorElementBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, floor.floorIndices.size() * sizeof(unsigned short), &floor.floorIndices[0], GL_STATIC_DRAW);
-
-	// create and bind buffers for the background
-	GLuint backgroundVertexBuffer;
-	glGenBuffers(1, &backgroundVertexBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, backgroundVertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, background.backgroundVertices.size() * sizeof(vec3), &background.backgroundVertices[0], GL_STATIC_DRAW);
-	GLuint backgroundUVBuffer;
-	glGenBuffers(1, &backgroundUVBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, backgroundUVBuffer);
-	glBufferData(GL_ARRAY_BUFFER, background.backgroundUVs.size() * sizeof(vec2), &background.backgroundUVs[0], GL_STATIC_DRAW);
-	GLuint backgroundNormalBuffer;
-	glGenBuffers(1, &backgroundNormalBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, backgroundNormalBuffer);
-	glBufferData(GL_ARRAY_BUFFER, background.backgroundNormals.size() * sizeof(vec3), &background.backgroundNormals[0], GL_STATIC_DRAW);
-	GLuint backgroundElementBuffer;
-	glGenBuffers(1, &backgroundElementBuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, backgroundElementBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, background.backgroundIndices.size() * sizeof(unsigned short), &background.backgroundIndices[0], GL_STATIC_DRAW);
-
-	/*
-	*******************************************************************************
-	*				EXTRA CREDIT - Static Tree Objects
-	*******************************************************************************
-	*/
-	vector<vec3> treeVertices;
-	vector<vec2> treeUVs;
-	vector<vec3> treeNormals;
-	res = loadOBJ("tree.obj", treeVertices, treeUVs, treeNormals);
-	vector<unsigned short> treeIndices;
-	vector<vec3> indexed_tree_vertices;
-	vector<vec2> indexed_tree_uvs;
-	vector<vec3> indexed_tree_normals;
-	indexVBO(treeVertices, treeUVs, treeNormals, treeIndices, indexed_tree_vertices, indexed_tree_uvs, indexed_tree_normals);
-	// create instance of Static_Object for background trees
-	StaticObject tree(indexed_tree_vertices, indexed_tree_uvs, indexed_tree_normals, treeIndices);
-	// create and bind buffers for tree object
-	GLuint treeVertexBuffer;
-	glGenBuffers(1, &treeVertexBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, treeVertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, tree.vertices.size() * sizeof(vec3), &tree.vertices[0], GL_STATIC_DRAW);
-	GLuint treeUVBuffer;
-	glGenBuffers(1, &treeUVBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, treeUVBuffer);
-	glBufferData(GL_ARRAY_BUFFER, tree.uvs.size() * sizeof(vec2), &tree.uvs[0], GL_STATIC_DRAW);
-	GLuint treeNormalBuffer;
-	glGenBuffers(1, &treeNormalBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, treeNormalBuffer);
-	glBufferData(GL_ARRAY_BUFFER, tree.normals.size() * sizeof(vec3), &tree.normals[0], GL_STATIC_DRAW);
-	GLuint treeElementBuffer;
-	glGenBuffers(1, &treeElementBuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, treeElementBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, tree.indices.size() * sizeof(unsigned short), &tree.indices[0], GL_STATIC_DRAW);
+	// material properties that never change, folded on the CPU
+	vec3 materialSpecularColor = vec3(0.3f, 0.3f, 0.3f);
+	vec3 specularMaterialIntensity = specularDefault * materialSpecularColor;
+	glUniform1f(glGetUniformLocation(programID, "diffuseIntensity"), diffuseDefault);
+	glUniform3f(glGetUniformLocation(programID, "specularMaterialIntensity"),
+		specularMaterialIntensity.x, specularMaterialIntensity.y, specularMaterialIntensity.z);
+
+	/* point lights - binned into clusters every frame */
+	ClusteredLights lights;
+	lights.init(0.1f, 100.0f); // near and far planes of the projection in controls.cpp
+	// the scene's own lights
+	vector<PointLight> sceneLights = scene.lights;
+	// one candle inside each mover that carries one (the pumpkins), moved and flickered every frame;
+	// the scene's movers take the first pool slots, so mover i is slot i in its first generation
+	const size_t firstCandle = sceneLights.size();
+	vector<EntityHandle> candleMovers;
+	for (size_t i = 0; i < scene.moverCount(); i++)
+	{
+		if (scene.moverFlags(i) & SCENE_MOVER_CANDLE)
+		{
+			candleMovers.push_back({ (uint32_t)i, 0 });
+			sceneLights.push_back({ vec3(0.0f), 8.0f, vec3(1.0f, 0.55f, 0.15f), 12.0f });
+		}
+	}
+	const size_t candleCount = candleMovers.size();
+	// optional extra lights scattered over the floor
+	for (int i = 0; i < extraLights; i++)
+	{
+		PointLight light;
+		light.position = vec3
+		(
+			-20.0f + static_cast<float>(rand() % 400) / 10.0f,
+			-28.0f + static_cast<float>(rand() % 560) / 10.0f,
+			0.5f + static_cast<float>(rand() % 60) / 10.0f
+		);
+		light.radius = 4.0f + static_cast<float>(rand() % 40) / 10.0f;
+		light.color = vec3(static_cast<float>(rand() % 100) / 100.0f, static_cast<float>(rand() % 100) / 100.0f, 0.5f);
+		light.power = 6.0f;
+		sceneLights.push_back(light);
+	}
+
+	// renderer mesh of each scene mesh, filled in as the loader delivers them
+	const GLuint meshPending = 0xFFFFFFFFu;
+	vector<GLuint> sceneMeshes(scene.meshes.size(), meshPending);
+	// the movers start together, once every mesh they use has arrived
+	vector<unsigned char> moverMeshes(scene.meshes.size(), 0);
+	for (size_t i = 0; i < scene.moverCount(); i++)
+	{
+		moverMeshes[scene.moverMesh(i)] = 1;
+	}
+	bool objectsLoaded = false;
+
+	addSceneBounds(movers.bounds, scene.bounds, floor, background);
+	printf("Physics kernels: %s\n", physicsKernelName(physicsKernel()));
+
+	// add the floor and the background to the shared scene buffers
+	GLuint floorMesh = renderer.addMesh(floor.floorVertices, floor.floorUVs, floor.floorNormals, floor.floorIndices);
+	GLuint backgroundMesh = renderer.addMesh(background.backgroundVertices, background.backgroundUVs,
+		background.backgroundNormals, background.backgroundIndices);
+
+	// upload the placeholder scene before the first frame, the loaded meshes are appended later
+	renderer.uploadMeshes();
+
+	// offscreen benchmarks instead of the scene
+	if (benchFillRate || benchAntiAliasing)
+	{
+		// measured with the real textures
+		loader.wait();
+		GLuint loadedTextures = loader.uploadTextures();
+		if (loadedTextures != 0)
+		{
+			glDeleteTextures(1, &SceneTextures);
+			SceneTextures = loadedTextures;
+		}
+		if (benchFillRate)
+		{
+			runFillRateBenchmark(standardShading, renderer, lights, floorMesh, SceneTextures);
+		}
+		if (benchAntiAliasing)
+		{
+			runAntiAliasingBenchmark(standardShading, renderer, lights, floorMesh, SceneTextures);
+		}
+		renderer.cleanup();
+		lights.cleanup();
+		standardShading.cleanup();
+		glDeleteTextures(1, &SceneTextures);
+		glfwTerminate();
+		return 0;
+	}
+
+	// the most entities a frame can draw: movers, floor, background and statics
+	const size_t entityCapacity = scene.moverCount() + spawnCapacity + 2 + scene.staticCount();
+	/* storage of everything a frame throws away: its entity list, the front-to-back sort and job data;
+	   sized for the full entity list twice plus sort keys, it grows by itself if a frame needs more */
+	FrameArena frameArena;
+	frameArena.init(entityCapacity * (2 * sizeof(EntityInstance) + sizeof(pair<float, GLuint>)) + 64 * 1024);
+	// --check-allocations: settled frames still to check, and heap allocations when the last one began
+	int allocationWarmup = 120;
+	int allocationCheckFailures = 0;
+	unsigned long long frameAllocations = 0;
+	const bool checkAllocations = allocationCheckFrames > 0;
+	if (checkAllocations)
+	{
+		// idle iterations skip most of the frame, check the full one
+		idleFrameRate = 0.0f;
+		printf("Allocation check: %d frames once the scene has settled\n", allocationCheckFrames);
+	}
+
+	/* metrics - registered before the physics thread exists, exported by a thread of their own */
+	MetricHistogram frameSeconds = metrics.histogram("scene_frame_seconds", "Time to build and present a drawn frame",
+		{ 0.002, 0.004, 0.008, 0.0167, 0.0333, 0.05, 0.1, 0.25 });
+	MetricCounter framesTotal = metrics.counter("scene_frames_total", "Frames drawn");
+	MetricCounter drawCallsTotal = metrics.counter("scene_draw_calls_total", "Scene draw calls submitted");
+	MetricCounter trianglesTotal = metrics.counter("scene_triangles_total", "Triangles submitted, before GPU culling");
+	MetricGauge submittedEntities = metrics.gauge("scene_entities", "Entities submitted in the last frame");
+	MetricGauge liveMovers = metrics.gauge("scene_live_movers", "Entity pool slots in use");
+	physicsTickSeconds = metrics.histogram("scene_physics_tick_seconds", "Time to step one physics tick",
+		{ 0.0001, 0.00025, 0.0005, 0.001, 0.002, 0.004, 0.008, 0.016 });
+	physicsTicksTotal = metrics.counter("scene_physics_ticks_total", "Physics ticks stepped");
+	collisionPairs = metrics.gauge("scene_collision_pairs", "Broadphase pairs of the last physics tick");
+	awakeMovers = metrics.gauge("scene_awake_movers", "Movers awake after the last physics tick");
+	MetricsExporter metricsExporter;
+	if (metricsPort > 0 || metricsCSVPath != nullptr)
+	{
+		metricsExporter.start(metrics, metricsPort, metricsCSVPath, metricsCSVInterval);
+	}
+	// renderer totals already added to the counters
+	RenderStats reportedStats;
+
+	/* mover slots - the scene's movers and room for spawnCapacity more, all allocated when the movers load */
+	EntityPool entities;
+	// a slot is drawn once the snapshot holds the mover the pool gave it; a replay shows whatever the trace holds
+	auto slotShown = [&](const TransformSnapshot& snapshot, uint32_t slot)
+	{
+		if (replaying)
+		{
+			return snapshot.generation[slot] != noGeneration && snapshot.tag[slot] < scene.moverCount();
+		}
+		return snapshot.generation[slot] == entities.generation(slot);
+	};
+	// the scene's movers as they start, what spawned copies are made from
+	vector<MoverSpawn> moverTemplates;
+	mt19937 spawnRandom(1);
+	uniform_real_distribution<float> spawnAcross(-scene.floor.width / 2.0f, scene.floor.width / 2.0f);
+	uniform_real_distribution<float> spawnAlong(-scene.floor.height / 2.0f, scene.floor.height / 2.0f);
+	double churnTime = 0.0;
+
+	/* world matrices of the entities, cached between frames; only the movers change after they are added */
+	TransformTable sceneTransforms;
+	const quat noRotation = quat(1.0f, 0.0f, 0.0f, 0.0f);
+	const unsigned int floorTransform = sceneTransforms.add(vec3(0.0f), noRotation);
+	const unsigned int backgroundTransform = sceneTransforms.add(vec3(0.0f), noRotation);
+	// the movers' matrices are consecutive, one per slot; each static gets one when its mesh arrives
+	unsigned int firstMoverTransform = 0;
+	const unsigned int transformPending = TransformTable::noParent;
+	vector<unsigned int> staticTransforms(scene.staticCount(), transformPending);
+
+	// started once the moving objects have loaded
+	thread physicsThread;
+
+	// offscreen target whose size follows the GPU time budget (full size when only FXAA needs it)
+	DynamicResolution resolution;
+	FXAAFilter fxaa;
+	const FXAAFilter* postFilter = nullptr;
+	if (antiAliasing == AA_FXAA && fxaa.init("FXAA.vertexshader", "FXAA.fragmentshader"))
+	{
+		postFilter = &fxaa;
+	}
+	if (offscreen)
+	{
+		resolution.init(resolutionBudget, antiAliasingSampleCount);
+		if (resolutionBudget > 0.0f)
+		{
+			printf("Dynamic resolution: %.1f ms GPU budget\n", resolutionBudget);
+		}
+	}
+	printf("Anti-aliasing: %s\n", antiAliasingModeName(antiAliasing));
+
+	// what the last presented frame was drawn with, to tell when an identical frame would be drawn again
+	mat4 drawnView(0.0f), drawnProjection(0.0f);
+	double drawnTime = -1.0e30;
 
 	/* rendering loop */
 	do
 	{
+		// everything the frame before last allocated from the arena is released here
+		frameArena.beginFrame();
+
+		/* heap allocations made since the previous frame began, by any thread, once every asset is in
+		   and the first frames have warmed up the containers */
+		if (checkAllocations)
+		{
+			unsigned long long allocations = heapAllocationCount();
+			if (objectsLoaded && texturesLoaded && allocationWarmup-- <= 0)
+			{
+				if (allocations != frameAllocations)
+				{
+					printf("Allocation check: %llu heap allocations in a settled frame\n", allocations - frameAllocations);
+					allocationCheckFailures++;
+				}
+				if (--allocationCheckFrames == 0)
+				{
+					break;
+				}
+			}
+			frameAllocations = heapAllocationCount();
+		}
+
 		// get the current time to pass into fragment shader
 		currentTimePassShader = glfwGetTime();
 		// measure speed
 		float currentTime = glfwGetTime();
-		// get a handle for our "time" uniform
-		GLuint timeID = glGetUniformLocation(programID, "time");
-		// set 'time' unfirom in shader
-		glUniform1f(timeID, currentTimePassShader);
-		numFrames++;
+		// internal light intensity is the same for every fragment, evaluate it once per frame
+		glUniform1f(InternalLightID, 0.5f + 0.5f * sin(currentTimePassShader));
 		if (currentTime - previousTime >= 1.0)  // if last prinf() was more than 1sec ago
 		{
-			// printf and reset
-			printf("%f ms/frame\n", 1000.0 / double(numFrames));
+			// printf and reset (an idle second may not have drawn anything)
+			if (numFrames > 0)
+			{
+				printf("%f ms/frame\n", 1000.0 / double(numFrames));
+				if (resolutionBudget > 0.0f)
+				{
+					printf("  render scale %.2f (%dx%d), GPU %.2f ms\n", resolution.scale(), resolution.width(),
+						resolution.height(), resolution.gpuMilliseconds());
+				}
+			}
 			numFrames = 0;
 			previousTime += 1.0;
 		}
-		if (moving == true) // external boolean defined in controls.hpp
+
+		/*
+		**************************************************
+		*			Bring in Loaded Assets
+		**************************************************
+		*/
+		bool assetsArrived = false;
+		/* the meshes, each one is drawn from the frame it arrives in */
+		bool meshesArrived = false;
+		for (size_t m = 0; m < sceneMeshes.size(); m++)
 		{
-			objects[0].moving = true;
-			objects[1].moving = true;
-			objects[2].moving = true;
-			objects[3].moving = true;
+			if (sceneMeshes[m] == meshPending && loader.meshReady(meshAssets[m]))
+			{
+				const MeshAsset& meshData = loader.mesh(meshAssets[m]);
+				sceneMeshes[m] = renderer.addMesh(meshData.vertices, meshData.uvs, meshData.normals, meshData.indices);
+				meshesArrived = true;
+			}
+		}
+		if (meshesArrived)
+		{
+			assetsArrived = true;
+			renderer.uploadMeshes();
+			/* the statics of the new meshes - their matrices are built here and never again */
+			for (size_t i = 0; i < scene.staticCount(); i++)
+			{
+				if (staticTransforms[i] == transformPending && sceneMeshes[scene.staticMesh(i)] != meshPending)
+				{
+					staticTransforms[i] = sceneTransforms.add(scene.staticPosition(i), scene.staticRotation(i));
+				}
+			}
+		}
+		/* the moving objects - physics starts from their starting layout once all of their meshes have arrived */
+		bool moverMeshesReady = true;
+		for (size_t m = 0; m < sceneMeshes.size(); m++)
+		{
+			moverMeshesReady = moverMeshesReady && (!moverMeshes[m] || sceneMeshes[m] != meshPending);
+		}
+		if (!objectsLoaded && moverMeshesReady)
+		{
+			assetsArrived = true;
+			vector<const MeshBVH*> shapes;
+			for (size_t m = 0; m < scene.meshes.size(); m++)
+			{
+				shapes.push_back(&loader.mesh(meshAssets[m]).shape);
+			}
+			scene.addMovers(movers, shapes);
+			// copy the templates before the physics thread owns the arrays
+			moverTemplates.resize(movers.size());
+			for (size_t i = 0; i < movers.size(); i++)
+			{
+				MoverSpawn& spawn = moverTemplates[i];
+				spawn.position = movers.position(i);
+				spawn.velocity = vec3(0.0f);
+				spawn.radius = movers.radius[i];
+				spawn.mass = movers.inverseMass[i] > 0.0f ? 1.0f / movers.inverseMass[i] : 0.0f;
+				spawn.motion = movers.motion[i];
+				spawn.shape = movers.shape[i];
+				spawn.orientation = movers.orientation[i];
+				spawn.spinAxes = movers.spinAxes[i];
+				spawn.bakedRotation = conjugate(movers.unbake[i]);
+				spawn.tag = movers.tag[i];
+			}
+			// the free slots sit asleep and inactive until something spawns into them
+			size_t firstFreeSlot = movers.append(spawnCapacity);
+			for (size_t i = firstFreeSlot; i < movers.size(); i++)
+			{
+				movers.deactivate(i);
+			}
+			entities.reserve(movers.size());
+			// a replay owns every slot, the trace says which are in use
+			size_t ownedSlots = replaying ? movers.size() : firstFreeSlot;
+			for (size_t i = 0; i < ownedSlots; i++)
+			{
+				entities.spawn();
+			}
+			// the most one frame queues: a second of churn and the key bursts, each spawning and despawning
+			moverCommands.reserve(2 * ((size_t)ceil(churnRate) + maxKeyBursts) * spawnBurst);
+			captureSnapshot(movers, 0.0f, 0, transformSnapshots.back());
+			transformSnapshots.publish();
+			firstMoverTransform = (unsigned int)sceneTransforms.size();
+			for (unsigned int i = 0; i < movers.size(); i++)
+			{
+				sceneTransforms.add(movers.position(i), movers.worldRotation(i, movers.rotation(i)));
+			}
+			churnTime = glfwGetTime();
+			// a scene without movers has nothing to simulate, a replay does not simulate at all
+			if (replaying)
+			{
+				physicsThread = thread(&runReplay, ref(replayTrace));
+			}
+			else if (movers.size() > 0)
+			{
+				if (recordPath != nullptr && traceRecorder.open(recordPath, movers.size(), physicsTick, scenePath))
+				{
+					printf("Recording to %s\n", recordPath);
+				}
+				physicsThread = thread(&runPhysics, ref(movers));
+			}
+			objectsLoaded = true;
+		}
+		/* the textures, streamed through a pixel buffer in place of the placeholder */
+		if (!texturesLoaded && loader.texturesReady())
+		{
+			assetsArrived = true;
+			GLuint loadedTextures = loader.uploadTextures();
+			if (loadedTextures != 0)
+			{
+				glDeleteTextures(1, &SceneTextures);
+				SceneTextures = loadedTextures;
+			}
+			texturesLoaded = true;
 		}
 
-		
-		// seed the random number generator
-		srand(time(0));
-
-		/* update position & rotation of each object */
-		if (moving == true)
+		/*
+		**************************************************
+		*			Spawn & Despawn
+		**************************************************
+		*/
+		/* bursts from 'b' and 'n' or --churn; the pool hands out and takes back slots at once, the physics
+		   thread fills or empties them before its next tick and a slot is drawn once the snapshot agrees;
+		   nothing is queued until the last frame's commands are applied, so the queue never outgrows its reserve */
+		bool entitiesChanged = false;
+		if (objectsLoaded && !moverTemplates.empty() && !replaying && !moverCommands.pending())
 		{
-			// create thread to calculate object movements
-			thread movementThread(&calculateMovements, deltaTime, ref(objects));
-			// wait for movement thread to finish before exiting
-			if (movementThread.joinable())
+			int spawnBursts = std::min(spawnBurstRequests, maxKeyBursts);
+			int despawnBursts = std::min(despawnBurstRequests, maxKeyBursts);
+			spawnBurstRequests -= spawnBursts;
+			despawnBurstRequests -= despawnBursts;
+			size_t spawnCount = (size_t)spawnBursts * spawnBurst;
+			size_t despawnCount = (size_t)despawnBursts * spawnBurst;
+			bool requested = spawnBursts + despawnBursts > 0;
+			if (churnRate > 0.0f)
+			{
+				// at most a second's worth after a stall
+				int due = std::min((int)((glfwGetTime() - churnTime) * churnRate), (int)ceil(churnRate));
+				churnTime = due == (int)ceil(churnRate) ? glfwGetTime() : churnTime + due / churnRate;
+				spawnCount += due * spawnBurst;
+				despawnCount += due * spawnBurst;
+			}
+			for (size_t n = 0; n < despawnCount && entities.size() > 0; n++)
+			{
+				uint32_t slot = entities.live()[spawnRandom() % entities.size()];
+				entities.despawn(entities.handle(slot));
+				moverCommands.despawn(slot);
+				entitiesChanged = true;
+			}
+			for (size_t n = 0; n < spawnCount; n++)
+			{
+				EntityHandle handle = entities.spawn();
+				if (handle.index == EntityPool::noIndex)
+				{
+					break;
+				}
+				uint32_t source = (uint32_t)(spawnRandom() % moverTemplates.size());
+				MoverSpawn spawn = moverTemplates[source];
+				spawn.position.x = spawnAcross(spawnRandom);
+				spawn.position.y = spawnAlong(spawnRandom);
+				moverCommands.spawn(handle.index, handle.generation, spawn);
+				entitiesChanged = true;
+			}
+			if (requested)
 			{
-				movementThread.join();
+				printf("Entity pool: %zu of %zu slots in use\n", entities.size(), entities.capacity());
 			}
 		}
 
-		// clear the screen
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		/* position & rotation of each object, from the newest complete physics tick */
+		const TransformSnapshot& frameTransforms = transformSnapshots.latest();
 
 		// compute the MVP matrix from keyboard input
 		computeMatricesFromInputs();
 		mat4 ProjectionMatrix = getProjectionMatrix();
 		mat4 ViewMatrix = getViewMatrix();
-		mat4 ModelMatrix = mat4(1.0);
+
+		/* move the objects to this tick's pose, then rebuild the world matrices that changed (sleeping objects keep theirs) */
+		if (objectsLoaded)
+		{
+			for (uint32_t slot : entities.live())
+			{
+				// a slot respawned since this tick still holds its previous pose
+				if (slotShown(frameTransforms, slot))
+				{
+					sceneTransforms.set(firstMoverTransform + slot, frameTransforms.position[slot], frameTransforms.rotation[slot]);
+				}
+			}
+		}
+		sceneTransforms.update();
+
+		/*
+		**************************************************
+		*			Idle
+		**************************************************
+		*/
+		/* same camera, nothing moved and nothing new loaded: the frame on screen is still right, apart from the
+		   time-driven flicker, which is refreshed idleFrameRate times a second; sleep until input or the next refresh */
+		double frameTime = glfwGetTime();
+		if (idleFrameRate > 0.0f && !assetsArrived && !entitiesChanged && !windowDamaged && sceneTransforms.rebuiltCount() == 0 &&
+			ViewMatrix == drawnView && ProjectionMatrix == drawnProjection && frameTime - drawnTime < 1.0 / idleFrameRate)
+		{
+			glfwWaitEventsTimeout(drawnTime + 1.0 / idleFrameRate - frameTime);
+			continue;
+		}
+		drawnView = ViewMatrix;
+		drawnProjection = ProjectionMatrix;
+		drawnTime = frameTime;
+		windowDamaged = false;
+		numFrames++;
+
+		// draw into the scaled offscreen target, or straight into the window
+		int framebufferWidth, framebufferHeight;
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		int renderWidth = framebufferWidth, renderHeight = framebufferHeight;
+		if (offscreen)
+		{
+			resolution.beginFrame(framebufferWidth, framebufferHeight);
+			renderWidth = resolution.width();
+			renderHeight = resolution.height();
+		}
+
+		// clear the screen
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		// use our shader
 		glUseProgram(programID);
-		GLuint diffuseLocation = glGetUniformLocation(programID, "diffuseIntensity");
-		GLuint specularLocation = glGetUniformLocation(programID, "specularIntensity");
-		vec3 lightPos = vec3(5, 5, 5);
-		glUniform3f(LightID, lightPos.x, lightPos.y, lightPos.z);
 		glUniformMatrix4fv(ViewMatrixID, 1, GL_FALSE, &ViewMatrix[0][0]);
+		mat4 ViewProjectionMatrix = ProjectionMatrix * ViewMatrix;
+		glUniformMatrix4fv(ViewProjectionMatrixID, 1, GL_FALSE, &ViewProjectionMatrix[0][0]);
+		// bind the scene texture array once in Texture Unit 0 for every draw
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, SceneTextures);
+		// set our "myTextureSampler" sampler to user Texture Unit 0
+		glUniform1i(TextureID, 0);
+
+		/* move the candles with their pumpkins and flicker them, then bin every light into clusters
+		   on a job while this thread collects the entities */
+		JobCounter lightBinning;
+		if (shaderFeatures & SHADER_LIGHTING)
+		{
+			for (size_t i = 0; i < candleCount; i++)
+			{
+				PointLight& candle = sceneLights[firstCandle + i];
+				// no pumpkin yet (or no longer), no candle
+				const EntityHandle& pumpkin = candleMovers[i];
+				if (!objectsLoaded || !(replaying || entities.valid(pumpkin)) || frameTransforms.generation[pumpkin.index] != pumpkin.generation)
+				{
+					candle.power = 0.0f;
+					continue;
+				}
+				candle.position = frameTransforms.position[pumpkin.index];
+				candle.power = 12.0f * (0.8f + 0.2f * sin(currentTimePassShader * 11.0f + i * 1.7f) * sin(currentTimePassShader * 7.3f + i * 0.9f));
+			}
+			LightBinningJob* binning = frameArena.create<LightBinningJob>(LightBinningJob{ &lights, &sceneLights, ViewMatrix, ProjectionMatrix });
+			jobs.run(&binLights, binning, 0, 0, lightBinning);
+		}
 
 		/*
 		**************************************************
 		*			Render the Full Scene
 		**************************************************
 		*/
-		/* render the ghost and pumpkin objects! */
-		/* ghost! */
-		ModelMatrix = mat4(1.0);
-		ModelMatrix = translate(ModelMatrix, objects[3].position);
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(0.0f, 0.0f, 1.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(1.0f, 0.0f, 0.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(objects[3].rotation.y), vec3(0.0f, 1.0f, 0.0f));
-		mat4 MVP1 = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		// send our transformation to the currently bound shader
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP1[0][0]);
-		glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix[0][0]);
-		// bind our texture in Texture Unit 0
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, GhostTexture);
-		// set our "myTextureSampler" sampler to user Texture Unit 0
-		glUniform1i(TextureID, 0);
-		// 1st attribute buffer : vertices
-		glEnableVertexAttribArray(vertexPosition_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, ghostVertexBuffer);
-		glVertexAttribPointer
-		(
-			vertexPosition_modelspaceID, // The attribute we want to configure
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : UVs
-		glEnableVertexAttribArray(vertexUVID);
-		glBindBuffer(GL_ARRAY_BUFFER, ghostUVBuffer);
-		glVertexAttribPointer
-		(
-			vertexUVID,                       // The attribute we want to configure
-			2,                                // size : U+V => 2
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// 3rd attribute buffer : normals
-		glEnableVertexAttribArray(vertexNormal_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, ghostNormalBuffer);
-		glVertexAttribPointer
-		(
-			vertexNormal_modelspaceID,        // The attribute we want to configure
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// index buffer
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ghostElementBuffer);
-		// draw the triangles !
-		glDrawElements
-		(
-			GL_TRIANGLES,		// mode
-			ghostIndices.size(),// count
-			GL_UNSIGNED_SHORT,	// type
-			(void*)0			// element array buffer offset
-		);
-		// end ghost rendering
-		/* pumpkin 1 - middle */
-		ModelMatrix = mat4(1.0);
-		ModelMatrix = translate(ModelMatrix, objects[0].position);
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(0.0f, 0.0f, 1.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(1.0f, 0.0f, 0.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(objects[0].rotation.x), vec3(1.0f, 0.0f, 0.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(objects[0].rotation.y), vec3(0.0f, 1.0f, 0.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(objects[0].rotation.z), vec3(0.0f, 0.0f, 1.0f));
-		MVP1 = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		// send our transformation to the currently bound shader
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP1[0][0]);
-		glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix[0][0]);
-		// bind our texture in Texture Unit 0
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, Texture);
-		// set our "myTextureSampler" sampler to user Texture Unit 0
-		glUniform1i(TextureID, 0);
-		// 1st attribute buffer : vertices
-		glEnableVertexAttribArray(vertexPosition_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer
-		(
-			vertexPosition_modelspaceID, // The attribute we want to configure
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : UVs
-		glEnableVertexAttribArray(vertexUVID);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer
-		(
-			vertexUVID,                       // The attribute we want to configure
-			2,                                // size : U+V => 2
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// 3rd attribute buffer : normals
-		glEnableVertexAttribArray(vertexNormal_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, normalbuffer);
-		glVertexAttribPointer
-		(
-			vertexNormal_modelspaceID,        // The attribute we want to configure
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// index buffer
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
-		// draw the triangles !
-		glDrawElements
-		(
-			GL_TRIANGLES,      // mode
-			indices.size(),    // count
-			GL_UNSIGNED_SHORT, // type
-			(void*)0           // element array buffer offset
-		);
-		// end rendering of 1st pumpkin
-		/* pumpkin 2 - right */
-		ModelMatrix = mat4(1.0);
-		ModelMatrix = translate(ModelMatrix, objects[1].position);
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(0.0f, 0.65f, 0.9f));
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(1.0f, 0.0f, 0.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(objects[1].rotation.x), vec3(-1.0f, 0.0f, 0.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(objects[1].rotation.y), vec3(0.0f, -1.0f, 0.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(objects[1].rotation.z), vec3(0.0f, 0.0f, -1.0f));
-		MVP1 = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		// send our transformation to the currently bound shader
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP1[0][0]);
-		glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix[0][0]);
-		// bind our texture in Texture Unit 0
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, Texture);
-		// set our "myTextureSampler" sampler to user Texture Unit 0
-		glUniform1i(TextureID, 0);
-		// 1st attribute buffer : vertices
-		glEnableVertexAttribArray(vertexPosition_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer
-		(
-			vertexPosition_modelspaceID, // The attribute we want to configure
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : UVs
-		glEnableVertexAttribArray(vertexUVID);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer
-		(
-			vertexUVID,                       // The attribute we want to configure
-			2,                                // size : U+V => 2
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// 3rd attribute buffer : normals
-		glEnableVertexAttribArray(vertexNormal_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, normalbuffer);
-		glVertexAttribPointer
-		(
-			vertexNormal_modelspaceID,        // The attribute we want to configure
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// index buffer
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
-		// draw the triangles !
-		glDrawElements
-		(
-			GL_TRIANGLES,      // mode
-			indices.size(),    // count
-			GL_UNSIGNED_SHORT, // type
-			(void*)0           // element array buffer offset
-		);
-		// end rendering of 2nd pumpkin
-		/* pumpkin 3 - left */
-		ModelMatrix = mat4(1.0);
-		//ModelMatrix = translate(ModelMatrix, vec3(15.0f, -3.75f, 1.25f));
-		ModelMatrix = translate(ModelMatrix, objects[2].position);
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(0.65f, 0.0f, 1.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(1.0f, 0.0f, 0.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(objects[2].rotation.x), vec3(1.0f, 0.0f, 0.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(objects[2].rotation.y), vec3(0.0f, 1.0f, 0.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(objects[2].rotation.z), vec3(0.0f, 0.0f, 1.0f));
-		MVP1 = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		// send our transformation to the currently bound shader
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP1[0][0]);
-		glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix[0][0]);
-		// bind our texture in Texture Unit 0
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, Texture);
-		// set our "myTextureSampler" sampler to user Texture Unit 0
-		glUniform1i(TextureID, 0);
-		// 1st attribute buffer : vertices
-		glEnableVertexAttribArray(vertexPosition_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer
-		(
-			vertexPosition_modelspaceID, // The attribute we want to configure
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : UVs
-		glEnableVertexAttribArray(vertexUVID);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer
-		(
-			vertexUVID,                       // The attribute we want to configure
-			2,                                // size : U+V => 2
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// 3rd attribute buffer : normals
-		glEnableVertexAttribArray(vertexNormal_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, normalbuffer);
-		glVertexAttribPointer
-		(
-			vertexNormal_modelspaceID,        // The attribute we want to configure
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// index buffer
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
-		// draw the triangles !
-		glDrawElements
-		(
-			GL_TRIANGLES,      // mode
-			indices.size(),    // count
-			GL_UNSIGNED_SHORT, // type
-			(void*)0           // element array buffer offset
-		);
-		// end rendering of 3rd pumpkin
-		/* end 3D moving object rendering */
-
-		/* render the floor */
-		mat4 floorModel = mat4(1.0f);
-		mat4 floorMVP = ProjectionMatrix * ViewMatrix * floorModel;
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &floorMVP[0][0]);
-		glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &floorModel[0][0]);
-		// bind the floor texture
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, FloorTexture);
-		glUniform1i(TextureID, 1);
-		// bind buffers for floor
-		glEnableVertexAttribArray(vertexPosition_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, floorVertexBuffer);
-		glVertexAttribPointer
-		(
-			vertexPosition_modelspaceID, // The attribute we want to configure
-			3,                           // size
-			GL_FLOAT,                    // type
-			GL_FALSE,                    // normalized?
-			0,                           // stride
-			(void*)0                     // array buffer offset
-		);
-		glEnableVertexAttribArray(vertexUVID);
-		glBindBuffer(GL_ARRAY_BUFFER, floorUVBuffer);
-		glVertexAttribPointer
-		(
-			vertexUVID,                  // The attribute we want to configure
-			2,                           // size : U+V => 2
-			GL_FLOAT,                    // type
-			GL_FALSE,                    // normalized?
-			0,                           // stride
-			(void*)0                     // array buffer offset
-		);
-		glEnableVertexAttribArray(vertexNormal_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, floorNormalBuffer);
-		glVertexAttribPointer
-		(
-			vertexNormal_modelspaceID,   // The attribute we want to configure
-			3,                           // size
-			GL_FLOAT,                    // type
-			GL_FALSE,                    // normalized?
-			0,                           // stride
-			(void*)0                     // array buffer offset
-		);
-		// bind the element buffer
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, floorElementBuffer);
-		// draw the floor
-		glDrawElements
-		(
-			GL_TRIANGLES,				// mode
-			floor.floorIndices.size(),	// count
-			GL_UNSIGNED_SHORT,			// type
-			(void*)0					// element array buffer offset
-		);
-		// end floor rendering
-
-		/* render the background */
-		mat4 backgroundModel = mat4(1.0f);
-		mat4 backgroundMVP = ProjectionMatrix * ViewMatrix * backgroundModel;
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &backgroundMVP[0][0]);
-		glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &backgroundModel[0][0]);
-		// bind the background texture
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, BackgroundTexture);
-		glUniform1i(TextureID, 1);
-		// bind buffers for background
-		glEnableVertexAttribArray(vertexPosition_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, backgroundVertexBuffer);
-		glVertexAttribPointer
-		(
-			vertexPosition_modelspaceID, // The attribute we want to configure
-			3,                           // size
-			GL_FLOAT,                    // type
-			GL_FALSE,                    // normalized?
-			0,                           // stride
-			(void*)0                     // array buffer offset
-		);
-		glEnableVertexAttribArray(vertexUVID);
-		glBindBuffer(GL_ARRAY_BUFFER, backgroundUVBuffer);
-		glVertexAttribPointer
-		(
-			vertexUVID,                  // The attribute we want to configure
-			2,                           // size : U+V => 2
-			GL_FLOAT,                    // type
-			GL_FALSE,                    // normalized?
-			0,                           // stride
-			(void*)0                     // array buffer offset
-		);
-		glEnableVertexAttribArray(vertexNormal_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, backgroundNormalBuffer);
-		glVertexAttribPointer
-		(
-			vertexNormal_modelspaceID,   // The attribute we want to configure
-			3,                           // size
-			GL_FLOAT,                    // type
-			GL_FALSE,                    // normalized?
-			0,                           // stride
-			(void*)0                     // array buffer offset
-		);
-		// bind the element buffer
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, backgroundElementBuffer);
-		// draw the background
-		glDrawElements
-		(
-			GL_TRIANGLES,							// mode
-			background.backgroundIndices.size(),	// count
-			GL_UNSIGNED_SHORT,						// type
-			(void*)0								// element array buffer offset
-		);
-		// end background rendering
-
-		/* render the trees - EXTRA CREDIT */
-		// 1st tree
-		ModelMatrix = mat4(1.0);
-		ModelMatrix = translate(ModelMatrix, vec3(-18.75f, 17.0f, 1.15f));
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(0.0f, 0.0f, 1.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(1.0f, 0.0f, 0.0f));
-		MVP1 = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		// send our transformation to the currently bound shader
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP1[0][0]);
-		glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix[0][0]);
-		// bind our texture in Texture Unit 0
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TreeTexture);
-		// set our "myTextureSampler" sampler to user Texture Unit 0
-		glUniform1i(TextureID, 0);
-		// 1st attribute buffer : vertices
-		glEnableVertexAttribArray(vertexPosition_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, treeVertexBuffer);
-		glVertexAttribPointer
-		(
-			vertexPosition_modelspaceID, // The attribute we want to configure
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : UVs
-		glEnableVertexAttribArray(vertexUVID);
-		glBindBuffer(GL_ARRAY_BUFFER, treeUVBuffer);
-		glVertexAttribPointer
-		(
-			vertexUVID,                       // The attribute we want to configure
-			2,                                // size : U+V => 2
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// 3rd attribute buffer : normals
-		glEnableVertexAttribArray(vertexNormal_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, treeNormalBuffer);
-		glVertexAttribPointer
-		(
-			vertexNormal_modelspaceID,        // The attribute we want to configure
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// index buffer
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, treeElementBuffer);
-		// draw the triangles !
-		glDrawElements
-		(
-			GL_TRIANGLES,		// mode
-			treeIndices.size(),// count
-			GL_UNSIGNED_SHORT,	// type
-			(void*)0			// element array buffer offset
-		);
-		// end rendering of 1st tree
-		// 2nd tree!
-		ModelMatrix = mat4(1.0);
-		ModelMatrix = translate(ModelMatrix, vec3(-18.75f, -17.0f, 1.15f));
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(0.0f, 0.0f, 1.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(1.0f, 0.0f, 0.0f));
-		MVP1 = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		// send our transformation to the currently bound shader
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP1[0][0]);
-		glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix[0][0]);
-		// bind our texture in Texture Unit 0
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TreeTexture);
-		// set our "myTextureSampler" sampler to user Texture Unit 0
-		glUniform1i(TextureID, 0);
-		// 1st attribute buffer : vertices
-		glEnableVertexAttribArray(vertexPosition_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, treeVertexBuffer);
-		glVertexAttribPointer
-		(
-			vertexPosition_modelspaceID, // The attribute we want to configure
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : UVs
-		glEnableVertexAttribArray(vertexUVID);
-		glBindBuffer(GL_ARRAY_BUFFER, treeUVBuffer);
-		glVertexAttribPointer
-		(
-			vertexUVID,                       // The attribute we want to configure
-			2,                                // size : U+V => 2
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// 3rd attribute buffer : normals
-		glEnableVertexAttribArray(vertexNormal_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, treeNormalBuffer);
-		glVertexAttribPointer
-		(
-			vertexNormal_modelspaceID,        // The attribute we want to configure
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// index buffer
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, treeElementBuffer);
-		// draw the triangles !
-		glDrawElements
-		(
-			GL_TRIANGLES,		// mode
-			treeIndices.size(),// count
-			GL_UNSIGNED_SHORT,	// type
-			(void*)0			// element array buffer offset
-		);
-		// end rendering of 2nd tree
-		// 3rd tree!
-		ModelMatrix = mat4(1.0);
-		ModelMatrix = translate(ModelMatrix, vec3(-18.75f, 0.0f, 1.15f));
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(0.0f, 0.0f, 1.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(1.0f, 0.0f, 0.0f));
-		MVP1 = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		// send our transformation to the currently bound shader
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP1[0][0]);
-		glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix[0][0]);
-		// bind our texture in Texture Unit 0
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TreeTexture);
-		// set our "myTextureSampler" sampler to user Texture Unit 0
-		glUniform1i(TextureID, 0);
-		// 1st attribute buffer : vertices
-		glEnableVertexAttribArray(vertexPosition_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, treeVertexBuffer);
-		glVertexAttribPointer
-		(
-			vertexPosition_modelspaceID, // The attribute we want to configure
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : UVs
-		glEnableVertexAttribArray(vertexUVID);
-		glBindBuffer(GL_ARRAY_BUFFER, treeUVBuffer);
-		glVertexAttribPointer
-		(
-			vertexUVID,                       // The attribute we want to configure
-			2,                                // size : U+V => 2
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// 3rd attribute buffer : normals
-		glEnableVertexAttribArray(vertexNormal_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, treeNormalBuffer);
-		glVertexAttribPointer
-		(
-			vertexNormal_modelspaceID,        // The attribute we want to configure
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// index buffer
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, treeElementBuffer);
-		// draw the triangles !
-		glDrawElements
-		(
-			GL_TRIANGLES,		// mode
-			treeIndices.size(),// count
-			GL_UNSIGNED_SHORT,	// type
-			(void*)0			// element array buffer offset
-		);
-		// end rendering of 3rd tree
-		// 4th tree!
-		ModelMatrix = mat4(1.0);
-		ModelMatrix = translate(ModelMatrix, vec3(-18.75f, -9.25f, 1.15f));
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(0.0f, 0.0f, 1.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(1.0f, 0.0f, 0.0f));
-		MVP1 = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		// send our transformation to the currently bound shader
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP1[0][0]);
-		glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix[0][0]);
-		// bind our texture in Texture Unit 0
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TreeTexture);
-		// set our "myTextureSampler" sampler to user Texture Unit 0
-		glUniform1i(TextureID, 0);
-		// 1st attribute buffer : vertices
-		glEnableVertexAttribArray(vertexPosition_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, treeVertexBuffer);
-		glVertexAttribPointer
-		(
-			vertexPosition_modelspaceID, // The attribute we want to configure
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : UVs
-		glEnableVertexAttribArray(vertexUVID);
-		glBindBuffer(GL_ARRAY_BUFFER, treeUVBuffer);
-		glVertexAttribPointer
-		(
-			vertexUVID,                       // The attribute we want to configure
-			2,                                // size : U+V => 2
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// 3rd attribute buffer : normals
-		glEnableVertexAttribArray(vertexNormal_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, treeNormalBuffer);
-		glVertexAttribPointer
-		(
-			vertexNormal_modelspaceID,        // The attribute we want to configure
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// index buffer
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, treeElementBuffer);
-		// draw the triangles !
-		glDrawElements
-		(
-			GL_TRIANGLES,		// mode
-			treeIndices.size(),// count
-			GL_UNSIGNED_SHORT,	// type
-			(void*)0			// element array buffer offset
-		);
-		// end rendering of 4th tree
-		// 5th tree!
-		ModelMatrix = mat4(1.0);
-		ModelMatrix = translate(ModelMatrix, vec3(-18.75f, 9.25f, 1.15f));
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(0.0f, 0.0f, 1.0f));
-		ModelMatrix = rotate(ModelMatrix, radians(90.0f), vec3(1.0f, 0.0f, 0.0f));
-		MVP1 = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		// send our transformation to the currently bound shader
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP1[0][0]);
-		glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix[0][0]);
-		// bind our texture in Texture Unit 0
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TreeTexture);
-		// set our "myTextureSampler" sampler to user Texture Unit 0
-		glUniform1i(TextureID, 0);
-		// 1st attribute buffer : vertices
-		glEnableVertexAttribArray(vertexPosition_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, treeVertexBuffer);
-		glVertexAttribPointer
-		(
-			vertexPosition_modelspaceID, // The attribute we want to configure
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : UVs
-		glEnableVertexAttribArray(vertexUVID);
-		glBindBuffer(GL_ARRAY_BUFFER, treeUVBuffer);
-		glVertexAttribPointer
-		(
-			vertexUVID,                       // The attribute we want to configure
-			2,                                // size : U+V => 2
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// 3rd attribute buffer : normals
-		glEnableVertexAttribArray(vertexNormal_modelspaceID);
-		glBindBuffer(GL_ARRAY_BUFFER, treeNormalBuffer);
-		glVertexAttribPointer
-		(
-			vertexNormal_modelspaceID,        // The attribute we want to configure
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		// index buffer
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, treeElementBuffer);
-		// draw the triangles !
-		glDrawElements
-		(
-			GL_TRIANGLES,		// mode
-			treeIndices.size(),// count
-			GL_UNSIGNED_SHORT,	// type
-			(void*)0			// element array buffer offset
-		);
-		// end rendering of 5th tree
-		/* end tree rendering */
+		/* collect the moving objects (the ghost and pumpkins)! */
+		FrameAllocator<EntityInstance> frameEntities(frameArena);
+		EntityList sceneEntities(frameEntities);
+		sceneEntities.reserve(entityCapacity);
+		EntityInstance entity = {};
+		if (objectsLoaded)
+		{
+			for (uint32_t slot : entities.live())
+			{
+				if (!slotShown(frameTransforms, slot))
+				{
+					continue;
+				}
+				// the tag is the scene mover the slot's object was copied from
+				entity.model = sceneTransforms.world(firstMoverTransform + slot);
+				entity.meshID = sceneMeshes[scene.moverMesh(frameTransforms.tag[slot])];
+				entity.textureLayer = scene.moverTexture(frameTransforms.tag[slot]);
+				sceneEntities.push_back(entity);
+			}
+		}
+		/* end 3D moving object collection */
+
+		/* the floor */
+		entity.model = sceneTransforms.world(floorTransform);
+		entity.meshID = floorMesh;
+		entity.textureLayer = scene.floor.textureLayer;
+		sceneEntities.push_back(entity);
 
-		// disable vertex attribute arrays 
-		glDisableVertexAttribArray(vertexPosition_modelspaceID);
-		glDisableVertexAttribArray(vertexUVID);
-		glDisableVertexAttribArray(vertexNormal_modelspaceID);
+		/* the background */
+		entity.model = sceneTransforms.world(backgroundTransform);
+		entity.meshID = backgroundMesh;
+		entity.textureLayer = scene.background.textureLayer;
+		sceneEntities.push_back(entity);
+
+		/* the static objects (the trees - EXTRA CREDIT) whose meshes have arrived */
+		for (size_t i = 0; i < staticTransforms.size(); i++)
+		{
+			if (staticTransforms[i] != transformPending)
+			{
+				entity.model = sceneTransforms.world(staticTransforms[i]);
+				entity.meshID = sceneMeshes[scene.staticMesh(i)];
+				entity.textureLayer = scene.staticTexture(i);
+				sceneEntities.push_back(entity);
+			}
+		}
+		/* end static object collection */
+
+		/* order opaque objects nearest first so hidden fragments fail the depth test early */
+		if (frontToBack)
+		{
+			renderer.sortFrontToBack(sceneEntities, ViewMatrix);
+		}
+
+		/* the light lists are needed from here on */
+		if (shaderFeatures & SHADER_LIGHTING)
+		{
+			jobs.wait(lightBinning);
+			lights.upload();
+			// clusters are tiles of the target actually drawn to
+			lights.bind(programID, renderWidth, renderHeight);
+		}
+
+		/* cull the whole scene once on the GPU */
+		renderer.cull(sceneEntities, ViewProjectionMatrix);
+
+		/* depth pre-pass - depth only, so the shading pass runs once per visible pixel */
+		if (depthPrepass)
+		{
+			glUseProgram(depthProgramID);
+			glUniformMatrix4fv(DepthViewProjectionMatrixID, 1, GL_FALSE, &ViewProjectionMatrix[0][0]);
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+			renderer.submit();
+			glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+			// only the fragments that won the pre-pass get shaded
+			glUseProgram(programID);
+			glDepthFunc(GL_LEQUAL);
+			glDepthMask(GL_FALSE);
+		}
+
+		/* draw the whole scene with one multi-draw-indirect call */
+		renderer.submit();
+
+		if (depthPrepass)
+		{
+			glDepthFunc(GL_LESS);
+			glDepthMask(GL_TRUE);
+		}
 
 		/* end scene rendering */
 
+		// stretch the scaled frame over the window, smoothing its edges on the way with FXAA
+		if (offscreen)
+		{
+			resolution.endFrame(postFilter);
+		}
+
 		// swap buffers
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 
+		/* metrics of the frame just presented */
+		frameSeconds.observe(glfwGetTime() - frameTime);
+		framesTotal.add();
+		drawCallsTotal.add(renderer.stats().drawCalls - reportedStats.drawCalls);
+		trianglesTotal.add(renderer.stats().triangles - reportedStats.triangles);
+		reportedStats = renderer.stats();
+		submittedEntities.set((double)sceneEntities.size());
+		liveMovers.set((double)entities.size());
+
 	}
 	// check if the ESC key was pressed or the window was closed
 	while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS && glfwWindowShouldClose(window) == 0);
 
+	// stop the physics thread before anything it uses goes away, then the workers it submits to
+	physicsRunning = false;
+	if (physicsThread.joinable())
+	{
+		physicsThread.join();
+	}
+	traceRecorder.close();
+	metricsExporter.stop();
+	jobs.stop();
+
 	/* cleanup VBO and shader */
-	glDeleteBuffers(1, &vertexbuffer);
-	glDeleteBuffers(1, &uvbuffer);
-	glDeleteBuffers(1, &normalbuffer);
-	glDeleteBuffers(1, &elementbuffer);
-	glDeleteBuffers(1, &floorVertexBuffer);
-	glDeleteBuffers(1, &floorUVBuffer);
-	glDeleteBuffers(1, &floorNormalBuffer);
-	glDeleteBuffers(1, &floorElementBuffer);
-	glDeleteBuffers(1, &backgroundVertexBuffer);
-	glDeleteBuffers(1, &backgroundUVBuffer);
-	glDeleteBuffers(1, &backgroundNormalBuffer);
-	glDeleteBuffers(1, &backgroundElementBuffer);
-	glDeleteBuffers(1, &ghostVertexBuffer);
-	glDeleteBuffers(1, &ghostUVBuffer);
-	glDeleteBuffers(1, &ghostNormalBuffer);
-	glDeleteBuffers(1, &ghostElementBuffer);
-	glDeleteBuffers(1, &treeVertexBuffer);
-	glDeleteBuffers(1, &treeUVBuffer);
-	glDeleteBuffers(1, &treeNormalBuffer);
-	glDeleteBuffers(1, &treeElementBuffer);
-	glDeleteTextures(1, &Texture);
-	glDeleteTextures(1, &BackgroundTexture);
-	glDeleteTextures(1, &FloorTexture);
-	glDeleteTextures(1, &GhostTexture);
-	glDeleteProgram(programID);
+	renderer.cleanup();
+	resolution.cleanup();
+	fxaa.cleanup();
+	lights.cleanup();
+	glDeleteTextures(1, &SceneTextures);
+	standardShading.cleanup();
 
 	// close OpenGL window and terminate GLFW
 	glfwTerminate();
 
+	if (checkAllocations)
+	{
+		if (allocationCheckFailures > 0)
+		{
+			printf("Allocation check failed: %d settled frames allocated from the heap\n", allocationCheckFailures);
+			return 1;
+		}
+		printf("Allocation check passed: no heap allocation in a settled frame\n");
+	}
 	return 0;
 } // end main method
@@ -0,0 +1,125 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Read-only memory maps for the asset parsers, so large files are paged
+* in by the OS instead of copied through stdio buffers.
+* 
+*/
+
+// include standard headers
+#include <stdio.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "mappedfile.hpp"
+
+bool MappedFile::open(const char* path)
+{
+	close();
+#ifdef _WIN32
+	HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize))
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+	file = fileHandle;
+	length = (size_t)fileSize.QuadPart;
+	if (length == 0)
+	{
+		return true;
+	}
+	mapping = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		close();
+		return false;
+	}
+	bytes = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	descriptor = ::open(path, O_RDONLY);
+	if (descriptor < 0)
+	{
+		return false;
+	}
+	struct stat status;
+	if (fstat(descriptor, &status) != 0)
+	{
+		close();
+		return false;
+	}
+	length = (size_t)status.st_size;
+	if (length == 0)
+	{
+		return true;
+	}
+	void* view = mmap(NULL, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	if (view != MAP_FAILED)
+	{
+		// parsed front to back once
+		madvise(view, length, MADV_SEQUENTIAL);
+		bytes = (const char*)view;
+	}
+#endif
+	if (bytes == nullptr)
+	{
+		close();
+		return false;
+	}
+	return true;
+} // end open method
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (bytes != nullptr)
+	{
+		UnmapViewOfFile(bytes);
+	}
+	if (mapping != nullptr)
+	{
+		CloseHandle(mapping);
+	}
+	if (file != nullptr)
+	{
+		CloseHandle(file);
+	}
+	mapping = nullptr;
+	file = nullptr;
+#else
+	if (bytes != nullptr)
+	{
+		munmap((void*)bytes, length);
+	}
+	if (descriptor >= 0)
+	{
+		::close(descriptor);
+	}
+	descriptor = -1;
+#endif
+	bytes = nullptr;
+	length = 0;
+} // end close method
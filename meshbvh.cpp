@@ -0,0 +1,463 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Per-mesh bounding volume hierarchies for the collision narrowphase.
+* A tree is built once per loaded mesh and cached next to the asset
+* (pumpkin.obj -> pumpkin.obj.bvh); the physics tick only walks it
+* when the bounding spheres of two movers already touch.
+* 
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+// include GLM
+#include <glm/glm.hpp>
+
+using namespace glm;
+using namespace std;
+
+#include "meshbvh.hpp"
+
+// triangles per leaf
+const unsigned int leafSize = 4;
+// triangle pairs gathered for the contact normal before the query stops
+const int maxContacts = 4;
+// cache file layout version, bump when BVHNode or the header changes
+const unsigned int cacheVersion = 1;
+
+/*
+***********************************************
+*		Geometry Helpers
+***********************************************
+*/
+/* closest point on triangle abc to p (Ericson, Real-Time Collision Detection 5.1.5) */
+static vec3 closestPointOnTriangle(const vec3& p, const vec3& a, const vec3& b, const vec3& c)
+{
+	vec3 ab = b - a, ac = c - a, ap = p - a;
+	float d1 = dot(ab, ap), d2 = dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f) return a;
+	vec3 bp = p - b;
+	float d3 = dot(ab, bp), d4 = dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3) return b;
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab * (d1 / (d1 - d3));
+	vec3 cp = p - c;
+	float d5 = dot(ab, cp), d6 = dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6) return c;
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac * (d2 / (d2 - d6));
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	float denom = 1.0f / (va + vb + vc);
+	return a + ab * (vb * denom) + ac * (vc * denom);
+} // end closestPointOnTriangle method
+
+/* does a ray from the origin cross triangle abc (Moller-Trumbore); skewed so it misses shared edges of axis-aligned meshes */
+static bool rayCrossesTriangle(const vec3& a, const vec3& b, const vec3& c)
+{
+	const vec3 direction(0.9431f, 0.2990f, 0.1455f);
+	vec3 e1 = b - a, e2 = c - a;
+	vec3 p = cross(direction, e2);
+	float det = dot(e1, p);
+	if (fabs(det) < 1e-12f)
+	{
+		return false;
+	}
+	vec3 s = -a;
+	float u = dot(s, p) / det;
+	if (u < 0.0f || u > 1.0f)
+	{
+		return false;
+	}
+	vec3 q = cross(s, e1);
+	float v = dot(direction, q) / det;
+	if (v < 0.0f || u + v > 1.0f)
+	{
+		return false;
+	}
+	return dot(e2, q) / det > 0.0f;
+} // end rayCrossesTriangle method
+
+/* do the projections of the two triangles on axis miss each other */
+static inline bool separatedOn(const vec3& axis, const vec3* a, const vec3* b)
+{
+	float a0 = dot(axis, a[0]), a1 = dot(axis, a[1]), a2 = dot(axis, a[2]);
+	float b0 = dot(axis, b[0]), b1 = dot(axis, b[1]), b2 = dot(axis, b[2]);
+	return std::max(a0, std::max(a1, a2)) < std::min(b0, std::min(b1, b2))
+		|| std::max(b0, std::max(b1, b2)) < std::min(a0, std::min(a1, a2));
+} // end separatedOn method
+
+/* separating axis test of two triangles given in the same space, cheapest axes first */
+static bool trianglesOverlap(const vec3* a, const vec3* b)
+{
+	// boxes of the triangles
+	vec3 minA = min(a[0], min(a[1], a[2])), maxA = max(a[0], max(a[1], a[2]));
+	vec3 minB = min(b[0], min(b[1], b[2])), maxB = max(b[0], max(b[1], b[2]));
+	if (any(lessThan(maxA, minB)) || any(lessThan(maxB, minA)))
+	{
+		return false;
+	}
+	// face normals
+	vec3 edgesA[3] = { a[1] - a[0], a[2] - a[1], a[0] - a[2] };
+	vec3 edgesB[3] = { b[1] - b[0], b[2] - b[1], b[0] - b[2] };
+	vec3 normalA = cross(edgesA[0], edgesA[1]);
+	vec3 normalB = cross(edgesB[0], edgesB[1]);
+	if (separatedOn(normalA, a, b) || separatedOn(normalB, a, b))
+	{
+		return false;
+	}
+	// coplanar triangles are only separated by in-plane edge normals
+	vec3 planeCross = cross(normalA, normalB);
+	if (dot(planeCross, planeCross) <= 1e-12f * dot(normalA, normalA) * dot(normalB, normalB))
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			if (separatedOn(cross(normalA, edgesA[i]), a, b) || separatedOn(cross(normalA, edgesB[i]), a, b))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	// edge pairs, parallel edges give a zero axis that never separates
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			vec3 axis = cross(edgesA[i], edgesB[j]);
+			if (dot(axis, axis) > 1e-20f && separatedOn(axis, a, b))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+} // end trianglesOverlap method
+
+/*
+***********************************************
+*		Build
+***********************************************
+*/
+/* split on the middle of the longest centroid axis, falling back to a median split */
+void MeshBVH::buildNode(unsigned int nodeIndex, vector<unsigned int>& order, const vector<vec3>& centroids,
+	const vector<vec3>& corners, unsigned int first, unsigned int count)
+{
+	vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+	vec3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+	for (unsigned int i = first; i < first + count; i++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+		{
+			boundsMin = min(boundsMin, corners[order[i] * 3 + corner]);
+			boundsMax = max(boundsMax, corners[order[i] * 3 + corner]);
+		}
+		centroidMin = min(centroidMin, centroids[order[i]]);
+		centroidMax = max(centroidMax, centroids[order[i]]);
+	}
+	nodes[nodeIndex].boundsMin = boundsMin;
+	nodes[nodeIndex].boundsMax = boundsMax;
+
+	if (count <= leafSize)
+	{
+		nodes[nodeIndex].first = first;
+		nodes[nodeIndex].triangleCount = count;
+		return;
+	}
+
+	vec3 extent = centroidMax - centroidMin;
+	int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+	float split = (centroidMin[axis] + centroidMax[axis]) * 0.5f;
+	auto middle = partition(order.begin() + first, order.begin() + first + count,
+		[&](unsigned int t) { return centroids[t][axis] < split; });
+	unsigned int leftCount = static_cast<unsigned int>(middle - (order.begin() + first));
+	if (leftCount == 0 || leftCount == count)
+	{
+		leftCount = count / 2;
+		nth_element(order.begin() + first, order.begin() + first + leftCount, order.begin() + first + count,
+			[&](unsigned int l, unsigned int r) { return centroids[l][axis] < centroids[r][axis]; });
+	}
+
+	// children are stored next to each other so an interior node only needs the left index
+	unsigned int left = static_cast<unsigned int>(nodes.size());
+	nodes.push_back(BVHNode());
+	nodes.push_back(BVHNode());
+	nodes[nodeIndex].first = left;
+	nodes[nodeIndex].triangleCount = 0;
+	buildNode(left, order, centroids, corners, first, leftCount);
+	buildNode(left + 1, order, centroids, corners, first + leftCount, count - leftCount);
+} // end buildNode method
+
+void MeshBVH::build(const vector<vec3>& vertices, const vector<unsigned short>& indices)
+{
+	unsigned int triangleCount = static_cast<unsigned int>(indices.size() / 3);
+	nodes.clear();
+	triangles.clear();
+	outerRadius = 0.0f;
+	innerRadius = 0.0f;
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	vector<vec3> corners(triangleCount * 3);
+	vector<vec3> centroids(triangleCount);
+	vector<unsigned int> order(triangleCount);
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+		{
+			corners[t * 3 + corner] = vertices[indices[t * 3 + corner]];
+		}
+		centroids[t] = (corners[t * 3] + corners[t * 3 + 1] + corners[t * 3 + 2]) / 3.0f;
+		order[t] = t;
+	}
+
+	nodes.reserve(triangleCount * 2);
+	nodes.push_back(BVHNode());
+	buildNode(0, order, centroids, corners, 0, triangleCount);
+
+	triangles.resize(triangleCount * 3);
+	for (unsigned int i = 0; i < triangleCount; i++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+		{
+			triangles[i * 3 + corner] = corners[order[i] * 3 + corner];
+		}
+	}
+
+	// spheres around the model origin: one containing the mesh, one inside it
+	float closest = FLT_MAX;
+	int crossings = 0;
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		const vec3* tri = &triangles[t * 3];
+		outerRadius = std::max(outerRadius, std::max(length(tri[0]), std::max(length(tri[1]), length(tri[2]))));
+		closest = std::min(closest, length(closestPointOnTriangle(vec3(0.0f), tri[0], tri[1], tri[2])));
+		crossings += rayCrossesTriangle(tri[0], tri[1], tri[2]) ? 1 : 0;
+	}
+	innerRadius = (crossings % 2 == 1) ? closest : 0.0f;
+} // end build method
+
+/*
+***********************************************
+*		Cache File
+***********************************************
+*/
+/* FNV-1a over the vertex and index data */
+uint64_t hashMesh(const vector<vec3>& vertices, const vector<unsigned short>& indices)
+{
+	uint64_t hash = 14695981039346656037ull;
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(vertices.data());
+	for (size_t i = 0; i < vertices.size() * sizeof(vec3); i++)
+	{
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+	bytes = reinterpret_cast<const unsigned char*>(indices.data());
+	for (size_t i = 0; i < indices.size() * sizeof(unsigned short); i++)
+	{
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+	return hash;
+} // end hashMesh method
+
+/* CacheHeader - start of a .bvh file */
+struct CacheHeader
+{
+	char magic[4];
+	unsigned int version;
+	uint64_t sourceHash;
+	unsigned int nodeCount;
+	unsigned int triangleCount;
+	float outerRadius;
+	float innerRadius;
+};
+
+bool MeshBVH::load(const char* path, uint64_t sourceHash)
+{
+	FILE* fp = fopen(path, "rb");
+	if (fp == NULL)
+	{
+		return false;
+	}
+	CacheHeader header;
+	bool valid = fread(&header, sizeof(header), 1, fp) == 1
+		&& strncmp(header.magic, "BVH ", 4) == 0
+		&& header.version == cacheVersion
+		&& header.sourceHash == sourceHash
+		&& header.nodeCount > 0;
+	if (valid)
+	{
+		nodes.resize(header.nodeCount);
+		triangles.resize(header.triangleCount * 3);
+		valid = fread(nodes.data(), sizeof(BVHNode), nodes.size(), fp) == nodes.size()
+			&& fread(triangles.data(), sizeof(vec3), triangles.size(), fp) == triangles.size();
+		outerRadius = header.outerRadius;
+		innerRadius = header.innerRadius;
+	}
+	fclose(fp);
+	// a damaged body must not send meshesOverlap past the end of either array, rebuild the tree instead
+	for (size_t i = 0; valid && i < nodes.size(); i++)
+	{
+		const BVHNode& node = nodes[i];
+		valid = node.triangleCount == 0
+			? (uint64_t)node.first + 1 < header.nodeCount
+			: (uint64_t)node.first + node.triangleCount <= header.triangleCount;
+	}
+	if (!valid)
+	{
+		nodes.clear();
+		triangles.clear();
+	}
+	return valid;
+} // end load method
+
+bool MeshBVH::save(const char* path, uint64_t sourceHash) const
+{
+	FILE* fp = fopen(path, "wb");
+	if (fp == NULL)
+	{
+		printf("%s could not be written.\n", path);
+		return false;
+	}
+	CacheHeader header;
+	memcpy(header.magic, "BVH ", 4);
+	header.version = cacheVersion;
+	header.sourceHash = sourceHash;
+	header.nodeCount = static_cast<unsigned int>(nodes.size());
+	header.triangleCount = static_cast<unsigned int>(triangles.size() / 3);
+	header.outerRadius = outerRadius;
+	header.innerRadius = innerRadius;
+	bool written = fwrite(&header, sizeof(header), 1, fp) == 1
+		&& fwrite(nodes.data(), sizeof(BVHNode), nodes.size(), fp) == nodes.size()
+		&& fwrite(triangles.data(), sizeof(vec3), triangles.size(), fp) == triangles.size();
+	fclose(fp);
+	return written;
+} // end save method
+
+void loadOrBuildMeshBVH(MeshBVH& bvh, const char* meshPath, const vector<vec3>& vertices, const vector<unsigned short>& indices)
+{
+	string cachePath = string(meshPath) + ".bvh";
+	uint64_t hash = hashMesh(vertices, indices);
+	if (bvh.load(cachePath.c_str(), hash))
+	{
+		return;
+	}
+	printf("Building collision tree for %s\n", meshPath);
+	bvh.build(vertices, indices);
+	bvh.save(cachePath.c_str(), hash);
+} // end loadOrBuildMeshBVH method
+
+/*
+***********************************************
+*		Mesh-Mesh Query
+***********************************************
+*/
+/* walk both trees together; boxes of b are moved into a's model space and re-boxed, triangles tested exactly */
+bool meshesOverlap(const MeshBVH& a, const mat4& worldA, const MeshBVH& b, const mat4& worldB, vec3& normal)
+{
+	if (a.empty() || b.empty())
+	{
+		return false;
+	}
+	mat4 bToA = inverse(worldA) * worldB;
+	mat3 rotation(bToA);
+	mat3 absRotation;
+	for (int column = 0; column < 3; column++)
+	{
+		absRotation[column] = abs(rotation[column]);
+	}
+	vec3 translation(bToA[3]);
+
+	// pair stack, reused between queries on the same thread
+	static thread_local vector<pair<unsigned int, unsigned int>> stack;
+	stack.clear();
+	stack.push_back(make_pair(0u, 0u));
+
+	vec3 contactNormal(0.0f);
+	int contacts = 0;
+	while (!stack.empty() && contacts < maxContacts)
+	{
+		pair<unsigned int, unsigned int> top = stack.back();
+		stack.pop_back();
+		const BVHNode& nodeA = a.nodes[top.first];
+		const BVHNode& nodeB = b.nodes[top.second];
+
+		// box of b in a's space
+		vec3 center = rotation * ((nodeB.boundsMin + nodeB.boundsMax) * 0.5f) + translation;
+		vec3 extent = absRotation * ((nodeB.boundsMax - nodeB.boundsMin) * 0.5f);
+		if (any(lessThan(center + extent, nodeA.boundsMin)) || any(greaterThan(center - extent, nodeA.boundsMax)))
+		{
+			continue;
+		}
+
+		bool leafA = nodeA.triangleCount > 0, leafB = nodeB.triangleCount > 0;
+		if (leafA && leafB)
+		{
+			for (unsigned int j = 0; j < nodeB.triangleCount; j++)
+			{
+				const vec3* source = &b.triangles[(nodeB.first + j) * 3];
+				vec3 triangleB[3] = { rotation * source[0] + translation, rotation * source[1] + translation, rotation * source[2] + translation };
+				for (unsigned int i = 0; i < nodeA.triangleCount; i++)
+				{
+					const vec3* triangleA = &a.triangles[(nodeA.first + i) * 3];
+					if (trianglesOverlap(triangleA, triangleB))
+					{
+						// a's outward normal points at b, b's points back at a
+						vec3 normalA = cross(triangleA[1] - triangleA[0], triangleA[2] - triangleA[0]);
+						vec3 normalB = cross(triangleB[1] - triangleB[0], triangleB[2] - triangleB[0]);
+						float lengthA = length(normalA), lengthB = length(normalB);
+						if (lengthA > 0.0f) contactNormal += normalA / lengthA;
+						if (lengthB > 0.0f) contactNormal -= normalB / lengthB;
+						contacts++;
+					}
+				}
+			}
+			continue;
+		}
+		// descend the bigger node so both sides shrink together
+		vec3 sizeA = nodeA.boundsMax - nodeA.boundsMin;
+		if (leafB || (!leafA && dot(sizeA, sizeA) >= dot(extent, extent) * 4.0f))
+		{
+			stack.push_back(make_pair(nodeA.first, top.second));
+			stack.push_back(make_pair(nodeA.first + 1, top.second));
+		}
+		else
+		{
+			stack.push_back(make_pair(top.first, nodeB.first));
+			stack.push_back(make_pair(top.first, nodeB.first + 1));
+		}
+	}
+	if (contacts == 0)
+	{
+		return false;
+	}
+
+	// fall back to the centre line when the triangle normals cancel out (or the mesh is wound inside out)
+	vec3 centreLine = vec3(worldB[3]) - vec3(worldA[3]);
+	normal = mat3(worldA) * contactNormal;
+	if (dot(normal, normal) < 1e-12f || dot(normal, centreLine) < 0.0f)
+	{
+		normal = centreLine;
+	}
+	float normalLength = length(normal);
+	normal = normalLength > 0.0f ? normal / normalLength : vec3(0.0f, 0.0f, 1.0f);
+	return true;
+} // end meshesOverlap method
@@ -0,0 +1,52 @@
+#ifndef MESHBVH_HPP
+#define MESHBVH_HPP
+
+#include <vector>
+#include <stdint.h>
+
+/* BVHNode - axis-aligned box of a subtree; leaves list triangles, interior nodes point at two adjacent children */
+struct BVHNode
+{
+	glm::vec3 boundsMin;
+	unsigned int first;			// first triangle (leaf) or left child, right child is first + 1
+	glm::vec3 boundsMax;
+	unsigned int triangleCount;	// 0 for interior nodes
+};
+
+/* MeshBVH - bounding volume hierarchy over the triangles of one mesh, in model space */
+class MeshBVH
+{
+public:
+	// build from an indexed mesh (the output of indexVertices)
+	void build(const std::vector<glm::vec3>& vertices, const std::vector<unsigned short>& indices);
+	// read / write the cache file; load fails when the file is missing, stale or corrupt
+	bool load(const char* path, uint64_t sourceHash);
+	bool save(const char* path, uint64_t sourceHash) const;
+
+	bool empty() const { return nodes.empty(); }
+	// sphere around the model-space origin that contains the whole mesh
+	float boundingRadius() const { return outerRadius; }
+	// sphere around the model-space origin that lies entirely inside the mesh (0 if the origin is outside)
+	float coreRadius() const { return innerRadius; }
+
+	std::vector<BVHNode> nodes;
+	std::vector<glm::vec3> triangles;	// 3 corners per triangle, in leaf order
+
+private:
+	void buildNode(unsigned int nodeIndex, std::vector<unsigned int>& order, const std::vector<glm::vec3>& centroids,
+		const std::vector<glm::vec3>& corners, unsigned int first, unsigned int count);
+
+	float outerRadius = 0.0f;
+	float innerRadius = 0.0f;
+};
+
+// hash of the mesh data, stored in the cache so edits to the asset rebuild the tree
+uint64_t hashMesh(const std::vector<glm::vec3>& vertices, const std::vector<unsigned short>& indices);
+// load meshPath.bvh if it matches the mesh, otherwise build the tree and write the cache next to the asset
+void loadOrBuildMeshBVH(MeshBVH& bvh, const char* meshPath,
+	const std::vector<glm::vec3>& vertices, const std::vector<unsigned short>& indices);
+// exact triangle-level overlap of two posed meshes; on contact returns the normal from a towards b in world space
+bool meshesOverlap(const MeshBVH& a, const glm::mat4& worldA, const MeshBVH& b, const glm::mat4& worldB,
+	glm::vec3& normal);
+
+#endif
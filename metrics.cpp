@@ -0,0 +1,510 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Runtime metrics. Counters and histograms are recorded into a shard
+* owned by the recording thread, with plain relaxed stores and no lock,
+* and gauges are single atomics; the exporter thread sums the shards when
+* it reports. Reports are Prometheus text served on a localhost port
+* (scraped at /metrics) and optional CSV rows appended to a file.
+* 
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdarg.h>
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#define closeSocket closesocket
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#define closeSocket close
+#endif
+
+// a scraper hanging up early must not raise SIGPIPE
+#ifdef MSG_NOSIGNAL
+const int sendFlags = MSG_NOSIGNAL;
+#else
+const int sendFlags = 0;
+#endif
+
+using namespace std;
+
+#include "metrics.hpp"
+
+MetricsRegistry metrics;
+
+thread_local MetricsRegistry* MetricsRegistry::threadRegistry = nullptr;
+thread_local MetricShard* MetricsRegistry::threadShard = nullptr;
+
+// largest request read before answering, only the request line matters
+const size_t maxRequestBytes = 2048;
+// how long the exporter waits for a connection before it checks for the CSV row and for stop()
+const int exporterPollMilliseconds = 100;
+
+/* printf onto the end of a buffer; grows it only when a report outgrows every earlier one */
+static void appendf(vector<char>& out, const char* format, ...)
+{
+	char line[512];
+	va_list arguments;
+	va_start(arguments, format);
+	int length = vsnprintf(line, sizeof(line), format, arguments);
+	va_end(arguments);
+	if (length > 0)
+	{
+		out.insert(out.end(), line, line + std::min((size_t)length, sizeof(line) - 1));
+	}
+} // end appendf method
+
+/*
+***********************************************
+*		Recording
+***********************************************
+*/
+MetricShard::MetricShard()
+{
+	for (auto& slot : slots)
+	{
+		slot.store(0, memory_order_relaxed);
+	}
+} // end MetricShard constructor
+
+void MetricHistogram::observe(double value) const
+{
+	MetricShard& shard = registry->shard();
+	size_t bucket = 0;
+	while (bucket < boundCount && value > bounds[bucket])
+	{
+		bucket++;
+	}
+	atomic<uint64_t>& count = shard.slots[slot + bucket];
+	count.store(count.load(memory_order_relaxed) + 1, memory_order_relaxed);
+	// the sum is kept as the bits of a double
+	atomic<uint64_t>& sumBits = shard.slots[slot + boundCount + 1];
+	uint64_t bits = sumBits.load(memory_order_relaxed);
+	double sum;
+	memcpy(&sum, &bits, sizeof(sum));
+	sum += value;
+	memcpy(&bits, &sum, sizeof(bits));
+	sumBits.store(bits, memory_order_relaxed);
+} // end observe method
+
+/*
+***********************************************
+*		Registry
+***********************************************
+*/
+MetricsRegistry::MetricsRegistry() : gauges(new atomic<uint64_t>[maxMetricGauges])
+{
+	for (size_t i = 0; i < maxMetricGauges; i++)
+	{
+		gauges[i].store(0, memory_order_relaxed);
+	}
+} // end MetricsRegistry constructor
+
+/* first record of this thread: give it a shard, kept after the thread ends so its counts still add up */
+void MetricsRegistry::attach()
+{
+	lock_guard<mutex> guard(lock);
+	shards.push_back(unique_ptr<MetricShard>(new MetricShard()));
+	threadShard = shards.back().get();
+	threadRegistry = this;
+} // end attach method
+
+/* a metric that does not fit is still handed out, recording into the spare slots past the last one reported */
+const MetricsRegistry::MetricInfo* MetricsRegistry::addMetric(const char* name, const char* help, MetricType type,
+	const vector<double>& bounds, size_t slots)
+{
+	lock_guard<mutex> guard(lock);
+	size_t& used = type == METRIC_GAUGE ? gaugeCount : slotCount;
+	size_t limit = type == METRIC_GAUGE ? maxMetricGauges - 1 : maxMetricSlots - 2;
+	if (used + slots > limit)
+	{
+		fprintf(stderr, "Metric %s does not fit in the registry, not reported\n", name);
+		return nullptr;
+	}
+	metrics.push_back({ name, help, type, bounds, used });
+	used += slots;
+	return &metrics.back();
+} // end addMetric method
+
+MetricCounter MetricsRegistry::counter(const char* name, const char* help)
+{
+	const MetricInfo* info = addMetric(name, help, METRIC_COUNTER, vector<double>(), 1);
+	MetricCounter counter;
+	counter.registry = this;
+	counter.slot = info != nullptr ? info->slot : maxMetricSlots - 2;
+	return counter;
+} // end counter method
+
+MetricGauge MetricsRegistry::gauge(const char* name, const char* help)
+{
+	const MetricInfo* info = addMetric(name, help, METRIC_GAUGE, vector<double>(), 1);
+	MetricGauge gauge;
+	gauge.value = &gauges[info != nullptr ? info->slot : maxMetricGauges - 1];
+	return gauge;
+} // end gauge method
+
+MetricHistogram MetricsRegistry::histogram(const char* name, const char* help, const vector<double>& bounds)
+{
+	const MetricInfo* info = addMetric(name, help, METRIC_HISTOGRAM, bounds, bounds.size() + 2);
+	MetricHistogram histogram;
+	histogram.registry = this;
+	if (info == nullptr)
+	{
+		// no buckets: the count and sum go to the two spare slots
+		histogram.slot = maxMetricSlots - 2;
+		return histogram;
+	}
+	histogram.slot = info->slot;
+	histogram.bounds = info->bounds.data();
+	histogram.boundCount = info->bounds.size();
+	return histogram;
+} // end histogram method
+
+/*
+***********************************************
+*		Reports
+***********************************************
+*/
+uint64_t MetricsRegistry::total(size_t slot) const
+{
+	uint64_t sum = 0;
+	for (const auto& shard : shards)
+	{
+		sum += shard->slots[slot].load(memory_order_relaxed);
+	}
+	return sum;
+} // end total method
+
+double MetricsRegistry::histogramSum(const MetricInfo& info) const
+{
+	double sum = 0.0;
+	for (const auto& shard : shards)
+	{
+		uint64_t bits = shard->slots[info.slot + info.bounds.size() + 1].load(memory_order_relaxed);
+		double shardSum;
+		memcpy(&shardSum, &bits, sizeof(shardSum));
+		sum += shardSum;
+	}
+	return sum;
+} // end histogramSum method
+
+/* the q quantile by linear interpolation inside its bucket, like Prometheus' histogram_quantile */
+double MetricsRegistry::quantile(const MetricInfo& info, double q) const
+{
+	size_t bucketCount = info.bounds.size() + 1;
+	uint64_t count = 0;
+	for (size_t b = 0; b < bucketCount; b++)
+	{
+		count += total(info.slot + b);
+	}
+	if (count == 0 || info.bounds.empty())
+	{
+		return 0.0;
+	}
+	double rank = q * (double)count;
+	uint64_t below = 0;
+	for (size_t b = 0; b < bucketCount; b++)
+	{
+		uint64_t inBucket = total(info.slot + b);
+		if ((double)(below + inBucket) >= rank && inBucket > 0)
+		{
+			// past the last bound all that is known is that it is above it
+			if (b == info.bounds.size())
+			{
+				return info.bounds.back();
+			}
+			double lower = b > 0 ? info.bounds[b - 1] : 0.0;
+			return lower + (info.bounds[b] - lower) * (rank - (double)below) / (double)inBucket;
+		}
+		below += inBucket;
+	}
+	return info.bounds.back();
+} // end quantile method
+
+void MetricsRegistry::writePrometheus(vector<char>& out)
+{
+	lock_guard<mutex> guard(lock);
+	for (const MetricInfo& info : metrics)
+	{
+		const char* typeName = info.type == METRIC_COUNTER ? "counter" : info.type == METRIC_GAUGE ? "gauge" : "histogram";
+		appendf(out, "# HELP %s %s\n# TYPE %s %s\n", info.name.c_str(), info.help.c_str(), info.name.c_str(), typeName);
+		if (info.type == METRIC_COUNTER)
+		{
+			appendf(out, "%s %llu\n", info.name.c_str(), (unsigned long long)total(info.slot));
+		}
+		else if (info.type == METRIC_GAUGE)
+		{
+			uint64_t bits = gauges[info.slot].load(memory_order_relaxed);
+			double value;
+			memcpy(&value, &bits, sizeof(value));
+			appendf(out, "%s %.17g\n", info.name.c_str(), value);
+		}
+		else
+		{
+			// Prometheus buckets are cumulative
+			uint64_t cumulative = 0;
+			for (size_t b = 0; b < info.bounds.size(); b++)
+			{
+				cumulative += total(info.slot + b);
+				appendf(out, "%s_bucket{le=\"%g\"} %llu\n", info.name.c_str(), info.bounds[b], (unsigned long long)cumulative);
+			}
+			cumulative += total(info.slot + info.bounds.size());
+			appendf(out, "%s_bucket{le=\"+Inf\"} %llu\n", info.name.c_str(), (unsigned long long)cumulative);
+			appendf(out, "%s_sum %.17g\n%s_count %llu\n", info.name.c_str(), histogramSum(info), info.name.c_str(),
+				(unsigned long long)cumulative);
+		}
+	}
+} // end writePrometheus method
+
+void MetricsRegistry::writeCSVHeader(vector<char>& out)
+{
+	lock_guard<mutex> guard(lock);
+	appendf(out, "time");
+	for (const MetricInfo& info : metrics)
+	{
+		if (info.type == METRIC_HISTOGRAM)
+		{
+			appendf(out, ",%s_count,%s_sum,%s_p50,%s_p99", info.name.c_str(), info.name.c_str(), info.name.c_str(), info.name.c_str());
+		}
+		else
+		{
+			appendf(out, ",%s", info.name.c_str());
+		}
+	}
+	appendf(out, "\n");
+} // end writeCSVHeader method
+
+void MetricsRegistry::writeCSVRow(vector<char>& out, double time)
+{
+	lock_guard<mutex> guard(lock);
+	appendf(out, "%.3f", time);
+	for (const MetricInfo& info : metrics)
+	{
+		if (info.type == METRIC_COUNTER)
+		{
+			appendf(out, ",%llu", (unsigned long long)total(info.slot));
+		}
+		else if (info.type == METRIC_GAUGE)
+		{
+			uint64_t bits = gauges[info.slot].load(memory_order_relaxed);
+			double value;
+			memcpy(&value, &bits, sizeof(value));
+			appendf(out, ",%g", value);
+		}
+		else
+		{
+			uint64_t count = 0;
+			for (size_t b = 0; b <= info.bounds.size(); b++)
+			{
+				count += total(info.slot + b);
+			}
+			appendf(out, ",%llu,%g,%g,%g", (unsigned long long)count, histogramSum(info), quantile(info, 0.5), quantile(info, 0.99));
+		}
+	}
+	appendf(out, "\n");
+} // end writeCSVRow method
+
+/*
+***********************************************
+*		Exporter
+***********************************************
+*/
+bool MetricsExporter::start(MetricsRegistry& metricsRegistry, int port, const char* csvPath, float csvInterval)
+{
+	stop();
+	registry = &metricsRegistry;
+	csvSeconds = csvInterval > 0.0f ? csvInterval : 1.0f;
+	// room for a report of every metric, so serving one allocates nothing
+	page.reserve(64 * 1024);
+	if (port > 0)
+	{
+#ifdef _WIN32
+		WSADATA winsock;
+		WSAStartup(MAKEWORD(2, 2), &winsock);
+#endif
+		listener = (intptr_t)socket(AF_INET, SOCK_STREAM, 0);
+		int reuse = 1;
+		setsockopt((int)listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+		// loopback only: the scraper runs on the same host
+		sockaddr_in address;
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		address.sin_port = htons((unsigned short)port);
+		if (listener < 0 || ::bind((int)listener, (const sockaddr*)&address, sizeof(address)) != 0 || listen((int)listener, 8) != 0)
+		{
+			fprintf(stderr, "Cannot serve metrics on 127.0.0.1:%d\n", port);
+			if (listener >= 0)
+			{
+				closeSocket((int)listener);
+			}
+			listener = -1;
+			return false;
+		}
+		printf("Metrics: http://127.0.0.1:%d/metrics\n", port);
+	}
+	if (csvPath != nullptr)
+	{
+		csv = fopen(csvPath, "w");
+		if (csv == nullptr)
+		{
+			fprintf(stderr, "Cannot write metrics to %s\n", csvPath);
+			stop();
+			return false;
+		}
+		page.clear();
+		registry->writeCSVHeader(page);
+		fwrite(page.data(), 1, page.size(), csv);
+		printf("Metrics: a row every %.1f s to %s\n", csvSeconds, csvPath);
+	}
+	if (listener < 0 && csv == nullptr)
+	{
+		return true;
+	}
+	running = true;
+	thread = std::thread(&MetricsExporter::run, this);
+	return true;
+} // end start method
+
+void MetricsExporter::stop()
+{
+	if (thread.joinable())
+	{
+		running = false;
+		thread.join();
+	}
+	if (listener >= 0)
+	{
+		closeSocket((int)listener);
+		listener = -1;
+	}
+	if (csv != nullptr)
+	{
+		fclose(csv);
+		csv = nullptr;
+	}
+} // end stop method
+
+/* thread method - answer scrapes as they come and write a CSV row whenever one is due */
+void MetricsExporter::run()
+{
+	auto startTime = chrono::steady_clock::now();
+	double nextRow = csvSeconds;
+	while (running.load())
+	{
+		if (listener >= 0)
+		{
+			fd_set readable;
+			FD_ZERO(&readable);
+			FD_SET((int)listener, &readable);
+			timeval timeout = { 0, exporterPollMilliseconds * 1000 };
+			if (select((int)listener + 1, &readable, nullptr, nullptr, &timeout) > 0)
+			{
+				serve();
+			}
+		}
+		else
+		{
+			this_thread::sleep_for(chrono::milliseconds(exporterPollMilliseconds));
+		}
+		double elapsed = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+		if (csv != nullptr && elapsed >= nextRow)
+		{
+			page.clear();
+			registry->writeCSVRow(page, elapsed);
+			fwrite(page.data(), 1, page.size(), csv);
+			fflush(csv);
+			nextRow += csvSeconds;
+		}
+	}
+} // end run method
+
+/* one HTTP/1.0 exchange: GET /metrics gets the report, anything else a 404 */
+void MetricsExporter::serve()
+{
+	int client = (int)accept((int)listener, nullptr, nullptr);
+	if (client < 0)
+	{
+		return;
+	}
+	// a scraper that connects and says nothing is not waited on for long
+#ifdef _WIN32
+	DWORD receiveTimeout = 1000;
+#else
+	timeval receiveTimeout = { 1, 0 };
+#endif
+	setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char*)&receiveTimeout, sizeof(receiveTimeout));
+	char request[maxRequestBytes];
+	size_t received = 0;
+	while (received < sizeof(request) - 1)
+	{
+		int length = (int)recv(client, request + received, (int)(sizeof(request) - 1 - received), 0);
+		if (length <= 0)
+		{
+			break;
+		}
+		received += (size_t)length;
+		request[received] = '\0';
+		if (strstr(request, "\r\n\r\n") != nullptr || strstr(request, "\n\n") != nullptr)
+		{
+			break;
+		}
+	}
+	request[received] = '\0';
+	bool metricsPath = strncmp(request, "GET /metrics ", 13) == 0 || strncmp(request, "GET /metrics?", 13) == 0;
+
+	page.clear();
+	if (metricsPath)
+	{
+		registry->writePrometheus(page);
+	}
+	else
+	{
+		appendf(page, "Not found, metrics are at /metrics\n");
+	}
+	char header[256];
+	int headerLength = snprintf(header, sizeof(header),
+		"HTTP/1.0 %s\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+		metricsPath ? "200 OK" : "404 Not Found", page.size());
+	send(client, header, headerLength, sendFlags);
+	size_t sent = 0;
+	while (sent < page.size())
+	{
+		int length = (int)send(client, page.data() + sent, (int)(page.size() - sent), sendFlags);
+		if (length <= 0)
+		{
+			break;
+		}
+		sent += (size_t)length;
+	}
+	closeSocket(client);
+} // end serve method
@@ -0,0 +1,157 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+// counter and histogram slots of every registered metric together, per thread, and gauges (each has spares)
+const size_t maxMetricSlots = 256;
+const size_t maxMetricGauges = 64;
+
+enum MetricType
+{
+	METRIC_COUNTER,
+	METRIC_GAUGE,
+	METRIC_HISTOGRAM
+};
+
+/* MetricShard - one thread's counters and histogram buckets; only that thread writes them, so an update is a
+   relaxed load and store, and readers sum the shards of every thread whenever they report */
+struct MetricShard
+{
+	MetricShard();
+	std::atomic<uint64_t> slots[maxMetricSlots];
+};
+
+class MetricsRegistry;
+
+/* MetricCounter - monotonic count, summed over the threads that add to it */
+class MetricCounter
+{
+public:
+	void add(uint64_t amount = 1) const;
+
+	MetricsRegistry* registry = nullptr;
+	size_t slot = 0;
+};
+
+/* MetricGauge - the last value set, from any thread */
+class MetricGauge
+{
+public:
+	void set(double value) const
+	{
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		this->value->store(bits, std::memory_order_relaxed);
+	}
+
+	std::atomic<uint64_t>* value = nullptr;
+};
+
+/* MetricHistogram - count of observations per bucket (value <= bound, then everything above), and their sum */
+class MetricHistogram
+{
+public:
+	void observe(double value) const;
+
+	MetricsRegistry* registry = nullptr;
+	size_t slot = 0;				// first bucket; the +Inf bucket and then the sum follow the bounded ones
+	const double* bounds = nullptr;
+	size_t boundCount = 0;
+};
+
+/* MetricsRegistry - the named metrics of the program; register them before the threads that record them
+   start, record from anywhere without locking, and report from a thread that is not in a hurry */
+class MetricsRegistry
+{
+public:
+	MetricsRegistry();
+	MetricCounter counter(const char* name, const char* help);
+	MetricGauge gauge(const char* name, const char* help);
+	// bounds in increasing order
+	MetricHistogram histogram(const char* name, const char* help, const std::vector<double>& bounds);
+
+	// this thread's shard, created the first time the thread records anything
+	MetricShard& shard()
+	{
+		if (threadRegistry != this)
+		{
+			attach();
+		}
+		return *threadShard;
+	}
+
+	// append every metric in the Prometheus text format
+	void writePrometheus(std::vector<char>& out);
+	// append the column names, then a row of values (histograms as count, sum, median and 99th percentile)
+	void writeCSVHeader(std::vector<char>& out);
+	void writeCSVRow(std::vector<char>& out, double time);
+
+private:
+	struct MetricInfo
+	{
+		std::string name;
+		std::string help;
+		MetricType type;
+		std::vector<double> bounds;
+		size_t slot;
+	};
+	void attach();
+	const MetricInfo* addMetric(const char* name, const char* help, MetricType type, const std::vector<double>& bounds, size_t slots);
+	// sum of one slot over every shard, lock held
+	uint64_t total(size_t slot) const;
+	double histogramSum(const MetricInfo& info) const;
+	double quantile(const MetricInfo& info, double q) const;
+
+	std::mutex lock;
+	std::deque<MetricInfo> metrics;		// a deque never moves its elements, histogram handles point into it
+	std::vector<std::unique_ptr<MetricShard>> shards;
+	size_t slotCount = 0;
+	std::unique_ptr<std::atomic<uint64_t>[]> gauges;
+	size_t gaugeCount = 0;
+	static thread_local MetricsRegistry* threadRegistry;
+	static thread_local MetricShard* threadShard;
+};
+
+inline void MetricCounter::add(uint64_t amount) const
+{
+	std::atomic<uint64_t>& value = registry->shard().slots[slot];
+	value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// every metric of the program
+extern MetricsRegistry metrics;
+
+/* MetricsExporter - a thread that serves the registry as Prometheus text on a localhost port and, optionally,
+   appends a CSV row of it to a file every few seconds; reports are formatted into a reused buffer */
+class MetricsExporter
+{
+public:
+	~MetricsExporter() { stop(); }
+	// port 0 serves nothing and csvPath null writes nothing; false with a message if either cannot be opened
+	bool start(MetricsRegistry& registry, int port, const char* csvPath, float csvInterval);
+	void stop();
+
+private:
+	void run();
+	void serve();
+
+	MetricsRegistry* registry = nullptr;
+	std::thread thread;
+	std::atomic<bool> running{ false };
+	intptr_t listener = -1;
+	FILE* csv = nullptr;
+	float csvSeconds = 1.0f;
+	std::vector<char> page;
+};
+
+#endif
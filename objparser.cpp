@@ -0,0 +1,261 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Parallel OBJ parser. The file is memory mapped and cut into chunks at
+* line boundaries; each chunk is parsed on its own job with from_chars
+* into chunk-local lists, the lists are joined in file order and the
+* triangle corners are then expanded in parallel. Face indices in an OBJ
+* file are absolute, so a chunk never needs to know what came before it.
+* Accepts the same subset of the format as the tutorial loadOBJ:
+* v, vt, vn and triangles written as v/vt/vn; other lines are skipped.
+* 
+* References:
+* loadOBJ() from Tutorial 9 Base Code from https://www.opengl-tutorial.org/
+*
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <atomic>
+#include <charconv>
+#include <system_error>
+
+// include GLM
+#include <glm/glm.hpp>
+
+using namespace glm;
+using namespace std;
+
+#include "objparser.hpp"
+#include "mappedfile.hpp"
+#include "jobsystem.hpp"
+
+// smallest chunk worth a job of its own
+const size_t minChunkBytes = 256 * 1024;
+// triangle corners expanded per job
+const size_t cornerGrain = 65536;
+
+/* OBJChunk - one run of whole lines and what was parsed from it */
+struct OBJChunk
+{
+	const char* begin;
+	const char* end;
+	vector<vec3> positions;
+	vector<vec2> uvs;
+	vector<vec3> normals;
+	vector<unsigned int> corners;	// position, uv and normal index (1-based) of every triangle corner
+	const char* failedLine = nullptr;
+	int failedLength = 0;
+};
+
+/*
+***********************************************
+*		Line Parsing
+***********************************************
+*/
+static inline bool isBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+} // end isBlank method
+
+static inline const char* skipBlanks(const char* p, const char* end)
+{
+	while (p < end && isBlank(*p))
+	{
+		p++;
+	}
+	return p;
+} // end skipBlanks method
+
+static inline bool parseFloat(const char*& p, const char* end, float& value)
+{
+	p = skipBlanks(p, end);
+	// fscanf accepts a leading plus sign, from_chars does not
+	if (p < end && *p == '+')
+	{
+		p++;
+	}
+	from_chars_result result = from_chars(p, end, value);
+	p = result.ptr;
+	return result.ec == errc();
+} // end parseFloat method
+
+static inline bool parseIndex(const char*& p, const char* end, unsigned int& index)
+{
+	from_chars_result result = from_chars(p, end, index);
+	p = result.ptr;
+	return result.ec == errc();
+} // end parseIndex method
+
+/* one "v/vt/vn" triangle corner */
+static inline bool parseCorner(const char*& p, const char* end, vector<unsigned int>& corners)
+{
+	unsigned int position, uv, normal;
+	p = skipBlanks(p, end);
+	if (!parseIndex(p, end, position) || p >= end || *p++ != '/' ||
+		!parseIndex(p, end, uv) || p >= end || *p++ != '/' ||
+		!parseIndex(p, end, normal))
+	{
+		return false;
+	}
+	corners.push_back(position);
+	corners.push_back(uv);
+	corners.push_back(normal);
+	return true;
+} // end parseCorner method
+
+static void parseChunk(OBJChunk& chunk)
+{
+	const char* p = chunk.begin;
+	while (p < chunk.end)
+	{
+		const char* lineEnd = (const char*)memchr(p, '\n', chunk.end - p);
+		if (lineEnd == nullptr)
+		{
+			lineEnd = chunk.end;
+		}
+		const char* q = skipBlanks(p, lineEnd);
+		bool parsed = true;
+		if (lineEnd - q >= 2 && q[0] == 'v' && isBlank(q[1]))
+		{
+			vec3 position;
+			q += 1;
+			parsed = parseFloat(q, lineEnd, position.x) && parseFloat(q, lineEnd, position.y) && parseFloat(q, lineEnd, position.z);
+			chunk.positions.push_back(position);
+		}
+		else if (lineEnd - q >= 3 && q[0] == 'v' && q[1] == 't' && isBlank(q[2]))
+		{
+			vec2 uv;
+			q += 2;
+			parsed = parseFloat(q, lineEnd, uv.x) && parseFloat(q, lineEnd, uv.y);
+			// invert V, the DDS textures are stored upside down
+			uv.y = -uv.y;
+			chunk.uvs.push_back(uv);
+		}
+		else if (lineEnd - q >= 3 && q[0] == 'v' && q[1] == 'n' && isBlank(q[2]))
+		{
+			vec3 normal;
+			q += 2;
+			parsed = parseFloat(q, lineEnd, normal.x) && parseFloat(q, lineEnd, normal.y) && parseFloat(q, lineEnd, normal.z);
+			chunk.normals.push_back(normal);
+		}
+		else if (lineEnd - q >= 2 && q[0] == 'f' && isBlank(q[1]))
+		{
+			// only the first triangle of a polygon is kept, like loadOBJ
+			q += 1;
+			parsed = parseCorner(q, lineEnd, chunk.corners) && parseCorner(q, lineEnd, chunk.corners) &&
+				parseCorner(q, lineEnd, chunk.corners);
+		}
+		if (!parsed)
+		{
+			chunk.failedLine = p;
+			chunk.failedLength = (int)std::min(lineEnd - p, (ptrdiff_t)40);
+			return;
+		}
+		p = lineEnd + 1;
+	}
+} // end parseChunk method
+
+/*
+***********************************************
+*		Parallel Parse
+***********************************************
+*/
+bool parseOBJ(const char* path, vector<vec3>& out_vertices, vector<vec2>& out_uvs, vector<vec3>& out_normals)
+{
+	MappedFile file;
+	if (!file.open(path))
+	{
+		printf("Impossible to open %s ! Are you in the right path ?\n", path);
+		return false;
+	}
+	const char* text = file.data();
+	size_t size = file.size();
+
+	// cut into chunks that end on a line break, a few per thread so stealing can balance them
+	size_t chunkCount = std::max((size_t)1, std::min(size / minChunkBytes, (size_t)(jobs.workerCount() + 1) * 4));
+	vector<OBJChunk> chunks(chunkCount);
+	const char* chunkBegin = text;
+	for (size_t c = 0; c < chunkCount; c++)
+	{
+		const char* chunkEnd = text + size;
+		if (c + 1 < chunkCount)
+		{
+			chunkEnd = std::max(chunkBegin, text + size * (c + 1) / chunkCount);
+			const char* lineBreak = (const char*)memchr(chunkEnd, '\n', text + size - chunkEnd);
+			chunkEnd = lineBreak != nullptr ? lineBreak + 1 : text + size;
+		}
+		chunks[c].begin = chunkBegin;
+		chunks[c].end = chunkEnd;
+		chunkBegin = chunkEnd;
+	}
+	jobs.parallelFor(chunkCount, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t c = begin; c < end; c++)
+		{
+			parseChunk(chunks[c]);
+		}
+	});
+
+	// join the chunk lists in file order
+	vector<vec3> positions;
+	vector<vec2> uvs;
+	vector<vec3> normals;
+	vector<unsigned int> corners;
+	for (const auto& chunk : chunks)
+	{
+		if (chunk.failedLine != nullptr)
+		{
+			printf("%s can't be read by our simple parser, near \"%.*s\"\n", path, chunk.failedLength, chunk.failedLine);
+			return false;
+		}
+		positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+		uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+		normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+		corners.insert(corners.end(), chunk.corners.begin(), chunk.corners.end());
+	}
+
+	// one output vertex per triangle corner, written in place by each job
+	size_t cornerCount = corners.size() / 3;
+	size_t first = out_vertices.size();
+	out_vertices.resize(first + cornerCount);
+	out_uvs.resize(first + cornerCount);
+	out_normals.resize(first + cornerCount);
+	atomic<bool> outOfRange(false);
+	jobs.parallelFor(cornerCount, cornerGrain, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			unsigned int position = corners[i * 3] - 1, uv = corners[i * 3 + 1] - 1, normal = corners[i * 3 + 2] - 1;
+			if (position >= positions.size() || uv >= uvs.size() || normal >= normals.size())
+			{
+				outOfRange = true;
+				return;
+			}
+			out_vertices[first + i] = positions[position];
+			out_uvs[first + i] = uvs[uv];
+			out_normals[first + i] = normals[normal];
+		}
+	});
+	if (outOfRange)
+	{
+		printf("%s has a face index out of range\n", path);
+		out_vertices.resize(first);
+		out_uvs.resize(first);
+		out_normals.resize(first);
+		return false;
+	}
+	return true;
+} // end parseOBJ method
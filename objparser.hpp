@@ -0,0 +1,11 @@
+#ifndef OBJPARSER_HPP
+#define OBJPARSER_HPP
+
+#include <vector>
+
+// drop-in replacement for loadOBJ (common/objloader) that memory maps the file and parses it in parallel;
+// appends exactly what loadOBJ appends: one vertex, uv (v flipped for DDS) and normal per triangle corner
+bool parseOBJ(const char* path, std::vector<glm::vec3>& out_vertices, std::vector<glm::vec2>& out_uvs,
+	std::vector<glm::vec3>& out_normals);
+
+#endif
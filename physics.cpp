@@ -0,0 +1,1250 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Physics of the moving objects. State is kept as structure-of-arrays
+* so the waveform and broadphase loops run 1, 4 (SSE2) or 8 (AVX2)
+* objects at a time; the widest kernel the CPU supports is picked at
+* runtime and the scalar version is always available.
+* Each fixed tick steers the movers towards their waveform targets,
+* sweeps them with continuous collision detection so fast movers
+* cannot tunnel, resolves contacts with mass-weighted impulses and
+* puts islands of resting movers to sleep. The floor, walls and ceiling
+* are half-space planes resolved in the same SIMD pass that integrates
+* positions. Movers with a collision
+* mesh are refined with a BVH query once their bounding spheres meet.
+* Large mover sets split the drive, broadphase, first impact sweep and
+* integration passes into jobs on the shared job system.
+* 
+*/
+
+// include standard headers
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+
+// include GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+using namespace glm;
+using namespace std;
+
+#include "physics.hpp"
+#include "meshbvh.hpp"
+#include "jobsystem.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PHYSICS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define PHYSICS_AVX2_TARGET
+#else
+#define PHYSICS_AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+// movers per job of the drive and integrate passes, smaller sets stay on the calling thread
+const size_t moverGrain = 4096;
+// awake movers per broadphase job, each is tested against every mover of its group
+const size_t broadphaseChunk = 64;
+// candidate pairs per time-of-impact job
+const size_t pairGrain = 512;
+
+/* index of the lowest set bit of a non-zero lane mask */
+static inline unsigned int lowestLane(int mask)
+{
+#ifdef _MSC_VER
+	unsigned long lane;
+	_BitScanForward(&lane, static_cast<unsigned long>(mask));
+	return static_cast<unsigned int>(lane);
+#else
+	return static_cast<unsigned int>(__builtin_ctz(static_cast<unsigned int>(mask)));
+#endif
+} // end lowestLane method
+
+/*
+***********************************************
+*		Mover Arrays
+***********************************************
+*/
+/* append one mover to every array */
+size_t MoverArrays::add(const vec3& position, const vec3& velocity, const vec3& rotation,
+	float moverRadius, float mass, const MotionParams& moverMotion)
+{
+	posX.push_back(position.x); posY.push_back(position.y); posZ.push_back(position.z);
+	velX.push_back(velocity.x); velY.push_back(velocity.y); velZ.push_back(velocity.z);
+	rotX.push_back(rotation.x); rotY.push_back(rotation.y); rotZ.push_back(rotation.z);
+	rotSpeedX.push_back(0.0f); rotSpeedY.push_back(0.0f); rotSpeedZ.push_back(0.0f);
+	radius.push_back(moverRadius);
+	coreRadius.push_back(moverRadius);
+	shape.push_back(NULL);
+	orientation.push_back(quat(1.0f, 0.0f, 0.0f, 0.0f));
+	unbake.push_back(quat(1.0f, 0.0f, 0.0f, 0.0f));
+	spinAxes.push_back(vec3(1.0f));
+	inverseMass.push_back(mass > 0.0f ? 1.0f / mass : 0.0f);
+	targetX.push_back(position.x); targetY.push_back(position.y); targetZ.push_back(position.z);
+	speed.push_back(0.0f); amplitude.push_back(0.0f); offset.push_back(0.0f);
+	phaseX.push_back(moverMotion.phase.x); phaseY.push_back(moverMotion.phase.y); phaseZ.push_back(moverMotion.phase.z);
+	motion.push_back(moverMotion);
+	asleep.push_back(0);
+	sleepTimer.push_back(0.0f);
+	active.push_back(1);
+	generation.push_back(0);
+	tag.push_back((unsigned int)count);
+	group.push_back(groupStart.empty() ? 0 : (unsigned int)(groupStart.size() - 1));
+	return count++;
+} // end add method
+
+size_t MoverArrays::append(size_t added)
+{
+	size_t first = count;
+	count += added;
+	posX.resize(count, 0.0f); posY.resize(count, 0.0f); posZ.resize(count, 0.0f);
+	velX.resize(count, 0.0f); velY.resize(count, 0.0f); velZ.resize(count, 0.0f);
+	rotX.resize(count, 0.0f); rotY.resize(count, 0.0f); rotZ.resize(count, 0.0f);
+	rotSpeedX.resize(count, 0.0f); rotSpeedY.resize(count, 0.0f); rotSpeedZ.resize(count, 0.0f);
+	radius.resize(count, 1.0f);
+	coreRadius.resize(count, 1.0f);
+	shape.resize(count, NULL);
+	orientation.resize(count, quat(1.0f, 0.0f, 0.0f, 0.0f));
+	unbake.resize(count, quat(1.0f, 0.0f, 0.0f, 0.0f));
+	spinAxes.resize(count, vec3(1.0f));
+	inverseMass.resize(count, 1.0f);
+	targetX.resize(count, 0.0f); targetY.resize(count, 0.0f); targetZ.resize(count, 0.0f);
+	speed.resize(count, 0.0f); amplitude.resize(count, 0.0f); offset.resize(count, 0.0f);
+	phaseX.resize(count, 0.0f); phaseY.resize(count, 0.0f); phaseZ.resize(count, 0.0f);
+	motion.resize(count, MotionParams());
+	asleep.resize(count, 0);
+	sleepTimer.resize(count, 0.0f);
+	active.resize(count, 1);
+	generation.resize(count, 0);
+	tag.resize(count);
+	group.resize(count, groupStart.empty() ? 0 : (unsigned int)(groupStart.size() - 1));
+	for (size_t i = first; i < count; i++)
+	{
+		tag[i] = (unsigned int)i;
+	}
+	return first;
+} // end append method
+
+/* swap the sphere for the mover's mesh, keeping the spheres as broadphase and fast-mover fallback */
+void MoverArrays::setShape(size_t i, const MeshBVH* bvh, const quat& meshOrientation, const vec3& meshSpinAxes,
+	const quat& bakedRotation)
+{
+	orientation[i] = meshOrientation;
+	unbake[i] = conjugate(bakedRotation);
+	spinAxes[i] = meshSpinAxes;
+	if (bvh == NULL || bvh->empty())
+	{
+		return;
+	}
+	shape[i] = bvh;
+	radius[i] = bvh->boundingRadius();
+	coreRadius[i] = bvh->coreRadius();
+} // end setShape method
+
+void MoverArrays::activate(size_t i, const MoverSpawn& spawn, unsigned int moverGeneration)
+{
+	posX[i] = spawn.position.x; posY[i] = spawn.position.y; posZ[i] = spawn.position.z;
+	velX[i] = spawn.velocity.x; velY[i] = spawn.velocity.y; velZ[i] = spawn.velocity.z;
+	rotX[i] = rotY[i] = rotZ[i] = 0.0f;
+	rotSpeedX[i] = rotSpeedY[i] = rotSpeedZ[i] = 0.0f;
+	radius[i] = coreRadius[i] = spawn.radius;
+	inverseMass[i] = spawn.mass > 0.0f ? 1.0f / spawn.mass : 0.0f;
+	shape[i] = NULL;
+	setShape(i, spawn.shape, spawn.orientation, spawn.spinAxes, spawn.bakedRotation);
+	targetX[i] = spawn.position.x; targetY[i] = spawn.position.y; targetZ[i] = spawn.position.z;
+	speed[i] = amplitude[i] = offset[i] = 0.0f;
+	phaseX[i] = spawn.motion.phase.x; phaseY[i] = spawn.motion.phase.y; phaseZ[i] = spawn.motion.phase.z;
+	motion[i] = spawn.motion;
+	asleep[i] = 0;
+	sleepTimer[i] = 0.0f;
+	active[i] = 1;
+	generation[i] = moverGeneration;
+	tag[i] = spawn.tag;
+} // end activate method
+
+void MoverArrays::deactivate(size_t i)
+{
+	velX[i] = velY[i] = velZ[i] = 0.0f;
+	rotSpeedX[i] = rotSpeedY[i] = rotSpeedZ[i] = 0.0f;
+	asleep[i] = 1;
+	sleepTimer[i] = 0.0f;
+	active[i] = 0;
+} // end deactivate method
+
+/* the movers already added (if any) close the previous group */
+void MoverArrays::beginGroup()
+{
+	if (groupStart.empty())
+	{
+		groupStart.push_back(0);
+	}
+	if (groupStart.back() < count)
+	{
+		groupStart.push_back(count);
+	}
+} // end beginGroup method
+
+/* orientation * spin about x, y, z * unbake: the spin stays about the mesh's original axes even
+   though the loader already turned its vertices */
+quat MoverArrays::worldRotation(size_t i, const vec3& rotation) const
+{
+	quat spin = orientation[i];
+	if (spinAxes[i].x != 0.0f) spin = spin * angleAxis(radians(rotation.x * spinAxes[i].x), vec3(1.0f, 0.0f, 0.0f));
+	if (spinAxes[i].y != 0.0f) spin = spin * angleAxis(radians(rotation.y * spinAxes[i].y), vec3(0.0f, 1.0f, 0.0f));
+	if (spinAxes[i].z != 0.0f) spin = spin * angleAxis(radians(rotation.z * spinAxes[i].z), vec3(0.0f, 0.0f, 1.0f));
+	return spin * unbake[i];
+} // end worldRotation method
+
+mat4 MoverArrays::transform(size_t i, const vec3& position, const vec3& rotation) const
+{
+	mat4 model = mat4_cast(worldRotation(i, rotation));
+	model[3] = vec4(position, 1.0f);
+	return model;
+} // end transform method
+
+/*
+***********************************************
+*		World Bounds
+***********************************************
+*/
+void WorldBounds::addPlane(const vec3& normal, float offset)
+{
+	float normalLength = length(normal);
+	BoundPlane plane = { normal / normalLength, offset / normalLength };
+	planes.push_back(plane);
+} // end addPlane method
+
+/* plane of the polygon's first three corners, flipped to face inside */
+void WorldBounds::addSurface(const vector<vec3>& polygon, const vec3& inside)
+{
+	if (polygon.size() < 3)
+	{
+		return;
+	}
+	vec3 normal = normalize(cross(polygon[1] - polygon[0], polygon[2] - polygon[0]));
+	if (dot(normal, inside - polygon[0]) < 0.0f)
+	{
+		normal = -normal;
+	}
+	addPlane(normal, dot(normal, polygon[0]));
+} // end addSurface method
+
+/* random motion for this tick, same ranges as the original per-object code */
+void randomizeMotion(MoverArrays& movers)
+{
+	for (size_t i = 0; i < movers.size(); i++)
+	{
+		// free pool slots have no motion to roll
+		if (!movers.active[i])
+		{
+			continue;
+		}
+		const MotionParams& motion = movers.motion[i];
+		movers.speed[i] = 1.0f + static_cast<float>(movers.random() % 100) / motion.speedDivisor;		// random speed of oscillation
+		movers.amplitude[i] = 1.0f + static_cast<float>(movers.random() % motion.amplitudeModulo) / motion.amplitudeDivisor;	// random amplitude of motion
+		movers.offset[i] = static_cast<float>(movers.random() % 5);										// random offset for initial position
+		movers.rotSpeedX[i] = static_cast<float>(movers.random() % 360) / motion.rotationDivisor.x;
+		movers.rotSpeedY[i] = static_cast<float>(movers.random() % 360) / motion.rotationDivisor.y;
+		movers.rotSpeedZ[i] = static_cast<float>(movers.random() % 360) / motion.rotationDivisor.z;
+	}
+} // end randomizeMotion method
+
+/*
+***********************************************
+*		Scalar Kernels
+***********************************************
+*/
+/* waveform target and rotation wrap, one mover at a time */
+static void driveScalar(MoverArrays& m, size_t begin, size_t end, float time, float deltaTime)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		float angle = time * m.speed[i];
+		m.targetX[i] = m.offset[i] + sin(angle + m.phaseX[i]) * m.amplitude[i];
+		m.targetY[i] = m.offset[i] + sin(angle + m.phaseY[i]) * m.amplitude[i];
+		m.targetZ[i] = m.offset[i] + sin(angle + m.phaseZ[i]) * m.amplitude[i];
+		// keep rotation within 0-360 degrees
+		float rx = m.rotX[i] + m.rotSpeedX[i] * deltaTime;
+		float ry = m.rotY[i] + m.rotSpeedY[i] * deltaTime;
+		float rz = m.rotZ[i] + m.rotSpeedZ[i] * deltaTime;
+		m.rotX[i] = rx - 360.0f * floor(rx / 360.0f);
+		m.rotY[i] = ry - 360.0f * floor(ry / 360.0f);
+		m.rotZ[i] = rz - 360.0f * floor(rz / 360.0f);
+	}
+} // end driveScalar method
+
+/* keep pair (i, j) unless it would be found twice - awake movers only pair with higher indices */
+static inline void addCandidate(const MoverArrays& m, MoverPairs& pairs, unsigned int i, unsigned int j)
+{
+	if (!m.active[j])
+	{
+		return;
+	}
+	if (j > i || (j < i && m.asleep[j]))
+	{
+		pairs.push_back(make_pair(i, j));
+	}
+} // end addCandidate method
+
+/* movers that mover i can pair with, the ones in its group */
+static inline void groupRange(const MoverArrays& m, unsigned int i, unsigned int& first, unsigned int& last)
+{
+	if (m.groupStart.empty())
+	{
+		first = 0;
+		last = static_cast<unsigned int>(m.size());
+		return;
+	}
+	unsigned int g = m.group[i];
+	first = static_cast<unsigned int>(m.groupStart[g]);
+	last = static_cast<unsigned int>(g + 1 < m.groupStart.size() ? m.groupStart[g + 1] : m.size());
+} // end groupRange method
+
+/* swept-sphere broadphase: overlap of the spheres that bound each mover's whole path this tick */
+static inline bool sweptOverlap(const MoverArrays& m, unsigned int i, unsigned int j)
+{
+	float dx = m.posX[j] - m.posX[i];
+	float dy = m.posY[j] - m.posY[i];
+	float dz = m.posZ[j] - m.posZ[i];
+	float reach = m.sweepRadius[i] + m.sweepRadius[j];
+	return dx * dx + dy * dy + dz * dz < reach * reach;
+} // end sweptOverlap method
+
+static void broadphaseScalar(const MoverArrays& m, size_t first, size_t last, bool anyAsleep, MoverPairs& pairs)
+{
+	for (size_t a = first; a < last; a++)
+	{
+		unsigned int i = m.awake[a];
+		unsigned int groupFirst, groupLast;
+		groupRange(m, i, groupFirst, groupLast);
+		for (unsigned int j = anyAsleep ? groupFirst : i + 1; j < groupLast; j++)
+		{
+			if (sweptOverlap(m, i, j))
+			{
+				addCandidate(m, pairs, i, j);
+			}
+		}
+	}
+} // end broadphaseScalar method
+
+/* move by velocity, then push the sphere out of every bound plane it crossed and reflect the velocity into it */
+static void integrateBoundedScalar(MoverArrays& m, size_t begin, size_t end, float duration)
+{
+	const vector<BoundPlane>& planes = m.bounds.planes;
+	float bounce = 1.0f + m.settings.wallRestitution;
+	for (size_t i = begin; i < end; i++)
+	{
+		vec3 position = m.position(i) + m.velocity(i) * duration;
+		vec3 velocity = m.velocity(i);
+		for (const BoundPlane& plane : planes)
+		{
+			float penetration = plane.offset + m.radius[i] - dot(plane.normal, position);
+			if (penetration > 0.0f)
+			{
+				position += plane.normal * penetration;
+				float intoPlane = dot(plane.normal, velocity);
+				if (intoPlane < 0.0f)
+				{
+					velocity -= plane.normal * (intoPlane * bounce);
+				}
+			}
+		}
+		m.posX[i] = position.x; m.posY[i] = position.y; m.posZ[i] = position.z;
+		m.velX[i] = velocity.x; m.velY[i] = velocity.y; m.velZ[i] = velocity.z;
+	}
+} // end integrateBoundedScalar method
+
+#ifdef PHYSICS_X86
+/*
+***********************************************
+*		SSE2 Kernels - 4 movers per step
+***********************************************
+*/
+/* sin() of 4 lanes: quadrant reduction then minimax polynomials on [-pi/4, pi/4] */
+static inline __m128 sinSSE2(__m128 x)
+{
+	__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.636619772f)));
+	__m128 q = _mm_cvtepi32_ps(quadrant);
+	// x - quadrant * pi/2 in three parts to keep precision
+	__m128 r = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(1.5703125f)));
+	r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(4.837512969970703125e-4f)));
+	r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(7.54978995489188216e-8f)));
+	__m128 r2 = _mm_mul_ps(r, r);
+
+	__m128 s = _mm_add_ps(_mm_set1_ps(8.3321608736e-3f), _mm_mul_ps(r2, _mm_set1_ps(-1.9515295891e-4f)));
+	s = _mm_add_ps(_mm_set1_ps(-1.6666654611e-1f), _mm_mul_ps(r2, s));
+	s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), s));
+
+	__m128 c = _mm_add_ps(_mm_set1_ps(-1.388731625493765e-3f), _mm_mul_ps(r2, _mm_set1_ps(2.443315711809948e-5f)));
+	c = _mm_add_ps(_mm_set1_ps(4.166664568298827e-2f), _mm_mul_ps(r2, c));
+	c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)), _mm_mul_ps(_mm_mul_ps(r2, r2), c));
+
+	// odd quadrants use the cosine polynomial, quadrants 2 and 3 flip the sign
+	__m128 useCos = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+	__m128 result = _mm_or_ps(_mm_and_ps(useCos, c), _mm_andnot_ps(useCos, s));
+	__m128 sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+	return _mm_xor_ps(result, sign);
+} // end sinSSE2 method
+
+/* floor() of 4 lanes without SSE4.1 */
+static inline __m128 floorSSE2(__m128 x)
+{
+	__m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+	__m128 tooBig = _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.0f));
+	return _mm_sub_ps(truncated, tooBig);
+} // end floorSSE2 method
+
+static inline __m128 wrapDegreesSSE2(__m128 r)
+{
+	return _mm_sub_ps(r, _mm_mul_ps(_mm_set1_ps(360.0f), floorSSE2(_mm_mul_ps(r, _mm_set1_ps(1.0f / 360.0f)))));
+} // end wrapDegreesSSE2 method
+
+static void driveSSE2(MoverArrays& m, size_t begin, size_t end, float time, float deltaTime)
+{
+	size_t i = begin;
+	__m128 t = _mm_set1_ps(time);
+	__m128 dt = _mm_set1_ps(deltaTime);
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 angle = _mm_mul_ps(t, _mm_loadu_ps(&m.speed[i]));
+		__m128 offset = _mm_loadu_ps(&m.offset[i]);
+		__m128 amplitude = _mm_loadu_ps(&m.amplitude[i]);
+		__m128 x = _mm_add_ps(offset, _mm_mul_ps(sinSSE2(_mm_add_ps(angle, _mm_loadu_ps(&m.phaseX[i]))), amplitude));
+		__m128 y = _mm_add_ps(offset, _mm_mul_ps(sinSSE2(_mm_add_ps(angle, _mm_loadu_ps(&m.phaseY[i]))), amplitude));
+		__m128 z = _mm_add_ps(offset, _mm_mul_ps(sinSSE2(_mm_add_ps(angle, _mm_loadu_ps(&m.phaseZ[i]))), amplitude));
+		_mm_storeu_ps(&m.targetX[i], x);
+		_mm_storeu_ps(&m.targetY[i], y);
+		_mm_storeu_ps(&m.targetZ[i], z);
+		_mm_storeu_ps(&m.rotX[i], wrapDegreesSSE2(_mm_add_ps(_mm_loadu_ps(&m.rotX[i]), _mm_mul_ps(_mm_loadu_ps(&m.rotSpeedX[i]), dt))));
+		_mm_storeu_ps(&m.rotY[i], wrapDegreesSSE2(_mm_add_ps(_mm_loadu_ps(&m.rotY[i]), _mm_mul_ps(_mm_loadu_ps(&m.rotSpeedY[i]), dt))));
+		_mm_storeu_ps(&m.rotZ[i], wrapDegreesSSE2(_mm_add_ps(_mm_loadu_ps(&m.rotZ[i]), _mm_mul_ps(_mm_loadu_ps(&m.rotSpeedZ[i]), dt))));
+	}
+	driveScalar(m, i, end, time, deltaTime);
+} // end driveSSE2 method
+
+/* distance-squared test of awake mover i against 4 others at once, no sqrt */
+static void broadphaseSSE2(const MoverArrays& m, size_t first, size_t last, bool anyAsleep, MoverPairs& pairs)
+{
+	for (size_t a = first; a < last; a++)
+	{
+		unsigned int i = m.awake[a];
+		unsigned int groupFirst, groupLast;
+		groupRange(m, i, groupFirst, groupLast);
+		__m128 x = _mm_set1_ps(m.posX[i]), y = _mm_set1_ps(m.posY[i]), z = _mm_set1_ps(m.posZ[i]);
+		__m128 sweep = _mm_set1_ps(m.sweepRadius[i]);
+		unsigned int j = anyAsleep ? groupFirst : i + 1;
+		for (; j + 4 <= groupLast; j += 4)
+		{
+			__m128 dx = _mm_sub_ps(_mm_loadu_ps(&m.posX[j]), x);
+			__m128 dy = _mm_sub_ps(_mm_loadu_ps(&m.posY[j]), y);
+			__m128 dz = _mm_sub_ps(_mm_loadu_ps(&m.posZ[j]), z);
+			__m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			__m128 reach = _mm_add_ps(_mm_loadu_ps(&m.sweepRadius[j]), sweep);
+			int hits = _mm_movemask_ps(_mm_cmplt_ps(distanceSquared, _mm_mul_ps(reach, reach)));
+			for (; hits != 0; hits &= hits - 1)
+			{
+				addCandidate(m, pairs, i, j + lowestLane(hits));
+			}
+		}
+		for (; j < groupLast; j++)
+		{
+			if (sweptOverlap(m, i, j))
+			{
+				addCandidate(m, pairs, i, j);
+			}
+		}
+	}
+} // end broadphaseSSE2 method
+
+/* integration and bound planes for 4 movers at a time, contacts become masks instead of branches */
+static void integrateBoundedSSE2(MoverArrays& m, size_t begin, size_t end, float duration)
+{
+	size_t i = begin;
+	__m128 dt = _mm_set1_ps(duration);
+	__m128 zero = _mm_setzero_ps();
+	__m128 bounce = _mm_set1_ps(1.0f + m.settings.wallRestitution);
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 vx = _mm_loadu_ps(&m.velX[i]), vy = _mm_loadu_ps(&m.velY[i]), vz = _mm_loadu_ps(&m.velZ[i]);
+		__m128 px = _mm_add_ps(_mm_loadu_ps(&m.posX[i]), _mm_mul_ps(vx, dt));
+		__m128 py = _mm_add_ps(_mm_loadu_ps(&m.posY[i]), _mm_mul_ps(vy, dt));
+		__m128 pz = _mm_add_ps(_mm_loadu_ps(&m.posZ[i]), _mm_mul_ps(vz, dt));
+		__m128 r = _mm_loadu_ps(&m.radius[i]);
+		for (const BoundPlane& plane : m.bounds.planes)
+		{
+			__m128 nx = _mm_set1_ps(plane.normal.x), ny = _mm_set1_ps(plane.normal.y), nz = _mm_set1_ps(plane.normal.z);
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, px), _mm_mul_ps(ny, py)), _mm_mul_ps(nz, pz));
+			__m128 penetration = _mm_max_ps(_mm_sub_ps(_mm_add_ps(_mm_set1_ps(plane.offset), r), distance), zero);
+			px = _mm_add_ps(px, _mm_mul_ps(nx, penetration));
+			py = _mm_add_ps(py, _mm_mul_ps(ny, penetration));
+			pz = _mm_add_ps(pz, _mm_mul_ps(nz, penetration));
+			__m128 intoPlane = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, vx), _mm_mul_ps(ny, vy)), _mm_mul_ps(nz, vz));
+			__m128 hit = _mm_and_ps(_mm_cmpgt_ps(penetration, zero), _mm_cmplt_ps(intoPlane, zero));
+			__m128 change = _mm_and_ps(hit, _mm_mul_ps(intoPlane, bounce));
+			vx = _mm_sub_ps(vx, _mm_mul_ps(nx, change));
+			vy = _mm_sub_ps(vy, _mm_mul_ps(ny, change));
+			vz = _mm_sub_ps(vz, _mm_mul_ps(nz, change));
+		}
+		_mm_storeu_ps(&m.posX[i], px); _mm_storeu_ps(&m.posY[i], py); _mm_storeu_ps(&m.posZ[i], pz);
+		_mm_storeu_ps(&m.velX[i], vx); _mm_storeu_ps(&m.velY[i], vy); _mm_storeu_ps(&m.velZ[i], vz);
+	}
+	integrateBoundedScalar(m, i, end, duration);
+} // end integrateBoundedSSE2 method
+
+/*
+***********************************************
+*		AVX2 Kernels - 8 movers per step
+***********************************************
+*/
+PHYSICS_AVX2_TARGET static inline __m256 sinAVX2(__m256 x)
+{
+	__m256 q = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(0.636619772f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	__m256i quadrant = _mm256_cvtps_epi32(q);
+	__m256 r = _mm256_fnmadd_ps(q, _mm256_set1_ps(1.5703125f), x);
+	r = _mm256_fnmadd_ps(q, _mm256_set1_ps(4.837512969970703125e-4f), r);
+	r = _mm256_fnmadd_ps(q, _mm256_set1_ps(7.54978995489188216e-8f), r);
+	__m256 r2 = _mm256_mul_ps(r, r);
+
+	__m256 s = _mm256_fmadd_ps(r2, _mm256_set1_ps(-1.9515295891e-4f), _mm256_set1_ps(8.3321608736e-3f));
+	s = _mm256_fmadd_ps(r2, s, _mm256_set1_ps(-1.6666654611e-1f));
+	s = _mm256_fmadd_ps(_mm256_mul_ps(r, r2), s, r);
+
+	__m256 c = _mm256_fmadd_ps(r2, _mm256_set1_ps(2.443315711809948e-5f), _mm256_set1_ps(-1.388731625493765e-3f));
+	c = _mm256_fmadd_ps(r2, c, _mm256_set1_ps(4.166664568298827e-2f));
+	c = _mm256_fmadd_ps(_mm256_mul_ps(r2, r2), c, _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), r2, _mm256_set1_ps(1.0f)));
+
+	__m256 useCos = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+	__m256 result = _mm256_blendv_ps(s, c, useCos);
+	__m256 sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+	return _mm256_xor_ps(result, sign);
+} // end sinAVX2 method
+
+PHYSICS_AVX2_TARGET static inline __m256 wrapDegreesAVX2(__m256 r)
+{
+	__m256 turns = _mm256_floor_ps(_mm256_mul_ps(r, _mm256_set1_ps(1.0f / 360.0f)));
+	return _mm256_fnmadd_ps(_mm256_set1_ps(360.0f), turns, r);
+} // end wrapDegreesAVX2 method
+
+PHYSICS_AVX2_TARGET static void driveAVX2(MoverArrays& m, size_t begin, size_t end, float time, float deltaTime)
+{
+	size_t i = begin;
+	__m256 t = _mm256_set1_ps(time);
+	__m256 dt = _mm256_set1_ps(deltaTime);
+	for (; i + 8 <= end; i += 8)
+	{
+		__m256 angle = _mm256_mul_ps(t, _mm256_loadu_ps(&m.speed[i]));
+		__m256 offset = _mm256_loadu_ps(&m.offset[i]);
+		__m256 amplitude = _mm256_loadu_ps(&m.amplitude[i]);
+		__m256 x = _mm256_fmadd_ps(sinAVX2(_mm256_add_ps(angle, _mm256_loadu_ps(&m.phaseX[i]))), amplitude, offset);
+		__m256 y = _mm256_fmadd_ps(sinAVX2(_mm256_add_ps(angle, _mm256_loadu_ps(&m.phaseY[i]))), amplitude, offset);
+		__m256 z = _mm256_fmadd_ps(sinAVX2(_mm256_add_ps(angle, _mm256_loadu_ps(&m.phaseZ[i]))), amplitude, offset);
+		_mm256_storeu_ps(&m.targetX[i], x);
+		_mm256_storeu_ps(&m.targetY[i], y);
+		_mm256_storeu_ps(&m.targetZ[i], z);
+		_mm256_storeu_ps(&m.rotX[i], wrapDegreesAVX2(_mm256_fmadd_ps(_mm256_loadu_ps(&m.rotSpeedX[i]), dt, _mm256_loadu_ps(&m.rotX[i]))));
+		_mm256_storeu_ps(&m.rotY[i], wrapDegreesAVX2(_mm256_fmadd_ps(_mm256_loadu_ps(&m.rotSpeedY[i]), dt, _mm256_loadu_ps(&m.rotY[i]))));
+		_mm256_storeu_ps(&m.rotZ[i], wrapDegreesAVX2(_mm256_fmadd_ps(_mm256_loadu_ps(&m.rotSpeedZ[i]), dt, _mm256_loadu_ps(&m.rotZ[i]))));
+	}
+	driveScalar(m, i, end, time, deltaTime);
+} // end driveAVX2 method
+
+PHYSICS_AVX2_TARGET static void broadphaseAVX2(const MoverArrays& m, size_t first, size_t last, bool anyAsleep, MoverPairs& pairs)
+{
+	for (size_t a = first; a < last; a++)
+	{
+		unsigned int i = m.awake[a];
+		unsigned int groupFirst, groupLast;
+		groupRange(m, i, groupFirst, groupLast);
+		__m256 x = _mm256_set1_ps(m.posX[i]), y = _mm256_set1_ps(m.posY[i]), z = _mm256_set1_ps(m.posZ[i]);
+		__m256 sweep = _mm256_set1_ps(m.sweepRadius[i]);
+		unsigned int j = anyAsleep ? groupFirst : i + 1;
+		for (; j + 8 <= groupLast; j += 8)
+		{
+			__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&m.posX[j]), x);
+			__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&m.posY[j]), y);
+			__m256 dz = _mm256_sub_ps(_mm256_loadu_ps(&m.posZ[j]), z);
+			__m256 distanceSquared = _mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)));
+			__m256 reach = _mm256_add_ps(_mm256_loadu_ps(&m.sweepRadius[j]), sweep);
+			int hits = _mm256_movemask_ps(_mm256_cmp_ps(distanceSquared, _mm256_mul_ps(reach, reach), _CMP_LT_OQ));
+			for (; hits != 0; hits &= hits - 1)
+			{
+				addCandidate(m, pairs, i, j + lowestLane(hits));
+			}
+		}
+		for (; j < groupLast; j++)
+		{
+			if (sweptOverlap(m, i, j))
+			{
+				addCandidate(m, pairs, i, j);
+			}
+		}
+	}
+} // end broadphaseAVX2 method
+
+PHYSICS_AVX2_TARGET static void integrateBoundedAVX2(MoverArrays& m, size_t begin, size_t end, float duration)
+{
+	size_t i = begin;
+	__m256 dt = _mm256_set1_ps(duration);
+	__m256 zero = _mm256_setzero_ps();
+	__m256 bounce = _mm256_set1_ps(1.0f + m.settings.wallRestitution);
+	for (; i + 8 <= end; i += 8)
+	{
+		__m256 vx = _mm256_loadu_ps(&m.velX[i]), vy = _mm256_loadu_ps(&m.velY[i]), vz = _mm256_loadu_ps(&m.velZ[i]);
+		__m256 px = _mm256_fmadd_ps(vx, dt, _mm256_loadu_ps(&m.posX[i]));
+		__m256 py = _mm256_fmadd_ps(vy, dt, _mm256_loadu_ps(&m.posY[i]));
+		__m256 pz = _mm256_fmadd_ps(vz, dt, _mm256_loadu_ps(&m.posZ[i]));
+		__m256 r = _mm256_loadu_ps(&m.radius[i]);
+		for (const BoundPlane& plane : m.bounds.planes)
+		{
+			__m256 nx = _mm256_set1_ps(plane.normal.x), ny = _mm256_set1_ps(plane.normal.y), nz = _mm256_set1_ps(plane.normal.z);
+			__m256 distance = _mm256_fmadd_ps(nz, pz, _mm256_fmadd_ps(ny, py, _mm256_mul_ps(nx, px)));
+			__m256 penetration = _mm256_max_ps(_mm256_sub_ps(_mm256_add_ps(_mm256_set1_ps(plane.offset), r), distance), zero);
+			px = _mm256_fmadd_ps(nx, penetration, px);
+			py = _mm256_fmadd_ps(ny, penetration, py);
+			pz = _mm256_fmadd_ps(nz, penetration, pz);
+			__m256 intoPlane = _mm256_fmadd_ps(nz, vz, _mm256_fmadd_ps(ny, vy, _mm256_mul_ps(nx, vx)));
+			__m256 hit = _mm256_and_ps(_mm256_cmp_ps(penetration, zero, _CMP_GT_OQ), _mm256_cmp_ps(intoPlane, zero, _CMP_LT_OQ));
+			__m256 change = _mm256_and_ps(hit, _mm256_mul_ps(intoPlane, bounce));
+			vx = _mm256_fnmadd_ps(nx, change, vx);
+			vy = _mm256_fnmadd_ps(ny, change, vy);
+			vz = _mm256_fnmadd_ps(nz, change, vz);
+		}
+		_mm256_storeu_ps(&m.posX[i], px); _mm256_storeu_ps(&m.posY[i], py); _mm256_storeu_ps(&m.posZ[i], pz);
+		_mm256_storeu_ps(&m.velX[i], vx); _mm256_storeu_ps(&m.velY[i], vy); _mm256_storeu_ps(&m.velZ[i], vz);
+	}
+	integrateBoundedScalar(m, i, end, duration);
+} // end integrateBoundedAVX2 method
+#endif
+
+/*
+***********************************************
+*		Runtime Dispatch
+***********************************************
+*/
+/* widest instruction set supported by both the CPU and the OS */
+PhysicsKernel detectPhysicsKernel()
+{
+#ifdef PHYSICS_X86
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool fma = (info[2] & (1 << 12)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avxState = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+	__cpuidex(info, 7, 0);
+	bool avx2 = (info[1] & (1 << 5)) != 0;
+	if (avx2 && fma && avxState)
+	{
+		return PHYSICS_AVX2;
+	}
+	return sse2 ? PHYSICS_SSE2 : PHYSICS_SCALAR;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+	{
+		return PHYSICS_AVX2;
+	}
+	return __builtin_cpu_supports("sse2") ? PHYSICS_SSE2 : PHYSICS_SCALAR;
+#endif
+#else
+	return PHYSICS_SCALAR;
+#endif
+} // end detectPhysicsKernel method
+
+static PhysicsKernel supportedKernel = detectPhysicsKernel();
+static PhysicsKernel activeKernel = supportedKernel;
+
+void setPhysicsKernel(PhysicsKernel kernel)
+{
+	activeKernel = kernel <= supportedKernel ? kernel : supportedKernel;
+} // end setPhysicsKernel method
+
+PhysicsKernel physicsKernel()
+{
+	return activeKernel;
+} // end physicsKernel method
+
+const char* physicsKernelName(PhysicsKernel kernel)
+{
+	switch (kernel)
+	{
+	case PHYSICS_AVX2:
+		return "AVX2";
+	case PHYSICS_SSE2:
+		return "SSE2";
+	default:
+		return "scalar";
+	}
+} // end physicsKernelName method
+
+/* waveform targets and rotation of movers [begin, end) with the active kernel */
+static void driveRange(MoverArrays& movers, size_t begin, size_t end, float time, float deltaTime)
+{
+	switch (activeKernel)
+	{
+#ifdef PHYSICS_X86
+	case PHYSICS_AVX2:
+		driveAVX2(movers, begin, end, time, deltaTime);
+		break;
+	case PHYSICS_SSE2:
+		driveSSE2(movers, begin, end, time, deltaTime);
+		break;
+#endif
+	default:
+		driveScalar(movers, begin, end, time, deltaTime);
+		break;
+	}
+} // end driveRange method
+
+void driveMovers(MoverArrays& movers, float time, float deltaTime)
+{
+	jobs.parallelFor(movers.size(), moverGrain, [&](size_t begin, size_t end)
+	{
+		driveRange(movers, begin, end, time, deltaTime);
+	});
+} // end driveMovers method
+
+/* last stretch of the tick for every mover, with the world bounds, using the active kernel */
+static void integrateBounded(MoverArrays& movers, float duration)
+{
+	jobs.parallelFor(movers.size(), moverGrain, [&](size_t begin, size_t end)
+	{
+		switch (activeKernel)
+		{
+#ifdef PHYSICS_X86
+		case PHYSICS_AVX2:
+			integrateBoundedAVX2(movers, begin, end, duration);
+			break;
+		case PHYSICS_SSE2:
+			integrateBoundedSSE2(movers, begin, end, duration);
+			break;
+#endif
+		default:
+			integrateBoundedScalar(movers, begin, end, duration);
+			break;
+		}
+	});
+} // end integrateBounded method
+
+/* candidate pairs of awake movers [first, last) with the active kernel */
+static void broadphaseRange(const MoverArrays& movers, size_t first, size_t last, bool anyAsleep, MoverPairs& pairs)
+{
+	switch (activeKernel)
+	{
+#ifdef PHYSICS_X86
+	case PHYSICS_AVX2:
+		broadphaseAVX2(movers, first, last, anyAsleep, pairs);
+		break;
+	case PHYSICS_SSE2:
+		broadphaseSSE2(movers, first, last, anyAsleep, pairs);
+		break;
+#endif
+	default:
+		broadphaseScalar(movers, first, last, anyAsleep, pairs);
+		break;
+	}
+} // end broadphaseRange method
+
+/* every awake mover against every other of its group, in chunks of awake movers that each fill their own pair list */
+static void findCandidatePairs(MoverArrays& movers, bool anyAsleep)
+{
+	movers.pairs.clear();
+	size_t awakeCount = movers.awake.size();
+	size_t chunkCount = (awakeCount + broadphaseChunk - 1) / broadphaseChunk;
+	if (chunkCount <= 1 || jobs.workerCount() == 0)
+	{
+		broadphaseRange(movers, 0, awakeCount, anyAsleep, movers.pairs);
+		return;
+	}
+	movers.chunkPairs.resize(chunkCount);
+	jobs.parallelFor(chunkCount, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t chunk = begin; chunk < end; chunk++)
+		{
+			movers.chunkPairs[chunk].clear();
+			broadphaseRange(movers, chunk * broadphaseChunk, std::min((chunk + 1) * broadphaseChunk, awakeCount),
+				anyAsleep, movers.chunkPairs[chunk]);
+		}
+	});
+	// joined in chunk order, so the pairs come out the same as from a single pass
+	for (size_t chunk = 0; chunk < chunkCount; chunk++)
+	{
+		movers.pairs.insert(movers.pairs.end(), movers.chunkPairs[chunk].begin(), movers.chunkPairs[chunk].end());
+	}
+} // end findCandidatePairs method
+
+/*
+***********************************************
+*		Fixed Tick
+***********************************************
+*/
+/* narrowphase state of a candidate pair within one tick */
+enum PairState
+{
+	PAIR_SPHERES,		// swept with the bounding spheres
+	PAIR_NEAR,			// bounding spheres met but the meshes did not, swept with the core spheres
+	PAIR_CONTACT		// touching this tick
+};
+
+static inline bool meshPair(const MoverArrays& m, unsigned int i, unsigned int j)
+{
+	return m.shape[i] != NULL && m.shape[j] != NULL;
+} // end meshPair method
+
+/* fraction of the remaining tick at which the pair's spheres of the given reach first touch, or -1 if they do not */
+static float timeOfImpact(const MoverArrays& m, unsigned int i, unsigned int j, float reach, float duration)
+{
+	if (reach <= 0.0f)
+	{
+		return -1.0f;
+	}
+	vec3 separation = m.position(j) - m.position(i);
+	vec3 travel = (m.velocity(j) - m.velocity(i)) * duration;
+	float b = dot(separation, travel);
+	if (b >= 0.0f)
+	{
+		return -1.0f;	// not approaching
+	}
+	float c = dot(separation, separation) - reach * reach;
+	if (c <= 0.0f)
+	{
+		return 0.0f;	// already touching and still closing
+	}
+	float a = dot(travel, travel);
+	float discriminant = b * b - a * c;
+	if (discriminant < 0.0f)
+	{
+		return -1.0f;
+	}
+	float t = (-b - sqrt(discriminant)) / a;
+	return t <= 1.0f ? t : -1.0f;
+} // end timeOfImpact method
+
+static void wake(MoverArrays& m, unsigned int i)
+{
+	if (m.asleep[i])
+	{
+		m.asleep[i] = 0;
+		m.sleepTimer[i] = 0.0f;
+		m.awake.push_back(i);
+	}
+} // end wake method
+
+/* impact time of candidate pair p within the remaining tick, swept with the spheres its state calls for */
+static float pairImpact(const MoverArrays& m, size_t p, float remaining)
+{
+	unsigned int i = m.pairs[p].first, j = m.pairs[p].second;
+	if (m.pairState[p] == PAIR_CONTACT && meshPair(m, i, j))
+	{
+		return -1.0f;	// resolved, any remaining overlap is handled at the end of the tick
+	}
+	float reach = m.pairState[p] == PAIR_NEAR ? m.coreRadius[i] + m.coreRadius[j] : m.radius[i] + m.radius[j];
+	return timeOfImpact(m, i, j, reach, remaining);
+} // end pairImpact method
+
+/* unit vector from mover i to mover j */
+static vec3 centreNormal(const MoverArrays& m, unsigned int i, unsigned int j)
+{
+	vec3 normal = m.position(j) - m.position(i);
+	float distance = length(normal);
+	return distance > 0.0f ? normal / distance : vec3(0.0f, 0.0f, 1.0f);
+} // end centreNormal method
+
+/* mesh contact normal at the current pose, false when the meshes do not touch */
+static bool meshContact(const MoverArrays& m, unsigned int i, unsigned int j, vec3& normal)
+{
+	return meshesOverlap(*m.shape[i], m.transform(i), *m.shape[j], m.transform(j), normal);
+} // end meshContact method
+
+/* mass-weighted impulse along the contact normal (i towards j), restitution applied to the closing speed */
+static void applyImpulse(MoverArrays& m, unsigned int i, unsigned int j, const vec3& normal)
+{
+	float closingSpeed = dot(m.velocity(j) - m.velocity(i), normal);
+	float totalInverseMass = m.inverseMass[i] + m.inverseMass[j];
+	if (closingSpeed >= 0.0f || totalInverseMass <= 0.0f)
+	{
+		return;
+	}
+	float impulse = -(1.0f + m.settings.restitution) * closingSpeed / totalInverseMass;
+	vec3 velocityI = m.velocity(i) - normal * (impulse * m.inverseMass[i]);
+	vec3 velocityJ = m.velocity(j) + normal * (impulse * m.inverseMass[j]);
+	m.velX[i] = velocityI.x; m.velY[i] = velocityI.y; m.velZ[i] = velocityI.z;
+	m.velX[j] = velocityJ.x; m.velY[j] = velocityJ.y; m.velZ[j] = velocityJ.z;
+	wake(m, i);
+	wake(m, j);
+} // end applyImpulse method
+
+/* after an impulse: mover i may now be faster than its sweep assumed, or newly awake, so sweep it again over the
+   rest of the tick against every mover of its group, sleepers included, and time the pairs that were not listed */
+static void sweepAfterImpulse(MoverArrays& m, unsigned int i, float remaining)
+{
+	m.sweepRadius[i] = m.radius[i] + length(m.velocity(i)) * remaining + m.settings.contactSlop;
+	unsigned int groupFirst, groupLast;
+	groupRange(m, i, groupFirst, groupLast);
+	size_t listed = m.pairs.size();
+	for (unsigned int j = groupFirst; j < groupLast; j++)
+	{
+		if (j == i || !m.active[j] || !sweptOverlap(m, i, j))
+		{
+			continue;
+		}
+		bool known = false;
+		for (size_t p = 0; p < listed && !known; p++)
+		{
+			known = (m.pairs[p].first == i && m.pairs[p].second == j) || (m.pairs[p].first == j && m.pairs[p].second == i);
+		}
+		if (!known)
+		{
+			m.pairs.push_back(make_pair(i, j));
+			m.pairState.push_back(PAIR_SPHERES);
+			m.pairImpact.push_back(pairImpact(m, m.pairs.size() - 1, remaining));
+		}
+	}
+} // end sweepAfterImpulse method
+
+static void advanceAwake(MoverArrays& m, float duration)
+{
+	for (unsigned int i : m.awake)
+	{
+		m.posX[i] += m.velX[i] * duration;
+		m.posY[i] += m.velY[i] * duration;
+		m.posZ[i] += m.velZ[i] * duration;
+	}
+} // end advanceAwake method
+
+/* move a pair apart along normal by their mass ratio, sleeping movers act as static */
+static void pushApart(MoverArrays& m, unsigned int i, unsigned int j, const vec3& normal, float distance)
+{
+	float inverseMassI = m.asleep[i] ? 0.0f : m.inverseMass[i];
+	float inverseMassJ = m.asleep[j] ? 0.0f : m.inverseMass[j];
+	if (distance <= 0.0f || inverseMassI + inverseMassJ <= 0.0f)
+	{
+		return;
+	}
+	vec3 correction = normal * (distance / (inverseMassI + inverseMassJ));
+	vec3 positionI = m.position(i) - correction * inverseMassI;
+	vec3 positionJ = m.position(j) + correction * inverseMassJ;
+	m.posX[i] = positionI.x; m.posY[i] = positionI.y; m.posZ[i] = positionI.z;
+	m.posX[j] = positionJ.x; m.posY[j] = positionJ.y; m.posZ[j] = positionJ.z;
+} // end pushApart method
+
+/* end of tick: sphere pairs are separated by their overlap, mesh pairs by a small step while their triangles still intersect */
+static void separateOverlaps(MoverArrays& m)
+{
+	for (size_t p = 0; p < m.pairs.size(); p++)
+	{
+		unsigned int i = m.pairs[p].first, j = m.pairs[p].second;
+		if (meshPair(m, i, j))
+		{
+			vec3 toJ = m.position(j) - m.position(i);
+			float reach = m.radius[i] + m.radius[j];
+			vec3 normal;
+			if (dot(toJ, toJ) < reach * reach && meshContact(m, i, j, normal))
+			{
+				applyImpulse(m, i, j, normal);
+				pushApart(m, i, j, normal, m.settings.meshPushDistance);
+				m.pairState[p] = PAIR_CONTACT;
+			}
+			continue;
+		}
+		vec3 normal = m.position(j) - m.position(i);
+		float distance = length(normal);
+		float penetration = m.radius[i] + m.radius[j] - distance - m.settings.contactSlop;
+		if (penetration > 0.0f)
+		{
+			pushApart(m, i, j, distance > 0.0f ? normal / distance : vec3(0.0f, 0.0f, 1.0f), penetration);
+		}
+	}
+} // end separateOverlaps method
+
+static unsigned int findIsland(vector<unsigned int>& island, unsigned int i)
+{
+	while (island[i] != i)
+	{
+		island[i] = island[island[i]];
+		i = island[i];
+	}
+	return i;
+} // end findIsland method
+
+/* movers that touch form an island; an island sleeps only when every member has been slow long enough */
+static void updateSleep(MoverArrays& m, float tick)
+{
+	const PhysicsSettings& settings = m.settings;
+	size_t count = m.size();
+	for (unsigned int i : m.awake)
+	{
+		float speedSquared = dot(m.velocity(i), m.velocity(i));
+		m.sleepTimer[i] = speedSquared < settings.sleepSpeed * settings.sleepSpeed ? m.sleepTimer[i] + tick : 0.0f;
+	}
+
+	m.island.resize(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		m.island[i] = i;
+	}
+	for (size_t p = 0; p < m.pairs.size(); p++)
+	{
+		unsigned int i = m.pairs[p].first, j = m.pairs[p].second;
+		float reach = m.radius[i] + m.radius[j] + settings.contactSlop;
+		vec3 separation = m.position(j) - m.position(i);
+		bool touching = meshPair(m, i, j) ? m.pairState[p] == PAIR_CONTACT : dot(separation, separation) <= reach * reach;
+		if (touching)
+		{
+			m.island[findIsland(m.island, i)] = findIsland(m.island, j);
+		}
+	}
+
+	// an island stays awake while any member is still moving
+	m.restless.assign(count, 0);
+	for (unsigned int i : m.awake)
+	{
+		if (m.sleepTimer[i] < settings.sleepTime)
+		{
+			m.restless[findIsland(m.island, i)] = 1;
+		}
+	}
+	for (unsigned int i = 0; i < count; i++)
+	{
+		bool islandRestless = m.restless[findIsland(m.island, i)] != 0;
+		if (islandRestless && m.asleep[i])
+		{
+			wake(m, i);
+		}
+		else if (!islandRestless && !m.asleep[i])
+		{
+			m.asleep[i] = 1;
+			m.velX[i] = m.velY[i] = m.velZ[i] = 0.0f;
+		}
+	}
+} // end updateSleep method
+
+void collectContacts(const MoverArrays& movers, MoverPairs& contacts)
+{
+	contacts.clear();
+	for (size_t p = 0; p < movers.pairs.size(); p++)
+	{
+		if (movers.pairState[p] == PAIR_CONTACT)
+		{
+			contacts.push_back(movers.pairs[p]);
+		}
+	}
+} // end collectContacts method
+
+/* one fixed tick of the whole physics stage */
+void stepPhysics(MoverArrays& m, float time, float tick, bool driven)
+{
+	const PhysicsSettings& settings = m.settings;
+	size_t count = m.size();
+
+	// waveform targets, sleeping movers wake once their target has moved away
+	if (driven)
+	{
+		randomizeMotion(m);
+		driveMovers(m, time, tick);
+	}
+	m.awake.clear();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (m.asleep[i] && driven && m.active[i])
+		{
+			vec3 toTarget = vec3(m.targetX[i], m.targetY[i], m.targetZ[i]) - m.position(i);
+			if (dot(toTarget, toTarget) > settings.wakeDistance * settings.wakeDistance)
+			{
+				m.asleep[i] = 0;
+				m.sleepTimer[i] = 0.0f;
+			}
+		}
+		if (!m.asleep[i])
+		{
+			m.awake.push_back(i);
+		}
+	}
+	bool anyAsleep = m.awake.size() < count;
+
+	// steer towards the target (or coast to rest), exponential so any tick length is stable
+	float follow = 1.0f - exp(-tick / settings.followTime);
+	float damping = exp(-tick / settings.restDamping);
+	float reachIn = std::max(settings.followTime, tick);
+	for (unsigned int i : m.awake)
+	{
+		vec3 velocity = m.velocity(i);
+		if (driven)
+		{
+			vec3 desired = (vec3(m.targetX[i], m.targetY[i], m.targetZ[i]) - m.position(i)) / reachIn;
+			velocity += (desired - velocity) * follow;
+		}
+		else
+		{
+			velocity *= damping;
+		}
+		m.velX[i] = velocity.x; m.velY[i] = velocity.y; m.velZ[i] = velocity.z;
+	}
+
+	// broadphase - spheres that bound each mover's whole path this tick
+	m.sweepRadius.resize(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		m.sweepRadius[i] = m.radius[i] + (m.asleep[i] ? 0.0f : length(m.velocity(i)) * tick) + settings.contactSlop;
+	}
+	findCandidatePairs(m, anyAsleep);
+	m.pairState.assign(m.pairs.size(), PAIR_SPHERES);
+
+	// narrowphase - advance to each earliest impact, resolve it, continue with the rest of the tick;
+	// mesh pairs whose bounding spheres meet without their triangles touching fall back to the core
+	// spheres, which can only touch once the meshes already intersect, so fast movers still cannot tunnel;
+	// both movers of an impact are swept again with their new velocities for whatever is left of the tick
+	float remaining = tick;
+	m.pairImpact.resize(m.pairs.size());
+	jobs.parallelFor(m.pairs.size(), pairGrain, [&](size_t begin, size_t end)
+	{
+		for (size_t p = begin; p < end; p++)
+		{
+			m.pairImpact[p] = pairImpact(m, p, remaining);
+		}
+	});
+	// the budget is per world, a store holding several groups gets one for each
+	int impactIterations = settings.maxImpactIterations * static_cast<int>(m.groupCount());
+	for (int iteration = 0; remaining > 0.0f; iteration++)
+	{
+		float earliest = 2.0f;
+		size_t hit = 0;
+		for (size_t p = 0; p < m.pairs.size(); p++)
+		{
+			if (m.pairImpact[p] >= 0.0f && m.pairImpact[p] < earliest)
+			{
+				earliest = m.pairImpact[p];
+				hit = p;
+			}
+		}
+		if (earliest > 1.0f)
+		{
+			break;
+		}
+		advanceAwake(m, remaining * earliest);
+		if (iteration == impactIterations)
+		{
+			// out of budget: stop at the impact rather than carry the movers through it, the rest of the tick is dropped
+			remaining = 0.0f;
+			break;
+		}
+		remaining *= 1.0f - earliest;
+
+		unsigned int i = m.pairs[hit].first, j = m.pairs[hit].second;
+		vec3 normal = centreNormal(m, i, j);
+		// core spheres only meet deep inside the meshes, where the centre line is the better normal
+		if (meshPair(m, i, j) && m.pairState[hit] == PAIR_SPHERES)
+		{
+			if (meshContact(m, i, j, normal))
+			{
+				applyImpulse(m, i, j, normal);
+				m.pairState[hit] = PAIR_CONTACT;
+			}
+			else
+			{
+				m.pairState[hit] = PAIR_NEAR;
+			}
+		}
+		else
+		{
+			applyImpulse(m, i, j, normal);
+			m.pairState[hit] = PAIR_CONTACT;
+		}
+
+		// linear motion is unchanged for every other pair, so their impacts only shift in time
+		for (size_t p = 0; p < m.pairs.size(); p++)
+		{
+			unsigned int a = m.pairs[p].first, b = m.pairs[p].second;
+			if (p == hit || a == i || a == j || b == i || b == j)
+			{
+				m.pairImpact[p] = pairImpact(m, p, remaining);
+			}
+			else if (m.pairImpact[p] >= 0.0f)
+			{
+				m.pairImpact[p] = (m.pairImpact[p] - earliest) / (1.0f - earliest);
+			}
+		}
+		if (m.pairState[hit] == PAIR_CONTACT)
+		{
+			sweepAfterImpulse(m, i, remaining);
+			sweepAfterImpulse(m, j, remaining);
+		}
+	}
+	// sleeping movers have no velocity, so integrating everyone keeps the SIMD pass branch-free
+	integrateBounded(m, remaining);
+	separateOverlaps(m);
+
+	updateSleep(m, tick);
+} // end stepPhysics method
+
+/*
+***********************************************
+*		Mover Commands
+***********************************************
+*/
+void MoverCommands::reserve(size_t capacity)
+{
+	lock_guard<mutex> guard(lock);
+	queued.reserve(capacity);
+	applying.reserve(capacity);
+} // end reserve method
+
+void MoverCommands::spawn(unsigned int slot, unsigned int moverGeneration, const MoverSpawn& data)
+{
+	lock_guard<mutex> guard(lock);
+	queued.push_back({ slot, moverGeneration, true, data });
+} // end spawn method
+
+void MoverCommands::despawn(unsigned int slot)
+{
+	lock_guard<mutex> guard(lock);
+	queued.push_back({ slot, 0, false, MoverSpawn() });
+} // end despawn method
+
+bool MoverCommands::pending()
+{
+	lock_guard<mutex> guard(lock);
+	return !queued.empty();
+} // end pending method
+
+bool MoverCommands::apply(MoverArrays& movers)
+{
+	{
+		lock_guard<mutex> guard(lock);
+		if (queued.empty())
+		{
+			return false;
+		}
+		queued.swap(applying);
+	}
+	for (const Command& command : applying)
+	{
+		if (command.spawn)
+		{
+			movers.activate(command.slot, command.data, command.generation);
+		}
+		else
+		{
+			movers.deactivate(command.slot);
+		}
+	}
+	applying.clear();
+	return true;
+} // end apply method
@@ -0,0 +1,217 @@
+#ifndef PHYSICS_HPP
+#define PHYSICS_HPP
+
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <random>
+
+#include <glm/gtc/quaternion.hpp>
+
+class MeshBVH;
+
+// candidate pair of mover indices
+typedef std::pair<unsigned int, unsigned int> MoverPair;
+typedef std::vector<MoverPair> MoverPairs;
+
+/* MotionParams - how one mover picks its random motion every tick */
+struct MotionParams
+{
+	float speedDivisor;			// speed = 1 + random % 100 / speedDivisor
+	int amplitudeModulo;		// amplitude = 1 + random % amplitudeModulo / amplitudeDivisor
+	float amplitudeDivisor;
+	glm::vec3 rotationDivisor;	// rotation speed = random % 360 / rotationDivisor degrees per second, per axis
+	glm::vec3 phase;			// 0 follows sin(), pi/2 follows cos(), per axis
+};
+
+/* BoundPlane - half-space every mover's sphere has to stay in: dot(normal, position) >= offset + radius */
+struct BoundPlane
+{
+	glm::vec3 normal;
+	float offset;
+};
+
+/* WorldBounds - planes that close off the play area (floor, walls, ceiling) */
+class WorldBounds
+{
+public:
+	void addPlane(const glm::vec3& normal, float offset);
+	// plane through a flat polygon (e.g. the floor quad), facing the side that contains inside
+	void addSurface(const std::vector<glm::vec3>& polygon, const glm::vec3& inside);
+
+	std::vector<BoundPlane> planes;
+};
+
+/* PhysicsSettings - tuning shared by every mover */
+struct PhysicsSettings
+{
+	float followTime = 0.1f;		// seconds to close the gap to the waveform target
+	float restDamping = 0.5f;		// seconds for velocity to fall to 1/e when nothing drives the movers
+	float restitution = 0.6f;		// bounciness of mover-mover contacts
+	float contactSlop = 0.05f;		// distance still counted as touching (islands) and allowed as overlap
+	float sleepSpeed = 0.05f;		// below this speed a mover starts counting towards sleep
+	float sleepTime = 0.5f;			// seconds an island must stay slow before it sleeps
+	float wakeDistance = 0.1f;		// a sleeping mover wakes when its target moves further than this
+	int maxImpactIterations = 32;	// time-of-impact events resolved per tick, the tick stops short at the next one
+	float meshPushDistance = 0.05f;	// separation applied per tick to meshes that still overlap
+	float wallRestitution = 0.5f;	// bounciness of the floor, walls and ceiling
+};
+
+/* MoverSpawn - everything needed to bring a pooled mover slot back to life */
+struct MoverSpawn
+{
+	glm::vec3 position;
+	glm::vec3 velocity;
+	float radius;					// sphere radius, replaced by the shape's bounds when it has one
+	float mass;
+	MotionParams motion;
+	const MeshBVH* shape;			// null for a sphere
+	glm::quat orientation;
+	glm::vec3 spinAxes;
+	glm::quat bakedRotation;
+	unsigned int tag;				// the caller's id for what the mover is
+};
+
+/* MoverArrays - structure-of-arrays state of every moving object, one entry per mover in each array */
+class MoverArrays
+{
+public:
+	// append a mover, returns its index
+	size_t add(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& rotation,
+		float radius, float mass, const MotionParams& motion);
+	// append count movers at the origin with default state and return the index of the first, for callers
+	// that fill whole columns at once (a mapped scene file); motion and phase still have to be set per mover
+	size_t append(size_t count);
+	// collide mover i with its mesh instead of a sphere; orientation is the fixed model rotation,
+	// spinAxes scales the rotation angles (0 disables an axis, -1 spins the other way) and bakedRotation
+	// is the part of orientation the loader already applied to the mesh's vertices
+	void setShape(size_t i, const MeshBVH* bvh, const glm::quat& orientation, const glm::vec3& spinAxes,
+		const glm::quat& bakedRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+	// reuse slot i for a new mover tagged with generation; slots are only ever recycled, never added or
+	// removed, so the arrays stay put while the stepping thread and snapshots index them
+	void activate(size_t i, const MoverSpawn& spawn, unsigned int moverGeneration);
+	// free slot i: it stays asleep, is never paired and never woken until activated again
+	void deactivate(size_t i);
+	// movers added from now on form a new group; movers only ever pair within their group, so one store can
+	// hold several independent worlds side by side and step them all with the same kernel passes
+	void beginGroup();
+	size_t groupCount() const { return groupStart.empty() ? 1 : groupStart.size(); }
+	size_t size() const { return count; }
+
+	glm::vec3 position(size_t i) const { return glm::vec3(posX[i], posY[i], posZ[i]); }
+	glm::vec3 velocity(size_t i) const { return glm::vec3(velX[i], velY[i], velZ[i]); }
+	glm::vec3 rotation(size_t i) const { return glm::vec3(rotX[i], rotY[i], rotZ[i]); }
+	// model matrix: translation, fixed orientation, then the spin about x, y and z
+	glm::mat4 transform(size_t i) const { return transform(i, position(i), rotation(i)); }
+	// the same from a snapshot; orientation and spin axes never change after setShape, so the render thread may call this
+	glm::mat4 transform(size_t i, const glm::vec3& position, const glm::vec3& rotation) const;
+	// rotation part of transform() for the (baked) mesh, same threading rules
+	glm::quat worldRotation(size_t i, const glm::vec3& rotation) const;
+	bool isAsleep(size_t i) const { return asleep[i] != 0; }
+
+	// state
+	std::vector<float> posX, posY, posZ;
+	std::vector<float> velX, velY, velZ;
+	std::vector<float> rotX, rotY, rotZ;
+	std::vector<float> rotSpeedX, rotSpeedY, rotSpeedZ;
+	std::vector<float> radius;			// bounding sphere around the mover's origin
+	std::vector<float> coreRadius;		// sphere around the origin that is always inside the shape
+	std::vector<float> inverseMass;
+	// collision mesh (null for plain spheres) and how it is posed
+	std::vector<const MeshBVH*> shape;
+	std::vector<glm::quat> orientation;
+	std::vector<glm::quat> unbake;		// inverse of the rotation baked into the mesh, the spin happens before it
+	std::vector<glm::vec3> spinAxes;
+	// waveform target of the current tick
+	std::vector<float> targetX, targetY, targetZ;
+	// motion of the current tick, picked by randomizeMotion()
+	std::vector<float> speed, amplitude, offset;
+	// waveform phase per axis
+	std::vector<float> phaseX, phaseY, phaseZ;
+	// random ranges
+	std::vector<MotionParams> motion;
+	// what randomizeMotion() rolls with, one per store so stores can step on different threads
+	std::minstd_rand random;
+	// sleeping
+	std::vector<unsigned char> asleep;
+	std::vector<float> sleepTimer;
+	// pooling: free slots are inactive, generation tells the owners of a reused slot apart
+	std::vector<unsigned char> active;
+	std::vector<unsigned int> generation;
+	// the caller's id for each mover (its index unless a spawn says otherwise), carried into snapshots and traces
+	std::vector<unsigned int> tag;
+	// group of each mover and the first mover of each group (empty while every mover is in one group)
+	std::vector<unsigned int> group;
+	std::vector<size_t> groupStart;
+
+	PhysicsSettings settings;
+	WorldBounds bounds;
+
+	// per tick scratch, kept to avoid reallocating
+	std::vector<unsigned int> awake;
+	std::vector<float> sweepRadius;
+	MoverPairs pairs;
+	std::vector<MoverPairs> chunkPairs;	// one list per broadphase job
+	std::vector<unsigned char> pairState;
+	std::vector<float> pairImpact;
+	std::vector<unsigned int> island;
+	std::vector<unsigned char> restless;
+
+private:
+	size_t count = 0;
+};
+
+/* MoverCommands - spawns and despawns queued by one thread for the thread that steps the movers,
+   applied between ticks so no step ever sees a slot change under it */
+class MoverCommands
+{
+public:
+	// size both lists once; queuing stays allocation free while a tick's worth fits
+	void reserve(size_t capacity);
+	void spawn(unsigned int slot, unsigned int generation, const MoverSpawn& spawn);
+	void despawn(unsigned int slot);
+	// true while commands wait for the stepping thread
+	bool pending();
+	// stepping thread: apply everything queued so far in order, false if nothing was queued
+	bool apply(MoverArrays& movers);
+
+private:
+	struct Command
+	{
+		unsigned int slot;
+		unsigned int generation;
+		bool spawn;
+		MoverSpawn data;
+	};
+	std::mutex lock;
+	std::vector<Command> queued;
+	std::vector<Command> applying;	// swapped with queued, so the lock is held only for the swap
+};
+
+/* instruction set used by the physics kernels */
+enum PhysicsKernel
+{
+	PHYSICS_SCALAR,
+	PHYSICS_SSE2,
+	PHYSICS_AVX2
+};
+
+// best kernel this CPU supports
+PhysicsKernel detectPhysicsKernel();
+// override the kernel chosen at startup (clamped to what the CPU supports)
+void setPhysicsKernel(PhysicsKernel kernel);
+PhysicsKernel physicsKernel();
+const char* physicsKernelName(PhysicsKernel kernel);
+
+// roll this tick's random speed, amplitude, offset and rotation speed of every mover
+void randomizeMotion(MoverArrays& movers);
+// evaluate every mover's waveform target at time and spin it by deltaTime
+void driveMovers(MoverArrays& movers, float time, float deltaTime);
+// pairs that touched during the last stepPhysics (an impulse or an overlap push between them)
+void collectContacts(const MoverArrays& movers, MoverPairs& contacts);
+// one fixed physics tick: steer towards the targets when driven (otherwise coast to rest),
+// sweep the movers with continuous collision detection, apply impulses, bounce them off the world
+// bounds and put resting islands to sleep
+void stepPhysics(MoverArrays& movers, float time, float tick, bool driven);
+
+#endif
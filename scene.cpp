@@ -0,0 +1,733 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with
+* Custom Classes, Mulithreading, & OpenGL
+*
+* Description:
+* Scene description files. The text form is written by hand, one item per
+* line:
+*
+*	texture <name> <file.DDS>
+*	mesh <name> <file.obj> [collide] [<degrees> <axis x y z>]...
+*	motion <name> <speed divisor> <amplitude modulo> <amplitude divisor> <rotation divisor x y z> <phase x y z>
+*	floor <width> <height> <texture>
+*	background <width> <height> <texture>
+*	bounds <min x> <max x> <max y> <max z>
+*	light <x y z> <radius> <r g b> <power>
+*	mover <mesh> <texture> <motion> <x y z> <velocity x y z> <radius> <mass> <spin x y z> [candle] [<degrees> <axis x y z>]...
+*	static <mesh> <texture> <x y z> [<degrees> <axis x y z>]...
+*
+* Rotations are applied left to right and give the whole model rotation,
+* including a mesh's baked rotation. The compiled form holds the same data
+* behind a fixed header: the entities are stored column by column, so a
+* mapped file is read in place and copied column-wise into MoverArrays.
+* Columns are in the machine's byte order, it is a local cache of the text.
+*
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <random>
+#include <algorithm>
+
+// include GLEW
+#include <GL/glew.h>
+
+// include GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+using namespace glm;
+using namespace std;
+
+#include "scene.hpp"
+#include "meshbvh.hpp"
+#include "jobsystem.hpp"
+
+// movers set up per job when they are added to the physics store
+const size_t moverGrain = 4096;
+
+/*
+***********************************************
+*		Compiled Form
+***********************************************
+*/
+const char sceneMagic[8] = { 'S', 'C', 'E', 'N', 'E', 'B', 'I', 'N' };
+const uint32_t sceneVersion = 1;
+
+/* SceneFileHeader - start of a compiled scene, followed by the sections laid out by sceneLayout() */
+struct SceneFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t meshCount, textureCount, motionCount, lightCount;
+	uint32_t moverCount, staticCount;
+	uint32_t stringBytes;
+	SceneQuad floor;
+	SceneQuad background;
+	SceneBounds bounds;
+};
+
+/* SceneFileMesh - one mesh, its path is an offset into the string section */
+struct SceneFileMesh
+{
+	uint32_t path;
+	uint32_t collisionShape;
+	float bakedRotation[4];	// x, y, z, w
+};
+
+// every section is a whole number of 4-byte words, so every column stays aligned in the mapping
+static_assert(sizeof(SceneFileHeader) % 4 == 0, "scene header must keep the sections aligned");
+static_assert(sizeof(MotionParams) % 4 == 0 && sizeof(PointLight) % 4 == 0, "scene sections must stay aligned");
+
+/* SceneFileLayout - byte offset of each section */
+struct SceneFileLayout
+{
+	size_t meshes, textures, motions, lights;
+	size_t moverFloats, moverIndices, staticFloats, staticIndices;
+	size_t strings, end;
+};
+
+static SceneFileLayout sceneLayout(const SceneFileHeader& header)
+{
+	SceneFileLayout layout;
+	size_t offset = sizeof(SceneFileHeader);
+	layout.meshes = offset;
+	offset += header.meshCount * sizeof(SceneFileMesh);
+	layout.textures = offset;
+	offset += header.textureCount * sizeof(uint32_t);
+	layout.motions = offset;
+	offset += header.motionCount * sizeof(MotionParams);
+	layout.lights = offset;
+	offset += header.lightCount * sizeof(PointLight);
+	layout.moverFloats = offset;
+	offset += (size_t)header.moverCount * moverFloatColumns * sizeof(float);
+	layout.moverIndices = offset;
+	offset += (size_t)header.moverCount * moverIndexColumns * sizeof(uint32_t);
+	layout.staticFloats = offset;
+	offset += (size_t)header.staticCount * staticFloatColumns * sizeof(float);
+	layout.staticIndices = offset;
+	offset += (size_t)header.staticCount * staticIndexColumns * sizeof(uint32_t);
+	layout.strings = offset;
+	layout.end = offset + header.stringBytes;
+	return layout;
+} // end sceneLayout method
+
+/*
+***********************************************
+*		Text Form
+***********************************************
+*/
+/* SceneParser - state of one text scene being read */
+struct SceneParser
+{
+	const char* path;
+	int line;
+	map<string, uint32_t> textureNames, meshNames, motionNames;
+
+	bool fail(const char* message) const
+	{
+		fprintf(stderr, "%s:%d: %s\n", path, line, message);
+		return false;
+	}
+};
+
+static bool parseFloat(const string& token, float& value)
+{
+	char* end = nullptr;
+	value = strtof(token.c_str(), &end);
+	return end != token.c_str() && *end == '\0';
+} // end parseFloat method
+
+/* count floats starting at tokens[first] */
+static bool parseFloats(const vector<string>& tokens, size_t first, size_t count, float* values)
+{
+	if (first + count > tokens.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < count; i++)
+	{
+		if (!parseFloat(tokens[first + i], values[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+} // end parseFloats method
+
+/* a motion randomizeMotion() can roll: a modulus of at least 1 and no zero divisor, in either form of the file */
+static bool validMotion(const MotionParams& motion)
+{
+	return motion.amplitudeModulo >= 1 && motion.speedDivisor != 0.0f && motion.amplitudeDivisor != 0.0f &&
+		motion.rotationDivisor.x != 0.0f && motion.rotationDivisor.y != 0.0f && motion.rotationDivisor.z != 0.0f;
+} // end validMotion method
+
+/* the product of the <degrees> <axis x y z> groups from tokens[first] to the end of the line */
+static bool parseRotation(const vector<string>& tokens, size_t first, quat& rotation)
+{
+	rotation = quat(1.0f, 0.0f, 0.0f, 0.0f);
+	if ((tokens.size() - first) % 4 != 0)
+	{
+		return false;
+	}
+	for (size_t i = first; i < tokens.size(); i += 4)
+	{
+		float values[4];
+		if (!parseFloats(tokens, i, 4, values) || (values[1] == 0.0f && values[2] == 0.0f && values[3] == 0.0f))
+		{
+			return false;
+		}
+		rotation = rotation * angleAxis(radians(values[0]), normalize(vec3(values[1], values[2], values[3])));
+	}
+	return true;
+} // end parseRotation method
+
+static bool findName(const map<string, uint32_t>& names, const string& name, uint32_t& index)
+{
+	auto found = names.find(name);
+	if (found == names.end())
+	{
+		return false;
+	}
+	index = found->second;
+	return true;
+} // end findName method
+
+bool Scene::parseText(const char* path, const char* text, size_t size)
+{
+	SceneParser parser;
+	parser.path = path;
+	parser.line = 0;
+	const char* end = text + size;
+	const char* lineStart = text;
+	while (lineStart < end)
+	{
+		const char* lineEnd = (const char*)memchr(lineStart, '\n', end - lineStart);
+		if (lineEnd == nullptr)
+		{
+			lineEnd = end;
+		}
+		parser.line++;
+		string line(lineStart, lineEnd);
+		lineStart = lineEnd + 1;
+		line = line.substr(0, line.find('#'));
+		istringstream words(line);
+		vector<string> tokens;
+		string token;
+		while (words >> token)
+		{
+			tokens.push_back(token);
+		}
+		if (tokens.empty())
+		{
+			continue;
+		}
+
+		const string& keyword = tokens[0];
+		if (keyword == "texture" && tokens.size() == 3)
+		{
+			parser.textureNames[tokens[1]] = (uint32_t)textures.size();
+			textures.push_back(tokens[2]);
+		}
+		else if (keyword == "mesh" && tokens.size() >= 3)
+		{
+			SceneMesh mesh;
+			mesh.path = tokens[2];
+			mesh.collisionShape = tokens.size() > 3 && tokens[3] == "collide";
+			if (!parseRotation(tokens, mesh.collisionShape ? 4 : 3, mesh.bakedRotation))
+			{
+				return parser.fail("expected mesh <name> <file.obj> [collide] [<degrees> <axis x y z>]...");
+			}
+			parser.meshNames[tokens[1]] = (uint32_t)meshes.size();
+			meshes.push_back(mesh);
+		}
+		else if (keyword == "motion" && tokens.size() == 11)
+		{
+			float values[9];
+			if (!parseFloats(tokens, 2, 9, values))
+			{
+				return parser.fail("expected motion <name> followed by 9 numbers");
+			}
+			// whole and within an int, so the conversion is defined; validMotion rejects it below 1
+			if (values[1] != floorf(values[1]) || (double)values[1] < (double)INT_MIN || (double)values[1] > (double)INT_MAX)
+			{
+				return parser.fail("motion amplitude modulo must be a whole number");
+			}
+			MotionParams motion;
+			motion.speedDivisor = values[0];
+			motion.amplitudeModulo = (int)values[1];
+			motion.amplitudeDivisor = values[2];
+			motion.rotationDivisor = vec3(values[3], values[4], values[5]);
+			motion.phase = vec3(values[6], values[7], values[8]);
+			if (!validMotion(motion))
+			{
+				return parser.fail("motion divisors must not be zero and the amplitude modulo must be at least 1");
+			}
+			parser.motionNames[tokens[1]] = (uint32_t)motions.size();
+			motions.push_back(motion);
+		}
+		else if ((keyword == "floor" || keyword == "background") && tokens.size() == 4)
+		{
+			SceneQuad& quad = keyword == "floor" ? floor : background;
+			float values[2];
+			if (!parseFloats(tokens, 1, 2, values) || !findName(parser.textureNames, tokens[3], quad.textureLayer))
+			{
+				return parser.fail("expected <width> <height> <texture>");
+			}
+			quad.width = values[0];
+			quad.height = values[1];
+		}
+		else if (keyword == "bounds" && tokens.size() == 5)
+		{
+			float values[4];
+			if (!parseFloats(tokens, 1, 4, values))
+			{
+				return parser.fail("expected bounds <min x> <max x> <max y> <max z>");
+			}
+			bounds = { values[0], values[1], values[2], values[3] };
+		}
+		else if (keyword == "light" && tokens.size() == 9)
+		{
+			float values[8];
+			if (!parseFloats(tokens, 1, 8, values))
+			{
+				return parser.fail("expected light <x y z> <radius> <r g b> <power>");
+			}
+			lights.push_back({ vec3(values[0], values[1], values[2]), values[3], vec3(values[4], values[5], values[6]), values[7] });
+		}
+		else if (keyword == "mover" && tokens.size() >= 15)
+		{
+			uint32_t mesh, texture, motion;
+			float values[11];
+			if (!findName(parser.meshNames, tokens[1], mesh) || !findName(parser.textureNames, tokens[2], texture) ||
+				!findName(parser.motionNames, tokens[3], motion))
+			{
+				return parser.fail("unknown mesh, texture or motion");
+			}
+			bool candle = tokens.size() > 15 && tokens[15] == "candle";
+			quat rotation;
+			if (!parseFloats(tokens, 4, 11, values) || !parseRotation(tokens, candle ? 16 : 15, rotation))
+			{
+				return parser.fail("expected mover <mesh> <texture> <motion> <x y z> <velocity x y z> <radius> <mass> "
+					"<spin x y z> [candle] [<degrees> <axis x y z>]...");
+			}
+			for (int c = MOVER_X; c <= MOVER_SPIN_Z; c++)
+			{
+				moverFloatStorage[c].push_back(values[c]);
+			}
+			moverFloatStorage[MOVER_ROTATION_X].push_back(rotation.x);
+			moverFloatStorage[MOVER_ROTATION_Y].push_back(rotation.y);
+			moverFloatStorage[MOVER_ROTATION_Z].push_back(rotation.z);
+			moverFloatStorage[MOVER_ROTATION_W].push_back(rotation.w);
+			moverIndexStorage[MOVER_MESH].push_back(mesh);
+			moverIndexStorage[MOVER_TEXTURE].push_back(texture);
+			moverIndexStorage[MOVER_MOTION].push_back(motion);
+			moverIndexStorage[MOVER_FLAGS].push_back(candle ? SCENE_MOVER_CANDLE : 0);
+		}
+		else if (keyword == "static" && tokens.size() >= 6)
+		{
+			uint32_t mesh, texture;
+			float values[3];
+			quat rotation;
+			if (!findName(parser.meshNames, tokens[1], mesh) || !findName(parser.textureNames, tokens[2], texture))
+			{
+				return parser.fail("unknown mesh or texture");
+			}
+			if (!parseFloats(tokens, 3, 3, values) || !parseRotation(tokens, 6, rotation))
+			{
+				return parser.fail("expected static <mesh> <texture> <x y z> [<degrees> <axis x y z>]...");
+			}
+			staticFloatStorage[STATIC_X].push_back(values[0]);
+			staticFloatStorage[STATIC_Y].push_back(values[1]);
+			staticFloatStorage[STATIC_Z].push_back(values[2]);
+			staticFloatStorage[STATIC_ROTATION_X].push_back(rotation.x);
+			staticFloatStorage[STATIC_ROTATION_Y].push_back(rotation.y);
+			staticFloatStorage[STATIC_ROTATION_Z].push_back(rotation.z);
+			staticFloatStorage[STATIC_ROTATION_W].push_back(rotation.w);
+			staticIndexStorage[STATIC_MESH].push_back(mesh);
+			staticIndexStorage[STATIC_TEXTURE].push_back(texture);
+		}
+		else
+		{
+			return parser.fail("unknown item or wrong number of values");
+		}
+	}
+	movers = moverIndexStorage[MOVER_MESH].size();
+	statics = staticIndexStorage[STATIC_MESH].size();
+	useStorage();
+	return true;
+} // end parseText method
+
+/*
+***********************************************
+*		Scene
+***********************************************
+*/
+bool Scene::load(const char* path)
+{
+	if (!file.open(path))
+	{
+		fprintf(stderr, "Scene %s can't be opened\n", path);
+		return false;
+	}
+	bool compiled = file.size() >= sizeof(sceneMagic) && memcmp(file.data(), sceneMagic, sizeof(sceneMagic)) == 0;
+	bool read = compiled ? readBinary(path) : parseText(path, file.data(), file.size());
+	// a text scene has been copied out, only a compiled one is used in place
+	if (!read || !compiled)
+	{
+		file.close();
+	}
+	return read && checkIndices(path);
+} // end load method
+
+bool Scene::readBinary(const char* path)
+{
+	SceneFileHeader header;
+	if (file.size() < sizeof(header))
+	{
+		fprintf(stderr, "Scene %s is truncated\n", path);
+		return false;
+	}
+	memcpy(&header, file.data(), sizeof(header));
+	if (header.version != sceneVersion)
+	{
+		fprintf(stderr, "Scene %s is version %u, expected %u; compile it again\n", path, header.version, sceneVersion);
+		return false;
+	}
+	SceneFileLayout layout = sceneLayout(header);
+	if (layout.end > file.size())
+	{
+		fprintf(stderr, "Scene %s is truncated\n", path);
+		return false;
+	}
+	const char* base = file.data();
+	const char* strings = base + layout.strings;
+	// every string must end inside the string section
+	auto readString = [&](uint32_t offset, string& value)
+	{
+		if (offset >= header.stringBytes || memchr(strings + offset, '\0', header.stringBytes - offset) == nullptr)
+		{
+			return false;
+		}
+		value = strings + offset;
+		return true;
+	};
+
+	meshes.resize(header.meshCount);
+	for (uint32_t i = 0; i < header.meshCount; i++)
+	{
+		SceneFileMesh mesh;
+		memcpy(&mesh, base + layout.meshes + i * sizeof(mesh), sizeof(mesh));
+		meshes[i].collisionShape = mesh.collisionShape != 0;
+		meshes[i].bakedRotation = quat(mesh.bakedRotation[3], mesh.bakedRotation[0], mesh.bakedRotation[1], mesh.bakedRotation[2]);
+		if (!readString(mesh.path, meshes[i].path))
+		{
+			fprintf(stderr, "Scene %s has a bad mesh path\n", path);
+			return false;
+		}
+	}
+	textures.resize(header.textureCount);
+	for (uint32_t i = 0; i < header.textureCount; i++)
+	{
+		uint32_t offset;
+		memcpy(&offset, base + layout.textures + i * sizeof(offset), sizeof(offset));
+		if (!readString(offset, textures[i]))
+		{
+			fprintf(stderr, "Scene %s has a bad texture path\n", path);
+			return false;
+		}
+	}
+	motions.resize(header.motionCount);
+	memcpy(motions.data(), base + layout.motions, header.motionCount * sizeof(MotionParams));
+	for (uint32_t i = 0; i < header.motionCount; i++)
+	{
+		if (!validMotion(motions[i]))
+		{
+			fprintf(stderr, "Scene %s: motion %u has a zero divisor or an amplitude modulo below 1\n", path, i);
+			return false;
+		}
+	}
+	lights.resize(header.lightCount);
+	memcpy(lights.data(), base + layout.lights, header.lightCount * sizeof(PointLight));
+	floor = header.floor;
+	background = header.background;
+	bounds = header.bounds;
+
+	// the entity columns stay in the mapping
+	movers = header.moverCount;
+	statics = header.staticCount;
+	for (int c = 0; c < moverFloatColumns; c++)
+	{
+		moverFloats[c] = (const float*)(base + layout.moverFloats) + c * movers;
+	}
+	for (int c = 0; c < moverIndexColumns; c++)
+	{
+		moverIndices[c] = (const uint32_t*)(base + layout.moverIndices) + c * movers;
+	}
+	for (int c = 0; c < staticFloatColumns; c++)
+	{
+		staticFloats[c] = (const float*)(base + layout.staticFloats) + c * statics;
+	}
+	for (int c = 0; c < staticIndexColumns; c++)
+	{
+		staticIndices[c] = (const uint32_t*)(base + layout.staticIndices) + c * statics;
+	}
+	return true;
+} // end readBinary method
+
+/* every entity must name a mesh, texture layer and motion that exist, the renderer and physics index with them */
+bool Scene::checkIndices(const char* path) const
+{
+	if (!textures.empty() && (floor.textureLayer >= textures.size() || background.textureLayer >= textures.size()))
+	{
+		fprintf(stderr, "Scene %s: the floor or background uses a missing texture\n", path);
+		return false;
+	}
+	for (size_t i = 0; i < movers; i++)
+	{
+		if (moverMesh(i) >= meshes.size() || moverTexture(i) >= textures.size() || moverIndices[MOVER_MOTION][i] >= motions.size())
+		{
+			fprintf(stderr, "Scene %s: mover %zu uses a missing mesh, texture or motion\n", path, i);
+			return false;
+		}
+	}
+	for (size_t i = 0; i < statics; i++)
+	{
+		if (staticMesh(i) >= meshes.size() || staticTexture(i) >= textures.size())
+		{
+			fprintf(stderr, "Scene %s: static %zu uses a missing mesh or texture\n", path, i);
+			return false;
+		}
+	}
+	return true;
+} // end checkIndices method
+
+void Scene::useStorage()
+{
+	for (int c = 0; c < moverFloatColumns; c++)
+	{
+		moverFloats[c] = moverFloatStorage[c].data();
+	}
+	for (int c = 0; c < moverIndexColumns; c++)
+	{
+		moverIndices[c] = moverIndexStorage[c].data();
+	}
+	for (int c = 0; c < staticFloatColumns; c++)
+	{
+		staticFloats[c] = staticFloatStorage[c].data();
+	}
+	for (int c = 0; c < staticIndexColumns; c++)
+	{
+		staticIndices[c] = staticIndexStorage[c].data();
+	}
+} // end useStorage method
+
+bool Scene::save(const char* path) const
+{
+	FILE* out = fopen(path, "wb");
+	if (out == nullptr)
+	{
+		fprintf(stderr, "Scene %s can't be written\n", path);
+		return false;
+	}
+
+	// every path goes into the string section, NUL terminated and padded to a whole word
+	string strings;
+	auto addString = [&](const string& value)
+	{
+		uint32_t offset = (uint32_t)strings.size();
+		strings.append(value.c_str(), value.size() + 1);
+		return offset;
+	};
+	vector<SceneFileMesh> fileMeshes(meshes.size());
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		const quat& baked = meshes[i].bakedRotation;
+		fileMeshes[i] = { addString(meshes[i].path), meshes[i].collisionShape ? 1u : 0u, { baked.x, baked.y, baked.z, baked.w } };
+	}
+	vector<uint32_t> texturePaths;
+	for (const auto& texture : textures)
+	{
+		texturePaths.push_back(addString(texture));
+	}
+	strings.resize((strings.size() + 3) & ~(size_t)3, '\0');
+
+	SceneFileHeader header;
+	memcpy(header.magic, sceneMagic, sizeof(sceneMagic));
+	header.version = sceneVersion;
+	header.meshCount = (uint32_t)meshes.size();
+	header.textureCount = (uint32_t)textures.size();
+	header.motionCount = (uint32_t)motions.size();
+	header.lightCount = (uint32_t)lights.size();
+	header.moverCount = (uint32_t)movers;
+	header.staticCount = (uint32_t)statics;
+	header.stringBytes = (uint32_t)strings.size();
+	header.floor = floor;
+	header.background = background;
+	header.bounds = bounds;
+
+	// sections in sceneLayout() order
+	fwrite(&header, sizeof(header), 1, out);
+	fwrite(fileMeshes.data(), sizeof(SceneFileMesh), fileMeshes.size(), out);
+	fwrite(texturePaths.data(), sizeof(uint32_t), texturePaths.size(), out);
+	fwrite(motions.data(), sizeof(MotionParams), motions.size(), out);
+	fwrite(lights.data(), sizeof(PointLight), lights.size(), out);
+	for (int c = 0; c < moverFloatColumns; c++)
+	{
+		fwrite(moverFloats[c], sizeof(float), movers, out);
+	}
+	for (int c = 0; c < moverIndexColumns; c++)
+	{
+		fwrite(moverIndices[c], sizeof(uint32_t), movers, out);
+	}
+	for (int c = 0; c < staticFloatColumns; c++)
+	{
+		fwrite(staticFloats[c], sizeof(float), statics, out);
+	}
+	for (int c = 0; c < staticIndexColumns; c++)
+	{
+		fwrite(staticIndices[c], sizeof(uint32_t), statics, out);
+	}
+	fwrite(strings.data(), 1, strings.size(), out);
+	bool written = ferror(out) == 0;
+	if (fclose(out) != 0 || !written)
+	{
+		fprintf(stderr, "Scene %s could not be written completely\n", path);
+		return false;
+	}
+	return true;
+} // end save method
+
+void Scene::scatter(size_t count, unsigned int seed)
+{
+	size_t templateMovers = movers, templateStatics = statics;
+	if (templateMovers + templateStatics == 0)
+	{
+		return;
+	}
+	// a compiled scene is read in place, copy it out before it grows
+	if (file.data() != nullptr)
+	{
+		for (int c = 0; c < moverFloatColumns; c++)
+		{
+			moverFloatStorage[c].assign(moverFloats[c], moverFloats[c] + movers);
+		}
+		for (int c = 0; c < moverIndexColumns; c++)
+		{
+			moverIndexStorage[c].assign(moverIndices[c], moverIndices[c] + movers);
+		}
+		for (int c = 0; c < staticFloatColumns; c++)
+		{
+			staticFloatStorage[c].assign(staticFloats[c], staticFloats[c] + statics);
+		}
+		for (int c = 0; c < staticIndexColumns; c++)
+		{
+			staticIndexStorage[c].assign(staticIndices[c], staticIndices[c] + statics);
+		}
+		file.close();
+	}
+
+	// copies keep the template's mix of movers and statics and its heights, spread over the floor
+	mt19937 random(seed);
+	uniform_real_distribution<float> across(-floor.width / 2.0f, floor.width / 2.0f);
+	uniform_real_distribution<float> along(-floor.height / 2.0f, floor.height / 2.0f);
+	for (size_t copy = 0; movers + statics < count; copy++)
+	{
+		size_t source = copy % (templateMovers + templateStatics);
+		if (source < templateMovers)
+		{
+			for (int c = 0; c < moverFloatColumns; c++)
+			{
+				moverFloatStorage[c].push_back(moverFloatStorage[c][source]);
+			}
+			for (int c = 0; c < moverIndexColumns; c++)
+			{
+				moverIndexStorage[c].push_back(moverIndexStorage[c][source]);
+			}
+			moverFloatStorage[MOVER_X].back() = across(random);
+			moverFloatStorage[MOVER_Y].back() = along(random);
+			movers++;
+		}
+		else
+		{
+			source -= templateMovers;
+			for (int c = 0; c < staticFloatColumns; c++)
+			{
+				staticFloatStorage[c].push_back(staticFloatStorage[c][source]);
+			}
+			for (int c = 0; c < staticIndexColumns; c++)
+			{
+				staticIndexStorage[c].push_back(staticIndexStorage[c][source]);
+			}
+			staticFloatStorage[STATIC_X].back() = across(random);
+			staticFloatStorage[STATIC_Y].back() = along(random);
+			statics++;
+		}
+	}
+	useStorage();
+} // end scatter method
+
+size_t Scene::addMovers(MoverArrays& store, const vector<const MeshBVH*>& shapes) const
+{
+	size_t first = store.append(movers);
+	// the state columns are copied whole
+	auto copyColumn = [&](SceneMoverFloat column, vector<float>& target)
+	{
+		copy(moverFloats[column], moverFloats[column] + movers, target.begin() + first);
+	};
+	copyColumn(MOVER_X, store.posX); copyColumn(MOVER_Y, store.posY); copyColumn(MOVER_Z, store.posZ);
+	copyColumn(MOVER_X, store.targetX); copyColumn(MOVER_Y, store.targetY); copyColumn(MOVER_Z, store.targetZ);
+	copyColumn(MOVER_VELOCITY_X, store.velX); copyColumn(MOVER_VELOCITY_Y, store.velY); copyColumn(MOVER_VELOCITY_Z, store.velZ);
+	copyColumn(MOVER_RADIUS, store.radius);
+	copyColumn(MOVER_RADIUS, store.coreRadius);
+
+	// the rest is derived per mover
+	jobs.parallelFor(movers, moverGrain, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			size_t mover = first + i;
+			float mass = moverFloats[MOVER_MASS][i];
+			store.inverseMass[mover] = mass > 0.0f ? 1.0f / mass : 0.0f;
+			const MotionParams& motion = motions[moverIndices[MOVER_MOTION][i]];
+			store.motion[mover] = motion;
+			store.phaseX[mover] = motion.phase.x;
+			store.phaseY[mover] = motion.phase.y;
+			store.phaseZ[mover] = motion.phase.z;
+			uint32_t mesh = moverMesh(i);
+			quat rotation(moverFloats[MOVER_ROTATION_W][i], moverFloats[MOVER_ROTATION_X][i],
+				moverFloats[MOVER_ROTATION_Y][i], moverFloats[MOVER_ROTATION_Z][i]);
+			vec3 spin(moverFloats[MOVER_SPIN_X][i], moverFloats[MOVER_SPIN_Y][i], moverFloats[MOVER_SPIN_Z][i]);
+			store.setShape(mover, mesh < shapes.size() ? shapes[mesh] : nullptr, rotation, spin, meshes[mesh].bakedRotation);
+		}
+	});
+	return first;
+} // end addMovers method
+
+vec3 Scene::staticPosition(size_t i) const
+{
+	return vec3(staticFloats[STATIC_X][i], staticFloats[STATIC_Y][i], staticFloats[STATIC_Z][i]);
+} // end staticPosition method
+
+quat Scene::staticRotation(size_t i) const
+{
+	quat rotation(staticFloats[STATIC_ROTATION_W][i], staticFloats[STATIC_ROTATION_X][i],
+		staticFloats[STATIC_ROTATION_Y][i], staticFloats[STATIC_ROTATION_Z][i]);
+	return rotation * conjugate(meshes[staticMesh(i)].bakedRotation);
+} // end staticRotation method
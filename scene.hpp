@@ -0,0 +1,129 @@
+#ifndef SCENE_HPP
+#define SCENE_HPP
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include "mappedfile.hpp"
+#include "physics.hpp"
+#include "clusteredlights.hpp"
+
+class MeshBVH;
+
+/* SceneMesh - one .obj of the scene and how the loader prepares it */
+struct SceneMesh
+{
+	std::string path;
+	bool collisionShape;
+	glm::quat bakedRotation;	// turned into the vertices at load, every instance's rotation includes it
+};
+
+/* SceneQuad - the floor or the background, a flat rectangle textured with one layer */
+struct SceneQuad
+{
+	float width;
+	float height;
+	uint32_t textureLayer;
+};
+
+/* SceneBounds - the window boundaries the movers stay inside (the floor and background close off the rest) */
+struct SceneBounds
+{
+	float minX, maxX;	// left and right walls
+	float maxY;			// the floor is the lower bound, the ceiling sits above this
+	float maxZ;			// the wall towards the camera
+};
+
+// mover flags
+const uint32_t SCENE_MOVER_CANDLE = 1;	// carries a flickering light
+
+/* per-mover float columns, in file order */
+enum SceneMoverFloat
+{
+	MOVER_X, MOVER_Y, MOVER_Z,
+	MOVER_VELOCITY_X, MOVER_VELOCITY_Y, MOVER_VELOCITY_Z,
+	MOVER_RADIUS, MOVER_MASS,
+	MOVER_SPIN_X, MOVER_SPIN_Y, MOVER_SPIN_Z,
+	MOVER_ROTATION_X, MOVER_ROTATION_Y, MOVER_ROTATION_Z, MOVER_ROTATION_W,
+	moverFloatColumns
+};
+/* per-mover index columns */
+enum SceneMoverIndex
+{
+	MOVER_MESH, MOVER_TEXTURE, MOVER_MOTION, MOVER_FLAGS,
+	moverIndexColumns
+};
+/* per-static float columns */
+enum SceneStaticFloat
+{
+	STATIC_X, STATIC_Y, STATIC_Z,
+	STATIC_ROTATION_X, STATIC_ROTATION_Y, STATIC_ROTATION_Z, STATIC_ROTATION_W,
+	staticFloatColumns
+};
+/* per-static index columns */
+enum SceneStaticIndex
+{
+	STATIC_MESH, STATIC_TEXTURE,
+	staticIndexColumns
+};
+
+/* Scene - meshes, textures, motions, lights and entity instances of a scene, read from a text .scene file
+   or from its compiled binary form; the binary form is memory mapped and its entity columns are used in
+   place, so a scene of a million entities loads with a handful of copies straight into the SoA stores */
+class Scene
+{
+public:
+	// read a text or compiled scene (told apart by the header), false with a message if it is malformed
+	bool load(const char* path);
+	// write the compiled binary form
+	bool save(const char* path) const;
+	// append copies of the scene's movers and statics at random spots on the floor until it holds count entities
+	void scatter(size_t count, unsigned int seed);
+
+	// append every mover to the physics store, colliding with shapes[mesh] (null for a sphere); returns the first index
+	size_t addMovers(MoverArrays& movers, const std::vector<const MeshBVH*>& shapes) const;
+
+	size_t moverCount() const { return movers; }
+	size_t staticCount() const { return statics; }
+	uint32_t moverMesh(size_t i) const { return moverIndices[MOVER_MESH][i]; }
+	uint32_t moverTexture(size_t i) const { return moverIndices[MOVER_TEXTURE][i]; }
+	uint32_t moverFlags(size_t i) const { return moverIndices[MOVER_FLAGS][i]; }
+	uint32_t staticMesh(size_t i) const { return staticIndices[STATIC_MESH][i]; }
+	uint32_t staticTexture(size_t i) const { return staticIndices[STATIC_TEXTURE][i]; }
+	glm::vec3 staticPosition(size_t i) const;
+	// model rotation of a static, with its mesh's baked rotation taken back out
+	glm::quat staticRotation(size_t i) const;
+
+	std::vector<SceneMesh> meshes;
+	std::vector<std::string> textures;	// one texture array layer per file
+	std::vector<MotionParams> motions;
+	std::vector<PointLight> lights;
+	SceneQuad floor = { 45.0f, 60.0f, 0 };
+	SceneQuad background = { 60.0f, 20.0f, 0 };
+	SceneBounds bounds = { -35.5f, 35.5f, 20.0f, 20.5f };
+
+private:
+	bool parseText(const char* path, const char* text, size_t size);
+	bool readBinary(const char* path);
+	bool checkIndices(const char* path) const;
+	// point the columns at the owned storage (text scenes, or after scatter copied a mapped scene)
+	void useStorage();
+
+	size_t movers = 0;
+	size_t statics = 0;
+	// columns in use: into the mapped file, or into the storage below
+	const float* moverFloats[moverFloatColumns] = {};
+	const uint32_t* moverIndices[moverIndexColumns] = {};
+	const float* staticFloats[staticFloatColumns] = {};
+	const uint32_t* staticIndices[staticIndexColumns] = {};
+	std::vector<float> moverFloatStorage[moverFloatColumns];
+	std::vector<uint32_t> moverIndexStorage[moverIndexColumns];
+	std::vector<float> staticFloatStorage[staticFloatColumns];
+	std::vector<uint32_t> staticIndexStorage[staticIndexColumns];
+	MappedFile file;
+};
+
+#endif
@@ -0,0 +1,207 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Shader loading with compile-time #define variants. Features that are
+* switched off are removed from the shader by the preprocessor instead of
+* being branched over per fragment.
+* 
+* References:
+* LoadShaders() from Tutorial 9 Base Code from https://www.opengl-tutorial.org/
+*
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+
+// include GLEW
+#include <GL/glew.h>
+
+using namespace std;
+
+#include "shaderpermutations.hpp"
+
+/* #define names for every feature bit that is set */
+vector<string> shaderFeatureDefines(unsigned int features)
+{
+	vector<string> defines;
+	if (features & SHADER_LIGHTING)
+	{
+		defines.push_back("LIGHTING");
+	}
+	if (features & SHADER_SPECULAR)
+	{
+		defines.push_back("SPECULAR");
+	}
+	if (features & SHADER_INTERNAL_LIGHT)
+	{
+		defines.push_back("INTERNAL_LIGHT");
+	}
+	if (features & SHADER_PER_FRAGMENT_REFERENCE)
+	{
+		defines.push_back("PER_FRAGMENT_REFERENCE");
+	}
+	if (features & SHADER_DEPTH_ONLY)
+	{
+		defines.push_back("DEPTH_ONLY");
+	}
+	if (features & SHADER_COMPRESSED_VERTICES)
+	{
+		defines.push_back("COMPRESSED_VERTICES");
+	}
+	return defines;
+} // end shaderFeatureDefines method
+
+/* read a shader file and insert "#define NAME" lines right after its #version line */
+static bool readShaderSource(const char* file_path, const vector<string>& defines, string& code)
+{
+	ifstream shaderStream(file_path, ios::in);
+	if (!shaderStream.is_open())
+	{
+		printf("Impossible to open %s. Are you in the right directory ?\n", file_path);
+		return false;
+	}
+	stringstream sstr;
+	sstr << shaderStream.rdbuf();
+	code = sstr.str();
+	shaderStream.close();
+
+	// #version must stay the first line, so the defines go right after it
+	string defineBlock;
+	for (const auto& define : defines)
+	{
+		defineBlock += "#define " + define + "\n";
+	}
+	size_t versionLine = code.find("#version");
+	size_t insertAt = versionLine == string::npos ? 0 : code.find('\n', versionLine);
+	insertAt = insertAt == string::npos ? code.size() : insertAt + 1;
+	code.insert(insertAt, defineBlock);
+	return true;
+} // end readShaderSource method
+
+/* compile one shader stage and print its log */
+static GLuint compileShader(GLenum type, const char* file_path, const string& code)
+{
+	GLint result = GL_FALSE;
+	int infoLogLength;
+
+	printf("Compiling shader : %s\n", file_path);
+	GLuint shaderID = glCreateShader(type);
+	const char* sourcePointer = code.c_str();
+	glShaderSource(shaderID, 1, &sourcePointer, NULL);
+	glCompileShader(shaderID);
+
+	// check the shader
+	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &result);
+	glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &infoLogLength);
+	if (infoLogLength > 0)
+	{
+		vector<char> shaderErrorMessage(infoLogLength + 1);
+		glGetShaderInfoLog(shaderID, infoLogLength, NULL, &shaderErrorMessage[0]);
+		printf("%s\n", &shaderErrorMessage[0]);
+	}
+	return shaderID;
+} // end compileShader method
+
+/* link the given shader stages into a program, deleting the stages afterwards */
+static GLuint linkProgram(const vector<GLuint>& shaderIDs)
+{
+	GLint result = GL_FALSE;
+	int infoLogLength;
+
+	printf("Linking program\n");
+	GLuint programID = glCreateProgram();
+	for (GLuint shaderID : shaderIDs)
+	{
+		glAttachShader(programID, shaderID);
+	}
+	glLinkProgram(programID);
+
+	// check the program
+	glGetProgramiv(programID, GL_LINK_STATUS, &result);
+	glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &infoLogLength);
+	if (infoLogLength > 0)
+	{
+		vector<char> programErrorMessage(infoLogLength + 1);
+		glGetProgramInfoLog(programID, infoLogLength, NULL, &programErrorMessage[0]);
+		printf("%s\n", &programErrorMessage[0]);
+	}
+
+	for (GLuint shaderID : shaderIDs)
+	{
+		glDetachShader(programID, shaderID);
+		glDeleteShader(shaderID);
+	}
+
+	if (result == GL_FALSE)
+	{
+		glDeleteProgram(programID);
+		return 0;
+	}
+	return programID;
+} // end linkProgram method
+
+/* compile and link a vertex + fragment program with the given defines */
+GLuint LoadShadersWithDefines(const char* vertex_file_path, const char* fragment_file_path,
+	const vector<string>& defines)
+{
+	string vertexShaderCode;
+	string fragmentShaderCode;
+	if (!readShaderSource(vertex_file_path, defines, vertexShaderCode) ||
+		!readShaderSource(fragment_file_path, defines, fragmentShaderCode))
+	{
+		return 0;
+	}
+	GLuint vertexShaderID = compileShader(GL_VERTEX_SHADER, vertex_file_path, vertexShaderCode);
+	GLuint fragmentShaderID = compileShader(GL_FRAGMENT_SHADER, fragment_file_path, fragmentShaderCode);
+	return linkProgram({ vertexShaderID, fragmentShaderID });
+} // end LoadShadersWithDefines method
+
+/* compile and link a compute shader program */
+GLuint LoadComputeShader(const char* compute_file_path, const vector<string>& defines)
+{
+	string computeShaderCode;
+	if (!readShaderSource(compute_file_path, defines, computeShaderCode))
+	{
+		return 0;
+	}
+	GLuint computeShaderID = compileShader(GL_COMPUTE_SHADER, compute_file_path, computeShaderCode);
+	return linkProgram({ computeShaderID });
+} // end LoadComputeShader method
+
+/* compile the requested feature combination the first time it is asked for */
+GLuint ShaderPermutations::get(unsigned int features)
+{
+	auto found = programs.find(features);
+	if (found != programs.end())
+	{
+		return found->second;
+	}
+	GLuint programID = LoadShadersWithDefines(vertexPath.c_str(), fragmentPath.c_str(), shaderFeatureDefines(features));
+	programs[features] = programID;
+	return programID;
+} // end get method
+
+/* delete every compiled permutation */
+void ShaderPermutations::cleanup()
+{
+	for (auto& program : programs)
+	{
+		glDeleteProgram(program.second);
+	}
+	programs.clear();
+} // end cleanup method
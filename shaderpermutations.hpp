@@ -0,0 +1,47 @@
+#ifndef SHADERPERMUTATIONS_HPP
+#define SHADERPERMUTATIONS_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+/* compile-time features of StandardShading, each one becomes a #define */
+enum ShaderFeature
+{
+	SHADER_LIGHTING = 1 << 0,				// diffuse lighting from the scene light
+	SHADER_SPECULAR = 1 << 1,				// specular highlight (needs SHADER_LIGHTING)
+	SHADER_INTERNAL_LIGHT = 1 << 2,			// time driven internal glow
+	SHADER_PER_FRAGMENT_REFERENCE = 1 << 3,	// original per-fragment frame constants, for benchmarking only
+	SHADER_DEPTH_ONLY = 1 << 4,				// no shading at all, for the depth pre-pass
+	SHADER_COMPRESSED_VERTICES = 1 << 5		// decode quantized / octahedral / half-float attributes (IndirectRenderer compressed format)
+};
+
+// #define names for every feature bit that is set
+std::vector<std::string> shaderFeatureDefines(unsigned int features);
+
+// compile and link a vertex + fragment program with the defines injected after #version
+GLuint LoadShadersWithDefines(const char* vertex_file_path, const char* fragment_file_path,
+	const std::vector<std::string>& defines);
+
+// compile and link a compute shader program
+GLuint LoadComputeShader(const char* compute_file_path, const std::vector<std::string>& defines = {});
+
+/* ShaderPermutations - compiles each feature combination of one vertex/fragment pair on first use */
+class ShaderPermutations
+{
+public:
+	ShaderPermutations(const char* vertexPath, const char* fragmentPath) :
+		vertexPath(vertexPath), fragmentPath(fragmentPath) {}
+
+	// program for the given feature bits (0 if it failed to compile)
+	GLuint get(unsigned int features);
+	// delete every program compiled so far
+	void cleanup();
+
+private:
+	std::string vertexPath;
+	std::string fragmentPath;
+	std::map<unsigned int, GLuint> programs;
+};
+
+#endif
@@ -0,0 +1,508 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with
+* Custom Classes, Mulithreading, & OpenGL
+*
+* Description:
+* Simulation traces. The physics thread hands every tick to a writer
+* thread, which stores each slot's position, world rotation, generation
+* and tag as the XOR of its bits with the previous tick (lossless, zero
+* for anything that did not change), followed by the pairs that touched.
+* Values are varints, and zeros are collapsed into run lengths. Ticks are
+* grouped into chunks that each start from zero, so a chunk decodes on
+* its own. A replay reads the chunks back one at a time and feeds the
+* renderer exactly what physics produced, without running physics.
+*
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// include GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+using namespace glm;
+using namespace std;
+
+#include "simulationtrace.hpp"
+
+/* TraceHeader - start of a trace file, followed by the scene path */
+struct TraceHeader
+{
+	char magic[8];			// "SIMTRACE"
+	uint32_t version;
+	uint32_t slots;			// mover slots per tick
+	float tick;				// seconds per tick
+	uint32_t sceneBytes;	// length of the scene path
+};
+/* TraceChunk - a run of ticks that decodes on its own, followed by its encoded bytes */
+struct TraceChunk
+{
+	uint32_t ticks;
+	uint32_t bytes;
+};
+
+const char traceMagic[8] = { 'S', 'I', 'M', 'T', 'R', 'A', 'C', 'E' };
+const uint32_t traceVersion = 1;
+// ticks per chunk
+const uint32_t chunkTickCount = 64;
+// ticks the stepping thread may get ahead of the writer, fewer for big scenes to stay within the byte budget
+const size_t recordRingTicks = 128;
+const size_t recordRingBytes = 64 * 1024 * 1024;
+
+/*
+***********************************************
+*		Encoding
+***********************************************
+*/
+static void writeVarint(vector<unsigned char>& out, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((unsigned char)value);
+} // end writeVarint method
+
+static bool readVarint(const vector<unsigned char>& in, size_t& offset, uint64_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (offset >= in.size())
+		{
+			return false;
+		}
+		unsigned char byte = in[offset++];
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+} // end readVarint method
+
+static inline uint32_t floatBits(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+} // end floatBits method
+
+static inline float bitsFloat(uint32_t bits)
+{
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+} // end bitsFloat method
+
+/* bits of one column of a slot; components by name, glm versions differ in the quaternion's memory layout */
+static uint32_t columnValue(const TransformSnapshot& snapshot, int column, size_t i)
+{
+	switch (column)
+	{
+	case TRACE_X: return floatBits(snapshot.position[i].x);
+	case TRACE_Y: return floatBits(snapshot.position[i].y);
+	case TRACE_Z: return floatBits(snapshot.position[i].z);
+	case TRACE_ROTATION_X: return floatBits(snapshot.rotation[i].x);
+	case TRACE_ROTATION_Y: return floatBits(snapshot.rotation[i].y);
+	case TRACE_ROTATION_Z: return floatBits(snapshot.rotation[i].z);
+	case TRACE_ROTATION_W: return floatBits(snapshot.rotation[i].w);
+	case TRACE_GENERATION: return snapshot.generation[i];
+	default: return snapshot.tag[i];
+	}
+} // end columnValue method
+
+/* one column of a tick: (zero run, changed value) pairs, then the run of zeros that ends the column */
+static void encodeColumn(vector<unsigned char>& out, const uint32_t* values, vector<uint32_t>& previous)
+{
+	size_t slots = previous.size();
+	size_t position = 0;
+	for (size_t i = 0; i < slots; i++)
+	{
+		uint32_t change = values[i] ^ previous[i];
+		if (change != 0)
+		{
+			writeVarint(out, i - position);
+			writeVarint(out, change);
+			previous[i] = values[i];
+			position = i + 1;
+		}
+	}
+	if (position < slots)
+	{
+		writeVarint(out, slots - position);
+	}
+} // end encodeColumn method
+
+static bool decodeColumn(const vector<unsigned char>& in, size_t& offset, vector<uint32_t>& values)
+{
+	size_t slots = values.size();
+	size_t position = 0;
+	while (position < slots)
+	{
+		uint64_t run, change;
+		if (!readVarint(in, offset, run) || run > slots - position)
+		{
+			return false;
+		}
+		position += (size_t)run;
+		if (position == slots)
+		{
+			break;
+		}
+		if (!readVarint(in, offset, change))
+		{
+			return false;
+		}
+		values[position++] ^= (uint32_t)change;
+	}
+	return true;
+} // end decodeColumn method
+
+/*
+***********************************************
+*		Recorder
+***********************************************
+*/
+bool TraceRecorder::open(const char* path, size_t slots, float tick, const char* scenePath)
+{
+	close();
+	file = fopen(path, "wb");
+	if (file == nullptr)
+	{
+		fprintf(stderr, "Cannot create trace %s\n", path);
+		return false;
+	}
+	TraceHeader header = {};
+	memcpy(header.magic, traceMagic, sizeof(header.magic));
+	header.version = traceVersion;
+	header.slots = (uint32_t)slots;
+	header.tick = tick;
+	header.sceneBytes = (uint32_t)strlen(scenePath);
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(scenePath, 1, header.sceneBytes, file);
+
+	slotCount = slots;
+	size_t tickBytes = std::max(slots, (size_t)1) * (sizeof(vec3) + sizeof(quat) + 2 * sizeof(unsigned int));
+	ring.resize(std::max((size_t)4, std::min(recordRingTicks, recordRingBytes / tickBytes)));
+	// sized now, so recording allocates nothing once it runs
+	for (TickState& state : ring)
+	{
+		state.snapshot.position.resize(slots);
+		state.snapshot.rotation.resize(slots);
+		state.snapshot.generation.resize(slots);
+		state.snapshot.tag.resize(slots);
+		state.contacts.reserve(256);
+	}
+	ringFirst = ringCount = 0;
+	closing = false;
+	for (auto& column : previous)
+	{
+		column.assign(slots, 0);
+	}
+	chunk.clear();
+	chunkTicks = 0;
+	ticksWritten = 0;
+	bytesWritten = sizeof(header) + header.sceneBytes;
+	writer = thread(&TraceRecorder::writerLoop, this);
+	return true;
+} // end open method
+
+void TraceRecorder::record(const MoverArrays& movers, float time, unsigned long long tick)
+{
+	size_t slot;
+	{
+		unique_lock<mutex> guard(lock);
+		// a disk slower than the simulation holds it back rather than dropping ticks
+		drained.wait(guard, [this] { return ringCount < ring.size(); });
+		slot = (ringFirst + ringCount) % ring.size();
+	}
+	// the writer does not look at this entry until it is counted in
+	captureSnapshot(movers, time, tick, ring[slot].snapshot);
+	collectContacts(movers, ring[slot].contacts);
+	{
+		lock_guard<mutex> guard(lock);
+		ringCount++;
+	}
+	filled.notify_one();
+} // end record method
+
+void TraceRecorder::writerLoop()
+{
+	while (true)
+	{
+		size_t slot;
+		{
+			unique_lock<mutex> guard(lock);
+			filled.wait(guard, [this] { return ringCount > 0 || closing; });
+			if (ringCount == 0)
+			{
+				break;
+			}
+			slot = ringFirst;
+		}
+		encode(ring[slot]);
+		{
+			lock_guard<mutex> guard(lock);
+			ringFirst = (ringFirst + 1) % ring.size();
+			ringCount--;
+		}
+		drained.notify_one();
+	}
+	flushChunk();
+} // end writerLoop method
+
+/* tick number, time, the columns against the previous tick, then the contacts */
+void TraceRecorder::encode(const TickState& state)
+{
+	const TransformSnapshot& snapshot = state.snapshot;
+	writeVarint(chunk, snapshot.tick);
+	writeVarint(chunk, floatBits(snapshot.time));
+	for (int c = 0; c < traceColumns; c++)
+	{
+		vector<uint32_t>& last = previous[c];
+		size_t slots = last.size();
+		column.resize(slots);
+		for (size_t i = 0; i < slots; i++)
+		{
+			column[i] = columnValue(snapshot, c, i);
+		}
+		encodeColumn(chunk, column.data(), last);
+	}
+	writeVarint(chunk, state.contacts.size());
+	for (const MoverPair& pair : state.contacts)
+	{
+		writeVarint(chunk, pair.first);
+		writeVarint(chunk, pair.second);
+	}
+	if (++chunkTicks == chunkTickCount)
+	{
+		flushChunk();
+	}
+} // end encode method
+
+void TraceRecorder::flushChunk()
+{
+	if (chunkTicks == 0)
+	{
+		return;
+	}
+	TraceChunk header = { chunkTicks, (uint32_t)chunk.size() };
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(chunk.data(), 1, chunk.size(), file);
+	ticksWritten += chunkTicks;
+	bytesWritten += sizeof(header) + chunk.size();
+	chunk.clear();
+	chunkTicks = 0;
+	// the next chunk starts from nothing, so it can be decoded without this one
+	for (auto& column : previous)
+	{
+		fill(column.begin(), column.end(), 0);
+	}
+} // end flushChunk method
+
+void TraceRecorder::close()
+{
+	if (file == nullptr)
+	{
+		return;
+	}
+	{
+		lock_guard<mutex> guard(lock);
+		closing = true;
+	}
+	filled.notify_one();
+	writer.join();
+	fclose(file);
+	file = nullptr;
+	printf("Trace: %llu ticks, %.1f KB (%.1f bytes per slot-tick)\n", ticksWritten, bytesWritten / 1024.0,
+		ticksWritten > 0 && slotCount > 0 ? (double)bytesWritten / (double)(ticksWritten * slotCount) : 0.0);
+} // end close method
+
+/*
+***********************************************
+*		Reader
+***********************************************
+*/
+bool TraceReader::open(const char* path)
+{
+	close();
+	file = fopen(path, "rb");
+	if (file == nullptr)
+	{
+		fprintf(stderr, "Cannot open trace %s\n", path);
+		return false;
+	}
+	TraceHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, traceMagic, sizeof(header.magic)) != 0 ||
+		header.version != traceVersion || header.sceneBytes > 4096)
+	{
+		fprintf(stderr, "%s is not a version %u simulation trace\n", path, traceVersion);
+		close();
+		return false;
+	}
+	scenePath.assign(header.sceneBytes, '\0');
+	if (header.sceneBytes > 0 && fread(&scenePath[0], 1, header.sceneBytes, file) != header.sceneBytes)
+	{
+		fprintf(stderr, "%s is truncated\n", path);
+		close();
+		return false;
+	}
+	slotCount = header.slots;
+	tickSeconds = header.tick;
+	chunkTicksLeft = 0;
+	return true;
+} // end open method
+
+bool TraceReader::readChunk()
+{
+	TraceChunk header;
+	if (file == nullptr || fread(&header, sizeof(header), 1, file) != 1 || header.ticks == 0)
+	{
+		return false;
+	}
+	chunk.resize(header.bytes);
+	if (header.bytes > 0 && fread(chunk.data(), 1, header.bytes, file) != header.bytes)
+	{
+		return false;
+	}
+	chunkOffset = 0;
+	chunkTicksLeft = header.ticks;
+	for (auto& column : current)
+	{
+		column.assign(slotCount, 0);
+	}
+	return true;
+} // end readChunk method
+
+bool TraceReader::next(TransformSnapshot& snapshot, MoverPairs* contacts)
+{
+	if (chunkTicksLeft == 0 && !readChunk())
+	{
+		return false;
+	}
+	chunkTicksLeft--;
+	uint64_t tick, time, contactCount;
+	if (!readVarint(chunk, chunkOffset, tick) || !readVarint(chunk, chunkOffset, time))
+	{
+		return false;
+	}
+	for (auto& column : current)
+	{
+		if (!decodeColumn(chunk, chunkOffset, column))
+		{
+			return false;
+		}
+	}
+	if (!readVarint(chunk, chunkOffset, contactCount))
+	{
+		return false;
+	}
+	if (contacts != nullptr)
+	{
+		contacts->clear();
+	}
+	for (uint64_t c = 0; c < contactCount; c++)
+	{
+		uint64_t first, second;
+		if (!readVarint(chunk, chunkOffset, first) || !readVarint(chunk, chunkOffset, second))
+		{
+			return false;
+		}
+		if (contacts != nullptr)
+		{
+			contacts->push_back(make_pair((unsigned int)first, (unsigned int)second));
+		}
+	}
+
+	snapshot.position.resize(slotCount);
+	snapshot.rotation.resize(slotCount);
+	snapshot.generation.resize(slotCount);
+	snapshot.tag.resize(slotCount);
+	for (size_t i = 0; i < slotCount; i++)
+	{
+		snapshot.position[i] = vec3(bitsFloat(current[TRACE_X][i]), bitsFloat(current[TRACE_Y][i]), bitsFloat(current[TRACE_Z][i]));
+		snapshot.rotation[i] = quat(bitsFloat(current[TRACE_ROTATION_W][i]), bitsFloat(current[TRACE_ROTATION_X][i]),
+			bitsFloat(current[TRACE_ROTATION_Y][i]), bitsFloat(current[TRACE_ROTATION_Z][i]));
+		snapshot.generation[i] = current[TRACE_GENERATION][i];
+		snapshot.tag[i] = current[TRACE_TAG][i];
+	}
+	snapshot.time = bitsFloat((uint32_t)time);
+	snapshot.tick = tick;
+	return true;
+} // end next method
+
+void TraceReader::close()
+{
+	if (file != nullptr)
+	{
+		fclose(file);
+		file = nullptr;
+	}
+} // end close method
+
+/*
+***********************************************
+*		Summary
+***********************************************
+*/
+bool printTraceSummary(const char* path)
+{
+	TraceReader trace;
+	if (!trace.open(path))
+	{
+		return false;
+	}
+	TransformSnapshot snapshot;
+	MoverPairs contacts;
+	unsigned long long ticks = 0, contactTotal = 0;
+	size_t busiestTick = 0, liveSlots = 0;
+	float firstTime = 0.0f, lastTime = 0.0f;
+	while (trace.next(snapshot, &contacts))
+	{
+		if (ticks == 0)
+		{
+			firstTime = snapshot.time;
+		}
+		lastTime = snapshot.time;
+		ticks++;
+		contactTotal += contacts.size();
+		busiestTick = std::max(busiestTick, contacts.size());
+	}
+	for (unsigned int generation : snapshot.generation)
+	{
+		liveSlots += generation != noGeneration;
+	}
+	FILE* file = fopen(path, "rb");
+	long bytes = 0;
+	if (file != nullptr)
+	{
+		fseek(file, 0, SEEK_END);
+		bytes = ftell(file);
+		fclose(file);
+	}
+	double rawBytes = (double)ticks * trace.slots() * traceColumns * sizeof(uint32_t);
+	printf("Trace %s: scene %s, %zu slots, %.1f Hz\n", path, trace.scene().c_str(), trace.slots(),
+		trace.tick() > 0.0f ? 1.0f / trace.tick() : 0.0f);
+	printf("  %llu ticks (%.2f s to %.2f s), %zu slots live at the end\n", ticks, firstTime, lastTime, liveSlots);
+	printf("  %llu contacts, at most %zu in a tick\n", contactTotal, busiestTick);
+	printf("  %.1f KB on disk, %.1f KB raw (%.1fx)\n", bytes / 1024.0, rawBytes / 1024.0, bytes > 0 ? rawBytes / bytes : 0.0);
+	return true;
+} // end printTraceSummary method
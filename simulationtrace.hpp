@@ -0,0 +1,101 @@
+#ifndef SIMULATIONTRACE_HPP
+#define SIMULATIONTRACE_HPP
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "physics.hpp"
+#include "transformsnapshots.hpp"
+
+/* per-slot values stored for every tick, each as the bits of a float or an integer */
+enum TraceColumn
+{
+	TRACE_X, TRACE_Y, TRACE_Z,
+	TRACE_ROTATION_X, TRACE_ROTATION_Y, TRACE_ROTATION_Z, TRACE_ROTATION_W,
+	TRACE_GENERATION, TRACE_TAG,
+	traceColumns
+};
+
+/* TraceRecorder - streams every physics tick (the snapshot of every slot and the pairs that touched) to a
+   trace file; each value is stored as the XOR of its bits with the previous tick's, so a sleeping mover
+   costs a few bits, and runs of unchanged values are collapsed per chunk. The stepping thread only copies
+   the tick into a ring; a writer thread encodes and writes it */
+class TraceRecorder
+{
+public:
+	~TraceRecorder() { close(); }
+	// create the file and start the writer; false with a message if the file cannot be created
+	bool open(const char* path, size_t slots, float tick, const char* scenePath);
+	// stepping thread, after each tick: queue its state (waits only while the writer is a whole ring behind)
+	void record(const MoverArrays& movers, float time, unsigned long long tick);
+	// write what is queued, stop the writer and close the file
+	void close();
+	bool isOpen() const { return file != nullptr; }
+
+private:
+	struct TickState
+	{
+		TransformSnapshot snapshot;
+		MoverPairs contacts;
+	};
+	void writerLoop();
+	void encode(const TickState& state);
+	void flushChunk();
+
+	FILE* file = nullptr;
+	size_t slotCount = 0;
+	// ticks on their way to the writer, reused
+	std::vector<TickState> ring;
+	size_t ringFirst = 0;
+	size_t ringCount = 0;
+	bool closing = false;
+	std::mutex lock;
+	std::condition_variable filled;
+	std::condition_variable drained;
+	std::thread writer;
+	// writer thread only
+	std::vector<uint32_t> previous[traceColumns];
+	std::vector<uint32_t> column;
+	std::vector<unsigned char> chunk;
+	uint32_t chunkTicks = 0;
+	unsigned long long ticksWritten = 0;
+	unsigned long long bytesWritten = 0;
+};
+
+/* TraceReader - plays a trace back one tick at a time, reading a chunk from the file whenever it runs out */
+class TraceReader
+{
+public:
+	~TraceReader() { close(); }
+	// read the header; false with a message if the file is missing or is not a trace
+	bool open(const char* path);
+	// the next tick into snapshot (and its contacts), false at the end of the trace or on a damaged chunk
+	bool next(TransformSnapshot& snapshot, MoverPairs* contacts = nullptr);
+	void close();
+
+	size_t slots() const { return slotCount; }
+	float tick() const { return tickSeconds; }
+	const std::string& scene() const { return scenePath; }
+
+private:
+	bool readChunk();
+
+	FILE* file = nullptr;
+	size_t slotCount = 0;
+	float tickSeconds = 0.0f;
+	std::string scenePath;
+	std::vector<uint32_t> current[traceColumns];
+	std::vector<unsigned char> chunk;
+	size_t chunkOffset = 0;
+	uint32_t chunkTicksLeft = 0;
+};
+
+// print the length, size, compression and contact counts of a trace; false if it cannot be read
+bool printTraceSummary(const char* path);
+
+#endif
@@ -0,0 +1,262 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Packs the DDS textures used in the scene into a single texture array
+* so every object samples from the same binding and only the layer index
+* changes between draws. Reading the files needs no GL context and can run
+* on any thread; the upload streams every layer of a mip level through one
+* pixel buffer object so the copy to the GPU does not stall the caller.
+* 
+* References:
+* loadDDS() from Tutorial 9 Base Code from https://www.opengl-tutorial.org/
+*
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <string>
+
+// include GLEW
+#include <GL/glew.h>
+
+using namespace std;
+
+#include "texturearray.hpp"
+#include "jobsystem.hpp"
+
+#define FOURCC_DXT1 0x31545844 // Equivalent to "DXT1" in ASCII
+#define FOURCC_DXT3 0x33545844 // Equivalent to "DXT3" in ASCII
+#define FOURCC_DXT5 0x35545844 // Equivalent to "DXT5" in ASCII
+
+/* read the header and compressed data of one DDS file */
+bool readDDS(const char* imagepath, DDSImage& image)
+{
+	unsigned char header[124];
+
+	// try to open the file
+	FILE* fp = fopen(imagepath, "rb");
+	if (fp == NULL)
+	{
+		printf("%s could not be opened.\n", imagepath);
+		return false;
+	}
+
+	// verify the type of file
+	char filecode[4];
+	if (fread(filecode, 1, 4, fp) != 4 || strncmp(filecode, "DDS ", 4) != 0)
+	{
+		fclose(fp);
+		return false;
+	}
+
+	// get the surface desc
+	if (fread(&header, 124, 1, fp) != 1)
+	{
+		fclose(fp);
+		return false;
+	}
+
+	image.height = *(unsigned int*)&(header[8]);
+	image.width = *(unsigned int*)&(header[12]);
+	unsigned int linearSize = *(unsigned int*)&(header[16]);
+	image.mipMapCount = *(unsigned int*)&(header[24]);
+	unsigned int fourCC = *(unsigned int*)&(header[80]);
+
+	switch (fourCC)
+	{
+	case FOURCC_DXT1:
+		image.format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		break;
+	case FOURCC_DXT3:
+		image.format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+		break;
+	case FOURCC_DXT5:
+		image.format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		break;
+	default:
+		fclose(fp);
+		return false;
+	}
+	if (image.mipMapCount == 0)
+	{
+		image.mipMapCount = 1;
+	}
+
+	// how big is it going to be including all mipmaps?
+	unsigned int bufsize = image.mipMapCount > 1 ? linearSize * 2 : linearSize;
+	image.buffer.resize(bufsize);
+	size_t bytesRead = fread(image.buffer.data(), 1, bufsize, fp);
+	image.buffer.resize(bytesRead);
+
+	// close the file pointer
+	fclose(fp);
+	return true;
+} // end readDDS method
+
+/* load every image into its own layer of a 2D texture array */
+GLuint loadDDSArray(const vector<string>& imagepaths)
+{
+	// read every layer up front, one job per file
+	vector<DDSImage> images(imagepaths.size());
+	vector<unsigned char> valid(imagepaths.size());
+	jobs.parallelFor(imagepaths.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			valid[i] = readDDS(imagepaths[i].c_str(), images[i]);
+		}
+	});
+	for (size_t i = 0; i < imagepaths.size(); i++)
+	{
+		if (!valid[i])
+		{
+			printf("%s is not a valid DDS file.\n", imagepaths[i].c_str());
+			return 0;
+		}
+	}
+	return uploadDDSArray(images, imagepaths);
+} // end loadDDSArray method
+
+/* copy the images into a pixel buffer, level by level, and let GL pull each level of every layer from it */
+GLuint uploadDDSArray(const vector<DDSImage>& images, const vector<string>& imagepaths)
+{
+	if (images.empty())
+	{
+		return 0;
+	}
+
+	// every layer of an array shares one size and one format
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		if (images[i].width != images[0].width || images[i].height != images[0].height ||
+			images[i].format != images[0].format)
+		{
+			printf("%s does not match the size/format of %s, cannot share a texture array.\n",
+				imagepaths[i].c_str(), imagepaths[0].c_str());
+			return 0;
+		}
+	}
+
+	unsigned int format = images[0].format;
+	unsigned int blockSize = (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 8 : 16;
+	GLsizei layers = (GLsizei)images.size();
+
+	// only keep the mip levels every layer actually has, the pixel buffer holds them level by level
+	vector<unsigned int> levelSizes;
+	vector<size_t> levelOffsets;
+	unsigned int width = images[0].width;
+	unsigned int height = images[0].height;
+	unsigned int offset = 0;
+	size_t pixelBufferSize = 0;
+	for (unsigned int level = 0; level < images[0].mipMapCount && (width || height); ++level)
+	{
+		unsigned int size = ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+		bool complete = true;
+		for (const auto& image : images)
+		{
+			complete = complete && level < image.mipMapCount && offset + size <= image.buffer.size();
+		}
+		if (!complete)
+		{
+			break;
+		}
+		levelSizes.push_back(size);
+		levelOffsets.push_back(pixelBufferSize);
+		pixelBufferSize += (size_t)size * layers;
+		offset += size;
+		width /= 2;
+		height /= 2;
+
+		// deal with Non-Power-Of-Two textures
+		if (width < 1) width = 1;
+		if (height < 1) height = 1;
+	}
+	GLsizei levels = (GLsizei)levelSizes.size();
+	if (levels == 0)
+	{
+		printf("%s has no complete mip level.\n", imagepaths[0].c_str());
+		return 0;
+	}
+
+	// stage every layer of every level in one pixel buffer; a level's layers are contiguous, as GL expects
+	GLuint pixelBuffer;
+	glGenBuffers(1, &pixelBuffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, pixelBufferSize, NULL, GL_STREAM_DRAW);
+	unsigned char* staging = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, pixelBufferSize,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (staging == NULL)
+	{
+		printf("Could not map the pixel buffer for %s.\n", imagepaths[0].c_str());
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &pixelBuffer);
+		return 0;
+	}
+	offset = 0;
+	for (GLsizei level = 0; level < levels; level++)
+	{
+		for (GLsizei layer = 0; layer < layers; layer++)
+		{
+			memcpy(staging + levelOffsets[level] + (size_t)levelSizes[level] * layer,
+				images[layer].buffer.data() + offset, levelSizes[level]);
+		}
+		offset += levelSizes[level];
+	}
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	// create one OpenGL texture array with immutable storage, then fill each level of every layer from the pixel buffer
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, format, images[0].width, images[0].height, layers);
+	width = images[0].width;
+	height = images[0].height;
+	for (GLsizei level = 0; level < levels; level++)
+	{
+		glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, width, height, layers,
+			format, levelSizes[level] * layers, (void*)levelOffsets[level]);
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	// GL keeps the data it still has to copy, the buffer name can go now
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glDeleteBuffers(1, &pixelBuffer);
+
+	// trilinear filtering, same as loadDDS
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	return textureID;
+} // end uploadDDSArray method
+
+/* a tiny uncompressed array of flat grey layers */
+GLuint createPlaceholderArray(GLsizei layers)
+{
+	const GLsizei size = 4;
+	vector<unsigned char> texels(size * size * 4 * layers, 160);
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size, size, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	return textureID;
+} // end createPlaceholderArray method
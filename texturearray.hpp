@@ -0,0 +1,30 @@
+#ifndef TEXTUREARRAY_HPP
+#define TEXTUREARRAY_HPP
+
+#include <vector>
+#include <string>
+
+/* DDSImage - compressed mipmap chain of one DDS file */
+struct DDSImage
+{
+	unsigned int width;
+	unsigned int height;
+	unsigned int mipMapCount;
+	unsigned int format;
+	std::vector<unsigned char> buffer;
+};
+
+// read one DDS file into memory; makes no GL calls, so any thread may call it
+bool readDDS(const char* imagepath, DDSImage& image);
+
+// load several DDS images into the layers of one GL_TEXTURE_2D_ARRAY
+// (layer i holds imagepaths[i]); all images must share size and format
+GLuint loadDDSArray(const std::vector<std::string>& imagepaths);
+
+// the GL half of loadDDSArray(): upload images that were already read, through a pixel buffer object
+GLuint uploadDDSArray(const std::vector<DDSImage>& images, const std::vector<std::string>& imagepaths);
+
+// flat grey texture array to draw with until the real textures have been loaded
+GLuint createPlaceholderArray(GLsizei layers);
+
+#endif
@@ -0,0 +1,87 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Handoff of mover transforms from the physics thread to the render thread.
+* Three snapshot buffers rotate between the two threads: the physics thread
+* fills the back buffer and swaps it into the middle with a single atomic
+* exchange, the render thread swaps the middle out into its front buffer
+* when a new one is there. Neither side ever waits for the other.
+* 
+*/
+
+// include standard headers
+#include <vector>
+#include <atomic>
+
+// include GLM
+#include <glm/glm.hpp>
+
+using namespace glm;
+using namespace std;
+
+#include "transformsnapshots.hpp"
+#include "physics.hpp"
+
+/*
+***********************************************
+*		Snapshots
+***********************************************
+*/
+void captureSnapshot(const MoverArrays& movers, float time, unsigned long long tick, TransformSnapshot& snapshot)
+{
+	size_t count = movers.size();
+	snapshot.position.resize(count);
+	snapshot.rotation.resize(count);
+	snapshot.generation.resize(count);
+	snapshot.tag.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		snapshot.position[i] = movers.position(i);
+		// the pose of a slot can be replaced between ticks, so only the physics thread may read it
+		snapshot.rotation[i] = movers.worldRotation(i, movers.rotation(i));
+		snapshot.generation[i] = movers.active[i] ? movers.generation[i] : noGeneration;
+		snapshot.tag[i] = movers.tag[i];
+	}
+	snapshot.time = time;
+	snapshot.tick = tick;
+} // end captureSnapshot method
+
+/*
+***********************************************
+*		Triple Buffer
+***********************************************
+*/
+TransformTripleBuffer::TransformTripleBuffer()
+	: middle(1), backIndex(0), frontIndex(2)
+{
+} // end TransformTripleBuffer constructor
+
+void TransformTripleBuffer::publish()
+{
+	// release: the snapshot written into the back buffer is visible to whoever takes it out of the middle
+	unsigned int previous = middle.exchange(backIndex | freshBit, memory_order_acq_rel);
+	backIndex = previous & indexMask;
+} // end publish method
+
+const TransformSnapshot& TransformTripleBuffer::latest()
+{
+	// nothing new since the last call: keep drawing the current front buffer
+	if ((middle.load(memory_order_relaxed) & freshBit) == 0)
+	{
+		return buffers[frontIndex];
+	}
+	// acquire: pairs with the exchange in publish
+	unsigned int previous = middle.exchange(frontIndex, memory_order_acq_rel);
+	frontIndex = previous & indexMask;
+	return buffers[frontIndex];
+} // end latest method
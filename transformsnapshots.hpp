@@ -0,0 +1,52 @@
+#ifndef TRANSFORMSNAPSHOTS_HPP
+#define TRANSFORMSNAPSHOTS_HPP
+
+#include <vector>
+#include <atomic>
+
+#include <glm/gtc/quaternion.hpp>
+
+class MoverArrays;
+
+/* TransformSnapshot - what the renderer needs of every mover after one physics tick */
+struct TransformSnapshot
+{
+	std::vector<glm::vec3> position;
+	std::vector<glm::quat> rotation;			// world rotation, resolved on the physics thread
+	std::vector<unsigned int> generation;		// pool generation of each slot, noGeneration while it is free
+	std::vector<unsigned int> tag;				// the mover's tag (what it is a copy of)
+	float time = 0.0f;			// simulated time of the tick
+	unsigned long long tick = 0;	// ticks simulated so far
+};
+
+// generation of a slot with no live mover
+const unsigned int noGeneration = 0xFFFFFFFFu;
+
+// copy the renderable state of every mover into a snapshot (resizes it only when the mover count changes)
+void captureSnapshot(const MoverArrays& movers, float time, unsigned long long tick, TransformSnapshot& snapshot);
+
+/* TransformTripleBuffer - wait-free handoff of snapshots from one producer thread to one consumer thread */
+class TransformTripleBuffer
+{
+public:
+	TransformTripleBuffer();
+
+	// producer: the buffer to fill next, the consumer never looks at it
+	TransformSnapshot& back() { return buffers[backIndex]; }
+	// producer: swap the filled back buffer into the middle and take the old middle as the next back buffer
+	void publish();
+
+	// consumer: the newest published snapshot, valid until the next call
+	const TransformSnapshot& latest();
+
+private:
+	TransformSnapshot buffers[3];
+	// index of the middle buffer, with freshBit set while it holds a snapshot the consumer has not taken
+	std::atomic<unsigned int> middle;
+	unsigned int backIndex;		// owned by the producer
+	unsigned int frontIndex;	// owned by the consumer
+	static const unsigned int indexMask = 3;
+	static const unsigned int freshBit = 4;
+};
+
+#endif
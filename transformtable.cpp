@@ -0,0 +1,125 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Scene transforms. Every entity keeps a position and a quaternion and
+* its world matrix is cached; set() only marks an entity dirty when it
+* really moved, and update() rebuilds the dirty matrices depth by depth
+* on the job system. Static entities such as the trees are built once
+* when they are added and never touched again.
+* 
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <vector>
+
+// include GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+using namespace glm;
+using namespace std;
+
+#include "transformtable.hpp"
+#include "jobsystem.hpp"
+
+// world matrices rebuilt per job
+const size_t transformGrain = 256;
+
+/* rotation then translation, without going through translate() and rotate() */
+static inline mat4 localMatrix(const vec3& position, const quat& rotation)
+{
+	mat4 local = mat4_cast(rotation);
+	local[3] = vec4(position, 1.0f);
+	return local;
+} // end localMatrix method
+
+unsigned int TransformTable::add(const vec3& position, const quat& rotation, unsigned int parent)
+{
+	unsigned int i = (unsigned int)positions.size();
+	positions.push_back(position);
+	rotations.push_back(rotation);
+	parents.push_back(parent);
+	depths.push_back(parent == noParent ? 0 : depths[parent] + 1);
+	mat4 world = localMatrix(position, rotation);
+	worlds.push_back(parent == noParent ? world : worlds[parent] * world);
+	dirty.push_back(0);
+	return i;
+} // end add method
+
+void TransformTable::set(unsigned int i, const vec3& position, const quat& rotation)
+{
+	const quat& current = rotations[i];
+	if (positions[i] == position && current.w == rotation.w && current.x == rotation.x &&
+		current.y == rotation.y && current.z == rotation.z)
+	{
+		return;
+	}
+	positions[i] = position;
+	rotations[i] = rotation;
+	dirty[i] = 1;
+	anyDirty = true;
+} // end set method
+
+void TransformTable::update()
+{
+	rebuilt = 0;
+	if (!anyDirty)
+	{
+		return;
+	}
+	anyDirty = false;
+
+	// children come after their parents, so one forward pass hands a parent's change down the tree
+	for (auto& level : dirtyByDepth)
+	{
+		level.clear();
+	}
+	for (unsigned int i = 0; i < positions.size(); i++)
+	{
+		if (parents[i] != noParent && dirty[parents[i]])
+		{
+			dirty[i] = 1;
+		}
+		if (dirty[i])
+		{
+			if (depths[i] >= dirtyByDepth.size())
+			{
+				dirtyByDepth.resize(depths[i] + 1);
+			}
+			dirtyByDepth[depths[i]].push_back(i);
+		}
+	}
+
+	// a level only reads the level above it, which is finished by then
+	for (const auto& level : dirtyByDepth)
+	{
+		jobs.parallelFor(level.size(), transformGrain, [&](size_t begin, size_t end)
+		{
+			for (size_t k = begin; k < end; k++)
+			{
+				unsigned int i = level[k];
+				mat4 local = localMatrix(positions[i], rotations[i]);
+				worlds[i] = parents[i] == noParent ? local : worlds[parents[i]] * local;
+			}
+		});
+		rebuilt += level.size();
+	}
+	for (const auto& level : dirtyByDepth)
+	{
+		for (unsigned int i : level)
+		{
+			dirty[i] = 0;
+		}
+	}
+} // end update method
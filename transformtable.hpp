@@ -0,0 +1,39 @@
+#ifndef TRANSFORMTABLE_HPP
+#define TRANSFORMTABLE_HPP
+
+#include <vector>
+
+#include <glm/gtc/quaternion.hpp>
+
+/* TransformTable - position and rotation of every scene entity relative to an optional parent, with the
+   world matrix of each cached; a matrix is rebuilt only when the entity or one of its ancestors moved */
+class TransformTable
+{
+public:
+	static const unsigned int noParent = 0xFFFFFFFFu;
+
+	// append an entity, parents must be added before their children; returns its index
+	unsigned int add(const glm::vec3& position, const glm::quat& rotation, unsigned int parent = noParent);
+	// move an entity, it is only marked dirty when the position or rotation actually changed
+	void set(unsigned int i, const glm::vec3& position, const glm::quat& rotation);
+	// rebuild the world matrix of every dirty entity and its descendants, one parallel pass per depth
+	void update();
+
+	const glm::mat4& world(unsigned int i) const { return worlds[i]; }
+	size_t size() const { return positions.size(); }
+	// world matrices rebuilt by the last update()
+	size_t rebuiltCount() const { return rebuilt; }
+
+private:
+	std::vector<glm::vec3> positions;
+	std::vector<glm::quat> rotations;
+	std::vector<unsigned int> parents;
+	std::vector<unsigned int> depths;
+	std::vector<glm::mat4> worlds;
+	std::vector<unsigned char> dirty;
+	std::vector<std::vector<unsigned int>> dirtyByDepth;	// scratch of update()
+	bool anyDirty = false;
+	size_t rebuilt = 0;
+};
+
+#endif
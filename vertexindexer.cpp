@@ -0,0 +1,299 @@
+/*
+*************************************************************************
+* 							 FINAL PROJECT
+*************************************************************************
+*
+* Author: Elisa Miller
+* Class : ECE 4122
+* Date : 12/05/2023
+*
+* 3D Animated Scene with 
+* Custom Classes, Mulithreading, & OpenGL
+* 
+* Description:
+* Vertex deduplication for the triangle soup read from an .obj file.
+* indexVBO looks every corner up in a std::map; here a linear-probing
+* hash table keyed on the raw bits of the vertex does the same in O(n).
+* The parallel version buckets the corners by the shard their hash falls
+* in and gives every job one bucket, so no table is shared, then numbers the distinct vertices
+* in first-seen order with a prefix sum, which reproduces the serial
+* numbering exactly.
+* 
+* References:
+* indexVBO() from Tutorial 9 Base Code from https://www.opengl-tutorial.org/
+*
+*/
+
+// include standard headers
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// include GLM
+#include <glm/glm.hpp>
+
+using namespace glm;
+using namespace std;
+
+#include "vertexindexer.hpp"
+#include "jobsystem.hpp"
+
+static_assert(sizeof(PackedVertex) == 8 * sizeof(float), "PackedVertex must not have padding, it is compared bit for bit");
+
+// marks an unused table slot
+const uint32_t emptySlot = 0xFFFFFFFFu;
+// below this many corners the parallel version is not worth its extra passes
+const size_t parallelIndexMinimum = 65536;
+// corners per job in the hashing and numbering passes
+const size_t indexGrain = 16384;
+
+/*
+***********************************************
+*		Hash Table
+***********************************************
+*/
+uint32_t hashVertex(const PackedVertex& vertex)
+{
+	uint32_t words[8];
+	memcpy(words, &vertex, sizeof(words));
+	uint64_t hash = 0x9E3779B97F4A7C15ull;
+	for (int k = 0; k < 8; k++)
+	{
+		hash = (hash ^ words[k]) * 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 32;
+	}
+	return static_cast<uint32_t>(hash);
+} // end hashVertex method
+
+static inline PackedVertex packVertex(const vector<vec3>& vertices, const vector<vec2>& uvs, const vector<vec3>& normals, size_t i)
+{
+	PackedVertex packed;
+	packed.position = vertices[i];
+	packed.uv = uvs[i];
+	packed.normal = normals[i];
+	return packed;
+} // end packVertex method
+
+VertexTable::VertexTable(size_t expected)
+{
+	// load factor at most 1/2
+	size_t capacity = 16;
+	while (capacity < expected * 2)
+	{
+		capacity *= 2;
+	}
+	slots.assign(capacity, Slot{ 0, emptySlot });
+	mask = capacity - 1;
+	keys.reserve(expected);
+} // end VertexTable constructor
+
+uint32_t VertexTable::findOrInsert(const PackedVertex& vertex, uint32_t hash)
+{
+	if ((keys.size() + 1) * 2 > slots.size())
+	{
+		grow();
+	}
+	for (size_t slot = hash & mask;; slot = (slot + 1) & mask)
+	{
+		Slot& entry = slots[slot];
+		if (entry.key == emptySlot)
+		{
+			entry.hash = hash;
+			entry.key = static_cast<uint32_t>(keys.size());
+			keys.push_back(vertex);
+			return entry.key;
+		}
+		if (entry.hash == hash && memcmp(&keys[entry.key], &vertex, sizeof(PackedVertex)) == 0)
+		{
+			return entry.key;
+		}
+	}
+} // end findOrInsert method
+
+void VertexTable::grow()
+{
+	vector<Slot> old(slots.size() * 2, Slot{ 0, emptySlot });
+	old.swap(slots);
+	mask = slots.size() - 1;
+	for (const Slot& entry : old)
+	{
+		if (entry.key != emptySlot)
+		{
+			size_t slot = entry.hash & mask;
+			while (slots[slot].key != emptySlot)
+			{
+				slot = (slot + 1) & mask;
+			}
+			slots[slot] = entry;
+		}
+	}
+} // end grow method
+
+
+/*
+***********************************************
+*		Indexing
+***********************************************
+*/
+void indexVertices(const vector<vec3>& in_vertices, const vector<vec2>& in_uvs, const vector<vec3>& in_normals,
+	vector<unsigned short>& out_indices, vector<vec3>& out_vertices, vector<vec2>& out_uvs, vector<vec3>& out_normals)
+{
+	size_t count = in_vertices.size();
+	size_t base = out_vertices.size();
+	// smooth meshes share each vertex between about six corners
+	VertexTable table(count / 4);
+	out_indices.reserve(out_indices.size() + count);
+	for (size_t i = 0; i < count; i++)
+	{
+		PackedVertex packed = packVertex(in_vertices, in_uvs, in_normals, i);
+		uint32_t unique = table.findOrInsert(packed, hashVertex(packed));
+		if (unique == out_vertices.size() - base)
+		{
+			out_vertices.push_back(packed.position);
+			out_uvs.push_back(packed.uv);
+			out_normals.push_back(packed.normal);
+		}
+		// indexVBO stores 16-bit indices, meshes past 65536 vertices wrap the same way it does
+		out_indices.push_back(static_cast<unsigned short>(base + unique));
+	}
+} // end indexVertices method
+
+void indexVerticesParallel(const vector<vec3>& in_vertices, const vector<vec2>& in_uvs, const vector<vec3>& in_normals,
+	vector<unsigned short>& out_indices, vector<vec3>& out_vertices, vector<vec2>& out_uvs, vector<vec3>& out_normals)
+{
+	size_t count = in_vertices.size();
+	if (jobs.workerCount() == 0 || count < parallelIndexMinimum)
+	{
+		indexVertices(in_vertices, in_uvs, in_normals, out_indices, out_vertices, out_uvs, out_normals);
+		return;
+	}
+
+	// hash every corner
+	vector<uint32_t> hashes(count);
+	jobs.parallelFor(count, indexGrain, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			hashes[i] = hashVertex(packVertex(in_vertices, in_uvs, in_normals, i));
+		}
+	});
+
+	/* bucket the corners by shard (the top bits of their hash): count per block and shard, prefix sum
+	   shard by shard, then scatter; blocks are laid out in order, so every shard's list is ascending */
+	size_t shardCount = (jobs.workerCount() + 1) * 2;
+	size_t blockCount = (count + indexGrain - 1) / indexGrain;
+	auto shardOf = [&](size_t i) { return (size_t)((static_cast<uint64_t>(hashes[i]) * shardCount) >> 32); };
+	vector<uint32_t> bucketStart(blockCount * shardCount, 0);
+	jobs.parallelFor(blockCount, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t block = begin; block < end; block++)
+		{
+			uint32_t* blockCounts = &bucketStart[block * shardCount];
+			for (size_t i = block * indexGrain; i < std::min(count, (block + 1) * indexGrain); i++)
+			{
+				blockCounts[shardOf(i)]++;
+			}
+		}
+	});
+	vector<uint32_t> shardStart(shardCount + 1, 0);
+	uint32_t bucketed = 0;
+	for (size_t shard = 0; shard < shardCount; shard++)
+	{
+		shardStart[shard] = bucketed;
+		for (size_t block = 0; block < blockCount; block++)
+		{
+			uint32_t blockCorners = bucketStart[block * shardCount + shard];
+			bucketStart[block * shardCount + shard] = bucketed;
+			bucketed += blockCorners;
+		}
+	}
+	shardStart[shardCount] = bucketed;
+	vector<uint32_t> shardCorners(count);
+	jobs.parallelFor(blockCount, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t block = begin; block < end; block++)
+		{
+			uint32_t* next = &bucketStart[block * shardCount];
+			for (size_t i = block * indexGrain; i < std::min(count, (block + 1) * indexGrain); i++)
+			{
+				shardCorners[next[shardOf(i)]++] = static_cast<uint32_t>(i);
+			}
+		}
+	});
+
+	/* each shard walks only its own corners, in order, so it finds the first corner of each of its
+	   distinct vertices; the table slot comes from the low bits, independent of the shard */
+	vector<uint32_t> first(count);
+	jobs.parallelFor(shardCount, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t shard = begin; shard < end; shard++)
+		{
+			VertexTable table((shardStart[shard + 1] - shardStart[shard]) / 4);
+			vector<uint32_t> firstCorner;
+			for (uint32_t c = shardStart[shard]; c < shardStart[shard + 1]; c++)
+			{
+				uint32_t i = shardCorners[c];
+				uint32_t unique = table.findOrInsert(packVertex(in_vertices, in_uvs, in_normals, i), hashes[i]);
+				if (unique == firstCorner.size())
+				{
+					firstCorner.push_back(i);
+				}
+				first[i] = firstCorner[unique];
+			}
+		}
+	});
+
+	// number the first corners in order: count per block, prefix sum, then number within each block
+	vector<uint32_t> blockStart(blockCount + 1, 0);
+	jobs.parallelFor(blockCount, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t block = begin; block < end; block++)
+		{
+			uint32_t distinct = 0;
+			for (size_t i = block * indexGrain; i < std::min(count, (block + 1) * indexGrain); i++)
+			{
+				distinct += first[i] == i;
+			}
+			blockStart[block + 1] = distinct;
+		}
+	});
+	for (size_t block = 0; block < blockCount; block++)
+	{
+		blockStart[block + 1] += blockStart[block];
+	}
+
+	size_t base = out_vertices.size();
+	size_t indexBase = out_indices.size();
+	out_vertices.resize(base + blockStart[blockCount]);
+	out_uvs.resize(base + blockStart[blockCount]);
+	out_normals.resize(base + blockStart[blockCount]);
+	out_indices.resize(indexBase + count);
+	vector<uint32_t> number(count);
+	jobs.parallelFor(blockCount, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t block = begin; block < end; block++)
+		{
+			uint32_t unique = blockStart[block];
+			for (size_t i = block * indexGrain; i < std::min(count, (block + 1) * indexGrain); i++)
+			{
+				if (first[i] == i)
+				{
+					number[i] = unique;
+					out_vertices[base + unique] = in_vertices[i];
+					out_uvs[base + unique] = in_uvs[i];
+					out_normals[base + unique] = in_normals[i];
+					unique++;
+				}
+			}
+		}
+	});
+
+	// a repeat takes the number of its first corner, which may sit in an earlier block
+	jobs.parallelFor(count, indexGrain, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			out_indices[indexBase + i] = static_cast<unsigned short>(base + number[first[i]]);
+		}
+	});
+} // end indexVerticesParallel method
@@ -0,0 +1,51 @@
+#ifndef VERTEXINDEXER_HPP
+#define VERTEXINDEXER_HPP
+
+#include <vector>
+#include <stdint.h>
+
+/* PackedVertex - one (position, uv, normal) triple, compared bit for bit like indexVBO does */
+struct PackedVertex
+{
+	glm::vec3 position;
+	glm::vec2 uv;
+	glm::vec3 normal;
+};
+
+/* VertexTable - open-addressing hash table that numbers distinct vertices in the order they are first seen */
+class VertexTable
+{
+public:
+	explicit VertexTable(size_t expected = 0);
+	// number of the vertex, a new number (= size() before the call) when it has not been seen yet
+	uint32_t findOrInsert(const PackedVertex& vertex, uint32_t hash);
+	size_t size() const { return keys.size(); }
+
+private:
+	struct Slot
+	{
+		uint32_t hash;
+		uint32_t key;	// index into keys, emptySlot when unused
+	};
+	void grow();
+
+	std::vector<Slot> slots;
+	std::vector<PackedVertex> keys;
+	size_t mask;
+};
+
+uint32_t hashVertex(const PackedVertex& vertex);
+
+// drop-in replacement for indexVBO (common/vboindexer): appends the same indices and indexed
+// vertices, uvs and normals, but finds repeats with a hash table instead of a std::map
+void indexVertices(const std::vector<glm::vec3>& in_vertices, const std::vector<glm::vec2>& in_uvs,
+	const std::vector<glm::vec3>& in_normals, std::vector<unsigned short>& out_indices,
+	std::vector<glm::vec3>& out_vertices, std::vector<glm::vec2>& out_uvs, std::vector<glm::vec3>& out_normals);
+
+// same result as indexVertices, with the vertices split by hash over one table per job;
+// small meshes and a job system without workers take the serial path
+void indexVerticesParallel(const std::vector<glm::vec3>& in_vertices, const std::vector<glm::vec2>& in_uvs,
+	const std::vector<glm::vec3>& in_normals, std::vector<unsigned short>& out_indices,
+	std::vector<glm::vec3>& out_vertices, std::vector<glm::vec2>& out_uvs, std::vector<glm::vec3>& out_normals);
+
+#endif